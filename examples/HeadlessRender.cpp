@@ -0,0 +1,32 @@
+#include "Visualizer.hpp"
+#include "raylib.h"
+#include <iostream>
+
+// Renders a scene without a window and saves the last frame.
+// Fails if the camera placed with set_camera does not stay where it was put.
+int main(int argc, char **argv)
+{
+    const char *output = argc > 1 ? argv[1] : "headless_frame.png";
+
+    Visualizer visualizer(640, 480, "RoboVis headless", true);
+
+    // The box is object 0, the one the focus mode follows by default
+    visualizer.add_box({0.0f, 0.5f, 0.0f}, QuaternionIdentity(), RED, 1.0, 1.0, 1.0);
+    visualizer.add_sphere({3.0f, 1.0f, 0.0f}, QuaternionIdentity(), BLUE, 0.5);
+
+    Vector3 target = {3.0f, 1.0f, 0.0f};
+    visualizer.set_camera({8.0f, 5.0f, 8.0f}, target);
+    visualizer.step_frames(5);
+
+    Vector3 camera_target = visualizer.get_camera().target;
+    if (!Vector3Equals(camera_target, target))
+    {
+        std::cerr << "Camera target moved to (" << camera_target.x << ", " << camera_target.y << ", " << camera_target.z << ")" << std::endl;
+        return 1;
+    }
+
+    Image image = visualizer.get_frame_image();
+    bool exported = ExportImage(image, output);
+    UnloadImage(image);
+    return exported ? 0 : 1;
+}
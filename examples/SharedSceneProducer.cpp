@@ -0,0 +1,71 @@
+// Simulator side of the shared-memory feed: no raylib or ImGui, only SharedSceneFeed.
+// Run it together with SharedSceneViewer (in any order, the viewer waits until the feed exists).
+#include "SharedSceneFeed.hpp"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <thread>
+
+int main(int argc, char **argv)
+{
+    const char *feed_name = argc > 1 ? argv[1] : "/robovis";
+
+    scene_feed::FeedProducer producer;
+    if (!producer.create(feed_name))
+    {
+        std::printf("Failed to create the feed %s\n", feed_name);
+        return 1;
+    }
+
+    // Spawn a floor and a ring of bouncing balls
+    const int ball_count = 64;
+    const float identity[4] = {0.0f, 0.0f, 0.0f, 1.0f};
+    const float origin[3] = {0.0f, 0.0f, 0.0f};
+    const float floor_size[3] = {20.0f, 20.0f, 0.0f};
+    const uint8_t floor_color[4] = {80, 80, 80, 255};
+    producer.spawn(0, scene_feed::ShapeType::PLANE, origin, identity, floor_size, floor_color);
+
+    float heights[ball_count];
+    float velocities[ball_count];
+    for (int i = 0; i < ball_count; i++)
+    {
+        float angle = 2.0f * 3.14159265f * i / ball_count;
+        float position[3] = {6.0f * std::cos(angle), 1.0f + 0.1f * i, 6.0f * std::sin(angle)};
+        float size[3] = {0.3f, 0.3f, 0.3f}; // Radius of the spheres, edges of the boxes
+        uint8_t color[4] = {(uint8_t)(255 * i / ball_count), 120, (uint8_t)(255 - 255 * i / ball_count), 255};
+        producer.spawn(i + 1, i % 2 == 0 ? scene_feed::ShapeType::SPHERE : scene_feed::ShapeType::BOX, position, identity, size, color);
+        heights[i] = position[1];
+        velocities[i] = 0.0f;
+    }
+
+    // Step the simulation at 1 kHz and publish every step, the viewer only shows the latest frame
+    const float dt = 0.001f;
+    double time = 0.0;
+    std::chrono::steady_clock::time_point next_step = std::chrono::steady_clock::now();
+    while (time < 600.0)
+    {
+        producer.begin_frame(time);
+        for (int i = 0; i < ball_count; i++)
+        {
+            velocities[i] -= 9.81f * dt;
+            heights[i] += velocities[i] * dt;
+            if (heights[i] < 0.3f)
+            {
+                heights[i] = 0.3f;
+                velocities[i] = -velocities[i] * 0.95f;
+            }
+
+            float angle = 2.0f * 3.14159265f * i / ball_count + 0.2f * (float)time;
+            float position[3] = {6.0f * std::cos(angle), heights[i], 6.0f * std::sin(angle)};
+            float half_angle = 0.5f * (float)time * (1.0f + i % 5);
+            float orientation[4] = {0.0f, std::sin(half_angle), 0.0f, std::cos(half_angle)};
+            producer.add_pose(i + 1, position, orientation);
+        }
+        producer.publish();
+
+        time += dt;
+        next_step += std::chrono::microseconds(1000);
+        std::this_thread::sleep_until(next_step);
+    }
+    producer.close();
+}
@@ -0,0 +1,126 @@
+// Standalone viewer for a simulator publishing through the shared-memory feed (see SharedSceneProducer).
+#include "Visualizer.hpp"
+#include "SharedSceneFeed.hpp"
+#include "imgui.h"
+#include <unordered_map>
+
+namespace
+{
+    int spawn_object(Visualizer &visualizer, const scene_feed::Command &command)
+    {
+        Vector3 position = {command.position[0], command.position[1], command.position[2]};
+        Quaternion orientation = {command.orientation[0], command.orientation[1], command.orientation[2], command.orientation[3]};
+        Color color = {command.color[0], command.color[1], command.color[2], command.color[3]};
+        const float *size = command.size;
+        switch (command.shape)
+        {
+        case scene_feed::ShapeType::BOX:
+            return visualizer.add_box(position, orientation, color, size[0], size[1], size[2], command.group_id);
+        case scene_feed::ShapeType::SPHERE:
+            return visualizer.add_sphere(position, orientation, color, size[0], command.group_id);
+        case scene_feed::ShapeType::CYLINDER:
+            return visualizer.add_cylinder(position, orientation, color, size[0], size[1], command.group_id);
+        case scene_feed::ShapeType::CAPSULE:
+            return visualizer.add_capsule(position, orientation, color, size[0], size[1], command.group_id);
+        case scene_feed::ShapeType::CONE:
+            return visualizer.add_cone(position, orientation, color, size[0], size[1], command.group_id);
+        case scene_feed::ShapeType::PLANE:
+            return visualizer.add_plane(position, orientation, color, size[0], size[1], command.group_id);
+        case scene_feed::ShapeType::MESH:
+            return visualizer.add_mesh(command.mesh_path, position, orientation, color, size[0], size[1], size[2], command.group_id);
+        default:
+            return -1;
+        }
+    }
+}
+
+int main(int argc, char **argv)
+{
+    const char *feed_name = argc > 1 ? argv[1] : "/robovis";
+
+    Visualizer visualizer(1208, 720, "RoboVis - shared scene viewer");
+    visualizer.set_up_camera();
+
+    scene_feed::FeedConsumer consumer;
+    std::unordered_map<uint32_t, int> handles; // Producer object id -> visual object handle
+    std::vector<scene_feed::PackedPose> poses;
+    std::vector<int> pose_handles;
+    std::vector<Vector3> positions;
+    std::vector<Quaternion> orientations;
+    double feed_time = 0.0;
+    size_t frames_received = 0;
+
+    visualizer.set_imgui_interfaces([&]()
+                                    {
+        ImGui::Begin("Shared scene feed");
+        ImGui::Text("Feed: %s (%s)", feed_name, consumer.is_open() ? "connected" : "waiting for the producer");
+        ImGui::Text("Objects: %zu", handles.size());
+        ImGui::Text("Frames received: %zu, simulation time: %.3f s", frames_received, feed_time);
+        ImGui::End(); });
+
+    while (!WindowShouldClose())
+    {
+        // Connect (or reconnect after the producer restarted) without blocking the render loop
+        if (consumer.is_closed_by_producer())
+        {
+            consumer.close();
+        }
+        if (!consumer.is_open() && consumer.open(feed_name))
+        {
+            visualizer.clear_visual_objects();
+            handles.clear();
+        }
+
+        scene_feed::Command command;
+        while (consumer.pop_command(command))
+        {
+            auto it = handles.find(command.object_id);
+            switch (command.type)
+            {
+            case scene_feed::CommandType::SPAWN:
+                if (it != handles.end())
+                {
+                    visualizer.remove_visual_object(it->second);
+                }
+                handles[command.object_id] = spawn_object(visualizer, command);
+                break;
+            case scene_feed::CommandType::REMOVE:
+                if (it != handles.end())
+                {
+                    visualizer.remove_visual_object(it->second);
+                    handles.erase(it);
+                }
+                break;
+            case scene_feed::CommandType::CLEAR:
+                visualizer.clear_visual_objects();
+                handles.clear();
+                break;
+            }
+        }
+
+        if (consumer.read_latest_frame(poses, feed_time))
+        {
+            frames_received++;
+            pose_handles.clear();
+            positions.clear();
+            orientations.clear();
+            for (const scene_feed::PackedPose &pose : poses)
+            {
+                auto it = handles.find(pose.object_id);
+                if (it == handles.end())
+                {
+                    continue;
+                }
+                Quaternion orientation;
+                scene_feed::unpack_quaternion(pose.orientation, &orientation.x);
+                pose_handles.push_back(it->second);
+                positions.push_back(Vector3{pose.position[0], pose.position[1], pose.position[2]});
+                orientations.push_back(orientation);
+            }
+            visualizer.update_visual_objects_poses(pose_handles.data(), positions.data(), orientations.data(), pose_handles.size());
+        }
+
+        visualizer.update();
+    }
+    visualizer.close();
+}
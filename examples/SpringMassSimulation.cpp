@@ -35,7 +35,9 @@ int main() {
 
     Vector3 spring_pos  = Vector3Scale(Vector3Add(pos, ref_pos), 0.5f);
     // Now lets create a spring which will be a cylinder, the spring will be attached to the box and the reference point
-    uint spring_id = visualizer.add_cylinder(spring_pos, QuaternionIdentity(), GRAY, 0.2, 1.0f);
+    // Cylinders are created along the z axis, this orientation makes the spring vertical
+    Quaternion spring_orientation = QuaternionFromAxisAngle({1.0f, 0.0f, 0.0f}, -PI / 2);
+    uint spring_id = visualizer.add_cylinder(spring_pos, spring_orientation, GRAY, 0.2, 1.0f);
 
 
     // Simulation parameters
@@ -77,7 +79,7 @@ int main() {
         visualizer.draw_line({4.0, 1.0, -1.-0} , {5.0, 6.0, -2.0}, BLUE);
         // We need to update the position of the spring and its scale
         // The position of the spring is the average of the position of the mass and the reference point
-        spring_pos.y = pos.y; //(pos.y + ref_pos.y) / 2.0f;
+        spring_pos.y = (pos.y + ref_pos.y) / 2.0f;
         // The scale of the spring is the distance between the mass and the reference point
         float elongation_y = Vector3Distance(pos, ref_pos);
         float elongation_x = elongation_y / poison_ratio;
@@ -87,9 +89,10 @@ int main() {
         elongation_z = std::clamp(elongation_z, 0.0f, 2.0f);
         elongation_x = std::tanh(elongation_x);
         elongation_z = std::tanh(elongation_z);
-        Vector3 spring_scale = {elongation_x, elongation_y, elongation_z};
+        // The scale is applied in the cylinder frame, where the z axis is the axis of the spring
+        Vector3 spring_scale = {elongation_x, elongation_z, elongation_y};
         // Update the position and scale of the spring
-        visualizer.update_visual_object_position_orientation_scale(spring_id, spring_pos, QuaternionIdentity(), spring_scale);
+        visualizer.update_visual_object_position_orientation_scale(spring_id, spring_pos, spring_orientation, spring_scale);
 
         std::string text = std::to_string(F_d); 
         visualizer.modify_text_label(text_label, text);
@@ -0,0 +1,31 @@
+#version 330
+
+// Input vertex attributes (from vertex shader)
+in vec2 fragTexCoord;
+in vec2 fragBarycentric;
+in vec4 fragColor;
+
+// Input uniform values
+uniform sampler2D texture0;
+uniform vec4 colDiffuse;
+
+// Output fragment color
+out vec4 finalColor;
+
+// Returns 1 on the triangle edges and 0 inside, with lines about one pixel wide
+float edgeFactor()
+{
+    vec3 barycentric = vec3(fragBarycentric, 1.0 - fragBarycentric.x - fragBarycentric.y);
+    vec3 width = fwidth(barycentric);
+    vec3 edge = smoothstep(vec3(0.0), width, barycentric);
+    return 1.0 - min(min(edge.x, edge.y), edge.z);
+}
+
+void main()
+{
+    // Edges get the darker color the wireframe overlay used to be drawn with
+    vec4 diffuse = mix(colDiffuse, vec4(colDiffuse.rgb*0.7, 1.0), edgeFactor());
+    vec4 texelColor = texture(texture0, fragTexCoord);
+
+    finalColor = texelColor*diffuse*fragColor;
+}
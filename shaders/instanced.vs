@@ -0,0 +1,22 @@
+#version 330
+
+// Input vertex attributes
+in vec3 vertexPosition;
+
+// Input per-instance attributes
+in mat4 instanceTransform;
+in vec4 instanceColor;
+
+// Input uniform values
+uniform mat4 matViewProjection;
+
+// Output vertex attributes (to fragment shader)
+out vec4 fragColor;
+
+void main()
+{
+    fragColor = instanceColor;
+
+    // Calculate final vertex position
+    gl_Position = matViewProjection*instanceTransform*vec4(vertexPosition, 1.0);
+}
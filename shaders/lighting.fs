@@ -5,6 +5,10 @@ in vec3 fragPosition;
 in vec2 fragTexCoord;
 //in vec4 fragColor;
 in vec3 fragNormal;
+in vec4 fragShadowCoord;
+#ifdef EDGE_OVERLAY
+in vec2 fragBarycentric;
+#endif
 
 // Input uniform values
 uniform sampler2D texture0;
@@ -15,25 +19,112 @@ out vec4 finalColor;
 
 // NOTE: Add here your custom variables
 
-#define     MAX_LIGHTS              4
+// Must match SceneLights::MAX_LIGHTS, TILE_SIZE and TILE_SLOTS / 4
+#define     MAX_LIGHTS              64
+#define     LIGHT_TILE_SIZE         16
+#define     LIGHT_TILE_TEXELS       8
 #define     LIGHT_DIRECTIONAL       0
 #define     LIGHT_POINT             1
+#define     LIGHT_SPOT              2
 
 struct Light {
-    int enabled;
-    int type;
-    vec3 position;
-    vec3 target;
-    vec4 color;
+    vec4 position;  // xyz: position, w: type
+    vec4 direction; // xyz: direction of the rays, w: range
+    vec4 color;     // rgb: color multiplied by the intensity
+    vec4 cone;      // x: cosine of the inner angle, y: cosine of the outer angle (spot lights)
 };
 
+// Additional lights (see SceneLights), the directional ones are stored first
+layout(std140) uniform Lights {
+    Light lights[MAX_LIGHTS];
+    ivec4 lightCounts; // x: number of lights, y: number of directional lights
+};
+uniform int extraLightsEnabled;
+// Point and spot lights reaching every screen tile: light index + 1 per channel, 0 ends the list
+uniform sampler2D lightTiles;
+
 // Input lighting values
-uniform Light lights[MAX_LIGHTS];
+uniform vec3 mainLightDirection;
+uniform vec4 mainLightColor;
 uniform vec4 ambient;
 uniform vec3 viewPos;
 
+// Shadow maps of the main light (static and dynamic casters, see ShadowMap)
+uniform int shadowsEnabled;
+uniform sampler2D shadowStatic;
+uniform sampler2D shadowDynamic;
+uniform float shadowBias;
+uniform float shadowTexelSize;
+
+// Returns the lit fraction of the fragment (1 when outside the shadow maps), filtered over 3x3 texels
+float shadowFactor(float NdotL)
+{
+    vec3 coord = fragShadowCoord.xyz/fragShadowCoord.w*0.5 + 0.5;
+    if (coord.x <= 0.0 || coord.x >= 1.0 || coord.y <= 0.0 || coord.y >= 1.0 || coord.z >= 1.0) return 1.0;
+
+    // Surfaces at grazing angles need a larger bias to avoid acne
+    float bias = shadowBias*(1.0 + 4.0*(1.0 - NdotL));
+    float lit = 0.0;
+    for (int x = -1; x <= 1; x++)
+    {
+        for (int y = -1; y <= 1; y++)
+        {
+            vec2 offset = vec2(x, y)*shadowTexelSize;
+            // The nearest of the two maps composites the static and the dynamic casters
+            float depth = min(texture(shadowStatic, coord.xy + offset).r, texture(shadowDynamic, coord.xy + offset).r);
+            lit += (coord.z - bias > depth) ? 0.0 : 1.0;
+        }
+    }
+    return lit/9.0;
+}
+
+#ifdef EDGE_OVERLAY
+// Returns 1 on the triangle edges and 0 inside, with lines about one pixel wide
+float edgeFactor()
+{
+    vec3 barycentric = vec3(fragBarycentric, 1.0 - fragBarycentric.x - fragBarycentric.y);
+    vec3 width = fwidth(barycentric);
+    vec3 edge = smoothstep(vec3(0.0), width, barycentric);
+    return 1.0 - min(min(edge.x, edge.y), edge.z);
+}
+#endif
+
+// Adds the diffuse and specular contributions of a light
+void addLight(vec3 light, vec3 color, vec3 normal, vec3 viewD, inout vec3 lightDot, inout vec3 specular)
+{
+    float NdotL = max(dot(normal, light), 0.0);
+    lightDot += color*NdotL;
+    if (NdotL > 0.0) specular += color*pow(max(0.0, dot(viewD, reflect(-(light), normal))), 16.0); // 16 refers to shine
+}
+
+// Adds the contribution of a point or spot light, which fades out smoothly at its range
+void addLocalLight(int index, vec3 normal, vec3 viewD, inout vec3 lightDot, inout vec3 specular)
+{
+    vec3 toLight = lights[index].position.xyz - fragPosition;
+    float lightDistance = length(toLight);
+    float range = lights[index].direction.w;
+    if (lightDistance >= range) return;
+
+    vec3 light = toLight/lightDistance;
+    float falloff = clamp(1.0 - pow(lightDistance/range, 4.0), 0.0, 1.0);
+    float attenuation = falloff*falloff/(1.0 + lightDistance*lightDistance);
+    if (int(lights[index].position.w) == LIGHT_SPOT)
+    {
+        float cosAngle = dot(-light, normalize(lights[index].direction.xyz));
+        attenuation *= smoothstep(lights[index].cone.y, lights[index].cone.x, cosAngle);
+    }
+    addLight(light, lights[index].color.rgb*attenuation, normal, viewD, lightDot, specular);
+}
+
 void main()
 {
+#ifdef EDGE_OVERLAY
+    // Edges get the darker color the wireframe overlay used to be drawn with
+    vec4 diffuse = mix(colDiffuse, vec4(colDiffuse.rgb*0.7, 1.0), edgeFactor());
+#else
+    vec4 diffuse = colDiffuse;
+#endif
+
     // Texel color fetching from texture sampler
     vec4 texelColor = texture(texture0, fragTexCoord);
     vec3 lightDot = vec3(0.0);
@@ -41,35 +132,38 @@ void main()
     vec3 viewD = normalize(viewPos - fragPosition);
     vec3 specular = vec3(0.0);
 
-    // NOTE: Implement here your fragment shader code
+    // Main light, the only one casting shadows
+    vec3 light = -normalize(mainLightDirection);
+    float NdotL = max(dot(normal, light), 0.0);
+    float visibility = 1.0;
+    if (shadowsEnabled == 1 && NdotL > 0.0) visibility = shadowFactor(NdotL);
+    addLight(light, mainLightColor.rgb*visibility, normal, viewD, lightDot, specular);
 
-    for (int i = 0; i < MAX_LIGHTS; i++)
+    if (extraLightsEnabled == 1)
     {
-        if (lights[i].enabled == 1)
+        for (int i = 0; i < lightCounts.y; i++)
         {
-            vec3 light = vec3(0.0);
-
-            if (lights[i].type == LIGHT_DIRECTIONAL)
-            {
-                light = -normalize(lights[i].target - lights[i].position);
-            }
-
-            if (lights[i].type == LIGHT_POINT)
-            {
-                light = normalize(lights[i].position - fragPosition);
-            }
-
-            float NdotL = max(dot(normal, light), 0.0);
-            lightDot += lights[i].color.rgb*NdotL;
+            addLight(-normalize(lights[i].direction.xyz), lights[i].color.rgb, normal, viewD, lightDot, specular);
+        }
 
-            float specCo = 0.0;
-            if (NdotL > 0.0) specCo = pow(max(0.0, dot(viewD, reflect(-(light), normal))), 16.0); // 16 refers to shine
-            specular += specCo;
+        // Only the point and spot lights whose bounds cover the tile of the fragment
+        ivec2 tile = ivec2(gl_FragCoord.xy)/LIGHT_TILE_SIZE;
+        for (int t = 0; t < LIGHT_TILE_TEXELS; t++)
+        {
+            ivec4 indices = ivec4(texelFetch(lightTiles, ivec2(tile.x*LIGHT_TILE_TEXELS + t, tile.y), 0)*255.0 + 0.5);
+            if (indices.x == 0) break;
+            addLocalLight(indices.x - 1, normal, viewD, lightDot, specular);
+            if (indices.y == 0) break;
+            addLocalLight(indices.y - 1, normal, viewD, lightDot, specular);
+            if (indices.z == 0) break;
+            addLocalLight(indices.z - 1, normal, viewD, lightDot, specular);
+            if (indices.w == 0) break;
+            addLocalLight(indices.w - 1, normal, viewD, lightDot, specular);
         }
     }
 
-    finalColor = (texelColor*((colDiffuse + vec4(specular, 1.0))*vec4(lightDot, 1.0)));
-    finalColor += texelColor*(ambient/10.0)*colDiffuse;
+    finalColor = (texelColor*((diffuse + vec4(specular, 1.0))*vec4(lightDot, 1.0)));
+    finalColor += texelColor*(ambient/10.0)*diffuse;
 
     // Gamma correction
     finalColor = pow(finalColor, vec4(1.0/2.2));
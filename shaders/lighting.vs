@@ -5,17 +5,25 @@ in vec3 vertexPosition;
 in vec2 vertexTexCoord;
 in vec3 vertexNormal;
 in vec4 vertexColor;
+#ifdef EDGE_OVERLAY
+in vec2 vertexTexCoord2;
+#endif
 
 // Input uniform values
 uniform mat4 mvp;
 uniform mat4 matModel;
 uniform mat4 matNormal;
+uniform mat4 lightViewProj;
 
 // Output vertex attributes (to fragment shader)
 out vec3 fragPosition;
 out vec2 fragTexCoord;
 out vec4 fragColor;
 out vec3 fragNormal;
+out vec4 fragShadowCoord;
+#ifdef EDGE_OVERLAY
+out vec2 fragBarycentric;
+#endif
 
 // NOTE: Add here your custom variables
 
@@ -23,12 +31,14 @@ void main()
 {
     // Send vertex attributes to fragment shader
     fragPosition = vec3(matModel*vec4(vertexPosition, 1.0));
+    fragShadowCoord = lightViewProj*vec4(fragPosition, 1.0);
     fragTexCoord = vertexTexCoord;
     fragColor = vertexColor;
-    //fragNormal = normalize(vec3(matNormal*vec4(vertexNormal, 1.0)));
-
-    mat3 normalMatrix = transpose(inverse(mat3(matModel)));
-    fragNormal = normalize(normalMatrix*vertexNormal);
+#ifdef EDGE_OVERLAY
+    fragBarycentric = vertexTexCoord2;
+#endif
+    // The normal matrix is computed once per draw on the CPU (DrawMesh sets matNormal when the shader declares it)
+    fragNormal = normalize(mat3(matNormal)*vertexNormal);
 
     // Calculate final vertex position
     gl_Position = mvp*vec4(vertexPosition, 1.0);
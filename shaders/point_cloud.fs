@@ -0,0 +1,21 @@
+#version 330
+
+// Input vertex attributes (from vertex shader)
+in vec4 fragColor;
+
+// Input uniform values
+uniform int roundPoints;
+
+// Output fragment color
+out vec4 finalColor;
+
+void main()
+{
+    // Discard the corners of the point sprite to draw discs
+    if (roundPoints != 0)
+    {
+        vec2 offset = gl_PointCoord - vec2(0.5);
+        if (dot(offset, offset) > 0.25) discard;
+    }
+    finalColor = fragColor;
+}
@@ -0,0 +1,26 @@
+#version 330
+
+// Input vertex attributes
+in vec3 vertexPosition;
+in vec4 vertexColor;
+
+// Input uniform values
+uniform mat4 mvp;
+uniform float pointSize;
+uniform float pointScale; // 0 for sizes in pixels, otherwise pixels per world unit at a distance of 1
+
+// Output vertex attributes (to fragment shader)
+out vec4 fragColor;
+
+void main()
+{
+    fragColor = vertexColor;
+
+    // Calculate final vertex position
+    gl_Position = mvp*vec4(vertexPosition, 1.0);
+
+    // World sized points shrink with the distance (w is the view depth with a perspective projection)
+    float size = pointSize;
+    if (pointScale > 0.0) size = pointSize*pointScale/max(gl_Position.w, 1e-4);
+    gl_PointSize = max(size, 1.0);
+}
@@ -0,0 +1,6 @@
+#version 330
+
+// The shadow map framebuffers have no color attachment, the depth is written by the rasterizer
+void main()
+{
+}
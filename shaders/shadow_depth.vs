@@ -0,0 +1,13 @@
+#version 330
+
+// Input vertex attributes
+in vec3 vertexPosition;
+
+// Input uniform values
+uniform mat4 mvp;
+
+void main()
+{
+    // Only the depth of the casters is written to the shadow map
+    gl_Position = mvp*vec4(vertexPosition, 1.0);
+}
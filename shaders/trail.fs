@@ -0,0 +1,14 @@
+#version 330
+
+// Input vertex attributes (from vertex shader)
+in vec4 fragColor;
+
+// Output fragment color
+out vec4 finalColor;
+
+void main()
+{
+    // Fully faded samples must not write depth
+    if (fragColor.a <= 0.0) discard;
+    finalColor = fragColor;
+}
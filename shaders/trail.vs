@@ -0,0 +1,27 @@
+#version 330
+
+// Input vertex attributes
+in vec3 vertexPosition;
+in vec4 vertexColor;
+in vec2 vertexTiming; // Time of the sample and fade duration of its trail
+
+// Input uniform values
+uniform mat4 mvp;
+uniform float currentTime;
+
+// Output vertex attributes (to fragment shader)
+out vec4 fragColor;
+
+void main()
+{
+    // Samples fade out linearly with their age (a duration of 0 disables the fade)
+    float fade = 1.0;
+    if (vertexTiming.y > 0.0)
+    {
+        fade = clamp(1.0 - (currentTime - vertexTiming.x)/vertexTiming.y, 0.0, 1.0);
+    }
+    fragColor = vec4(vertexColor.rgb, vertexColor.a*fade);
+
+    // Calculate final vertex position
+    gl_Position = mvp*vec4(vertexPosition, 1.0);
+}
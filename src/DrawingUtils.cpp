@@ -1,4 +1,6 @@
 #include "DrawingUtils.hpp"
+#include <algorithm>
+#include <string>
 
 namespace du
 {
@@ -34,14 +36,60 @@ namespace du
 
     void draw_disc_section(Vector3 position, Vector3 axis, float radius, Color color)
     {
-        int n_segments = 32;                  // Number of segments for the disc
-        Vector3 points[4 * (n_segments + 1)]; // Adjusted size to include closing points
-        float angle_step = 2.0f * PI / n_segments;
+        draw_ring_section(position, axis, 0.0f, radius, 2.0f * PI, 0.0f, color);
+    }
 
-        // Normalize the axis to get the disc's orientation
-        Vector3 z_axis = Vector3Normalize(axis);
+    void draw_disc_section_2(Vector3 position, Vector3 axis, float radius, float angle_f, float angle_o, Color color)
+    {
+        draw_ring_section(position, axis, 0.0f, radius, angle_f, angle_o, color);
+    }
 
-        // Find two orthogonal vectors in the plane of the disc
+    void draw_ring_section(Vector3 position, Vector3 axis, float r_1, float r_2, float angle_f, float angle_o, Color color)
+    {
+        static std::vector<Vector3> triangles;
+        triangles.clear();
+        gen_ring_section_triangles(triangles, position, axis, r_1, r_2, angle_f, angle_o, 32);
+
+        // Both faces come from the same triangles: culling is disabled instead of emitting them twice
+        rlDrawRenderBatchActive();
+        rlDisableBackfaceCulling();
+        rlCheckRenderBatchLimit(triangles.size());
+        rlBegin(RL_TRIANGLES);
+        rlColor4ub(color.r, color.g, color.b, color.a);
+        for (const Vector3 &vertex : triangles)
+        {
+            rlVertex3f(vertex.x, vertex.y, vertex.z);
+        }
+        rlEnd();
+        rlDrawRenderBatchActive();
+        rlEnableBackfaceCulling();
+    }
+
+    const Vector2 *get_unit_circle(int segments)
+    {
+        static std::vector<std::vector<Vector2>> tables(MAX_CIRCLE_SEGMENTS + 1);
+        segments = std::clamp(segments, 3, MAX_CIRCLE_SEGMENTS);
+        std::vector<Vector2> &table = tables[segments];
+        if (table.empty())
+        {
+            table.resize(segments + 1);
+            for (int i = 0; i < segments; i++)
+            {
+                float angle = 2.0f * PI * i / segments;
+                table[i] = Vector2{cosf(angle), sinf(angle)};
+            }
+            table[segments] = table[0];
+        }
+        return table.data();
+    }
+
+    void gen_ring_section_triangles(std::vector<Vector3> &triangles, Vector3 position, Vector3 axis, float r_1, float r_2,
+                                    float angle_f, float angle_o, int segments)
+    {
+        segments = std::clamp(segments, 3, MAX_CIRCLE_SEGMENTS);
+
+        // Find two orthogonal vectors in the plane of the ring
+        Vector3 z_axis = Vector3Normalize(axis);
         Vector3 x_axis;
         if (fabs(z_axis.x) < 0.001f && fabs(z_axis.z) < 0.001f)
         {
@@ -51,142 +99,407 @@ namespace du
         {
             x_axis = Vector3Normalize(Vector3CrossProduct((Vector3){0, 1, 0}, z_axis)); // Perpendicular vector
         }
-        Vector3 y_axis = Vector3CrossProduct(z_axis, x_axis); // Second perpendicular vector in the disc's plane
-
-        // Generate points for the front and back faces, making a continuous strip
-        for (int i = 0; i <= n_segments; i++)
+        Vector3 y_axis = Vector3CrossProduct(z_axis, x_axis);
+
+        // Rotate the frame to the start angle, so the points only depend on the angle swept since angle_o
+        float cos_o = cosf(angle_o);
+        float sin_o = sinf(angle_o);
+        Vector3 u = Vector3Add(Vector3Scale(x_axis, cos_o), Vector3Scale(y_axis, sin_o));
+        Vector3 v = Vector3Subtract(Vector3Scale(y_axis, cos_o), Vector3Scale(x_axis, sin_o));
+
+        // Full turns read the unit circle table, partial sections rotate a unit vector by the angle step
+        float sweep = angle_f - angle_o;
+        bool full_turn = fabsf(fabsf(sweep) - 2.0f * PI) < 1e-4f;
+        const Vector2 *circle = full_turn ? get_unit_circle(segments) : nullptr;
+        float step = sweep / segments;
+        float cos_step = cosf(step);
+        float sin_step = sinf(step);
+        float direction = sweep < 0.0f ? -1.0f : 1.0f; // Sweep direction of the table points
+
+        Vector2 point = {1.0f, 0.0f};
+        auto ring_point = [&](const Vector2 &p, float radius)
         {
-            float angle = i * angle_step;
-            float x = cosf(angle) * radius;
-            float y = sinf(angle) * radius;
-
-            // Place the edge points in 3D space based on the disc orientation
-            Vector3 edge_point = Vector3Add(
-                Vector3Add(position, Vector3Scale(x_axis, x)), // Offset along x_axis
-                Vector3Scale(y_axis, y));                      // Offset along y_axis
+            return Vector3Add(position, Vector3Add(Vector3Scale(u, p.x * radius), Vector3Scale(v, p.y * radius)));
+        };
+        Vector3 inner = ring_point(point, r_1);
+        Vector3 outer = ring_point(point, r_2);
+        bool disc = r_1 == 0.0f || r_2 == 0.0f;
+        triangles.reserve(triangles.size() + segments * (disc ? 3 : 6));
+        for (int i = 1; i <= segments; i++)
+        {
+            point = full_turn ? Vector2{circle[i].x, circle[i].y * direction} : Vector2{point.x * cos_step - point.y * sin_step, point.x * sin_step + point.y * cos_step};
+            Vector3 next_inner = ring_point(point, r_1);
+            Vector3 next_outer = ring_point(point, r_2);
+            if (disc)
+            {
+                triangles.insert(triangles.end(), {position, r_1 == 0.0f ? outer : inner, r_1 == 0.0f ? next_outer : next_inner});
+            }
+            else
+            {
+                triangles.insert(triangles.end(), {inner, outer, next_outer, inner, next_outer, next_inner});
+            }
+            inner = next_inner;
+            outer = next_outer;
+        }
+    }
 
-            // Front face (counter-clockwise winding)
-            points[2 * i] = edge_point;   // Edge point for the front face
-            points[2 * i + 1] = position; // Center point for the front face
+    Matrix get_transform(const Vector3 &v, const Quaternion &q)
+    {
+        // Build the rotation straight from the quaternion (no axis-angle round trip)
+        Matrix transform = QuaternionToMatrix(QuaternionNormalize(q));
+        transform.m12 = v.x;
+        transform.m13 = v.y;
+        transform.m14 = v.z;
+        return transform;
+    }
 
-            // Back face (clockwise winding to flip normal)
-            points[2 * (n_segments + 1) + 2 * i] = position;       // Center point for the back face
-            points[2 * (n_segments + 1) + 2 * i + 1] = edge_point; // Edge point for the back face
+    void draw_model(const Model &model, const Matrix &transform, Color tint)
+    {
+        for (int i = 0; i < model.meshCount; i++)
+        {
+            Material &material = model.materials[model.meshMaterial[i]];
+            Color color = material.maps[MATERIAL_MAP_DIFFUSE].color;
+            Color color_tint = {
+                (unsigned char)(((int)color.r * (int)tint.r) / 255),
+                (unsigned char)(((int)color.g * (int)tint.g) / 255),
+                (unsigned char)(((int)color.b * (int)tint.b) / 255),
+                (unsigned char)(((int)color.a * (int)tint.a) / 255)};
+
+            material.maps[MATERIAL_MAP_DIFFUSE].color = color_tint;
+            DrawMesh(model.meshes[i], material, transform);
+            material.maps[MATERIAL_MAP_DIFFUSE].color = color;
         }
-
-        // Draw the full strip (both faces)
-        DrawTriangleStrip3D(points, 4 * (n_segments + 1), color);
     }
 
-    void draw_disc_section_2(Vector3 position, Vector3 axis, float radius, float angle_f, float angle_o, Color color)
+    void draw_model_edges(const Model &model, const Mesh *edge_meshes, const Matrix &transform, Color tint, const Shader &edge_shader)
     {
-        int n_segments = 32;                  // Number of segments for the disc
-        Vector3 points[4 * (n_segments + 1)]; // Adjusted size to include closing points
-        float angle_step = (angle_f - angle_o) / n_segments;
+        // Same as draw_model, with the shader of the materials swapped for the edge shader
+        for (int i = 0; i < model.meshCount; i++)
+        {
+            Material &material = model.materials[model.meshMaterial[i]];
+            Color color = material.maps[MATERIAL_MAP_DIFFUSE].color;
+            Shader shader = material.shader;
+            Color color_tint = {
+                (unsigned char)(((int)color.r * (int)tint.r) / 255),
+                (unsigned char)(((int)color.g * (int)tint.g) / 255),
+                (unsigned char)(((int)color.b * (int)tint.b) / 255),
+                (unsigned char)(((int)color.a * (int)tint.a) / 255)};
+
+            material.maps[MATERIAL_MAP_DIFFUSE].color = color_tint;
+            material.shader = edge_shader;
+            DrawMesh(edge_meshes[i], material, transform);
+            material.maps[MATERIAL_MAP_DIFFUSE].color = color;
+            material.shader = shader;
+        }
+    }
 
-        // Normalize the axis to get the disc's orientation
-        Vector3 z_axis = Vector3Normalize(axis);
+    Mesh gen_mesh_barycentric(const Mesh &mesh)
+    {
+        Mesh edge_mesh = {0};
+        edge_mesh.triangleCount = mesh.triangleCount;
+        edge_mesh.vertexCount = mesh.triangleCount * 3;
+        if (mesh.vertices == nullptr)
+        {
+            return edge_mesh;
+        }
 
-        // Find two orthogonal vectors in the plane of the disc
-        Vector3 x_axis;
-        if (fabs(z_axis.x) < 0.001f && fabs(z_axis.z) < 0.001f)
+        edge_mesh.vertices = (float *)MemAlloc(edge_mesh.vertexCount * 3 * sizeof(float));
+        edge_mesh.texcoords2 = (float *)MemAlloc(edge_mesh.vertexCount * 2 * sizeof(float));
+        if (mesh.texcoords != nullptr)
         {
-            x_axis = (Vector3){1, 0, 0}; // Handle the special case when z_axis is close to the y-axis
+            edge_mesh.texcoords = (float *)MemAlloc(edge_mesh.vertexCount * 2 * sizeof(float));
         }
-        else
+        if (mesh.normals != nullptr)
         {
-            x_axis = Vector3Normalize(Vector3CrossProduct((Vector3){0, 1, 0}, z_axis)); // Perpendicular vector
+            edge_mesh.normals = (float *)MemAlloc(edge_mesh.vertexCount * 3 * sizeof(float));
         }
-        Vector3 y_axis = Vector3CrossProduct(z_axis, x_axis); // Second perpendicular vector in the disc's plane
+        if (mesh.colors != nullptr)
+        {
+            edge_mesh.colors = (unsigned char *)MemAlloc(edge_mesh.vertexCount * 4 * sizeof(unsigned char));
+        }
+
+        const float corners[3][2] = {{1.0f, 0.0f}, {0.0f, 1.0f}, {0.0f, 0.0f}};
+        for (int i = 0; i < edge_mesh.vertexCount; i++)
+        {
+            int vertex = mesh.indices != nullptr ? mesh.indices[i] : i;
+            for (int j = 0; j < 3; j++)
+            {
+                edge_mesh.vertices[i * 3 + j] = mesh.vertices[vertex * 3 + j];
+                if (edge_mesh.normals != nullptr)
+                {
+                    edge_mesh.normals[i * 3 + j] = mesh.normals[vertex * 3 + j];
+                }
+            }
+            for (int j = 0; j < 2; j++)
+            {
+                edge_mesh.texcoords2[i * 2 + j] = corners[i % 3][j];
+                if (edge_mesh.texcoords != nullptr)
+                {
+                    edge_mesh.texcoords[i * 2 + j] = mesh.texcoords[vertex * 2 + j];
+                }
+            }
+            for (int j = 0; j < 4 && edge_mesh.colors != nullptr; j++)
+            {
+                edge_mesh.colors[i * 4 + j] = mesh.colors[vertex * 4 + j];
+            }
+        }
+
+        UploadMesh(&edge_mesh, false);
+        return edge_mesh;
+    }
 
-        // Generate points for the front and back faces, making a continuous strip
-        for (int i = 0; i <= n_segments; i++)
+    Shader load_shader_with_defines(const char *vs_path, const char *fs_path, const char *defines)
+    {
+        char *vs_code = LoadFileText(vs_path);
+        char *fs_code = LoadFileText(fs_path);
+        if (vs_code == nullptr || fs_code == nullptr)
         {
-            float angle = i * angle_step + angle_o;
-            float x = cosf(angle) * radius;
-            float y = sinf(angle) * radius;
+            UnloadFileText(vs_code);
+            UnloadFileText(fs_code);
+            return LoadShaderFromMemory(nullptr, nullptr);
+        }
 
-            // Place the edge points in 3D space based on the disc orientation
-            Vector3 edge_point = Vector3Add(
-                Vector3Add(position, Vector3Scale(x_axis, x)), // Offset along x_axis
-                Vector3Scale(y_axis, y));                      // Offset along y_axis
+        // The #version directive has to stay the first line
+        auto insert_defines = [defines](const char *code) -> std::string
+        {
+            std::string source = code;
+            size_t line_end = source.find('\n');
+            source.insert(line_end == std::string::npos ? source.size() : line_end + 1, defines);
+            return source;
+        };
+        std::string vs_source = insert_defines(vs_code);
+        std::string fs_source = insert_defines(fs_code);
+        UnloadFileText(vs_code);
+        UnloadFileText(fs_code);
+
+        return LoadShaderFromMemory(vs_source.c_str(), fs_source.c_str());
+    }
 
-            // Front face (counter-clockwise winding)
-            points[2 * i] = edge_point;   // Edge point for the front face
-            points[2 * i + 1] = position; // Center point for the front face
+    void draw_model_wires(const Model &model, const Matrix &transform, Color tint)
+    {
+        rlEnableWireMode();
+        draw_model(model, transform, tint);
+        rlDisableWireMode();
+    }
 
-            // Back face (clockwise winding to flip normal)            
-            points[4 * (n_segments + 1) - 2 * (i + 1)] = position;     // Inner radius point for the back face (clockwise)
-            points[4 * (n_segments + 1) - 2 * (i + 1) + 1] = edge_point; // Outer radius point for the back face (clockwis
+    Matrix get_rotation_from_y_axis(Vector3 direction)
+    {
+        float length = Vector3Length(direction);
+        if (length < 1e-6f)
+        {
+            return MatrixIdentity();
         }
+        direction = Vector3Scale(direction, 1.0f / length);
 
-        // Draw the full strip (both faces)
-        DrawTriangleStrip3D(points, 4 * (n_segments + 1), color);
+        // QuaternionFromVector3ToVector3 degenerates for opposite vectors
+        if (direction.y < -0.9999f)
+        {
+            return MatrixRotateX(PI);
+        }
+        return QuaternionToMatrix(QuaternionFromVector3ToVector3((Vector3){0.0f, 1.0f, 0.0f}, direction));
     }
 
-    void draw_ring_section(Vector3 position, Vector3 axis, float r_1, float r_2, float angle_f, float angle_o, Color color)
+    Matrix get_segment_transform(Vector3 p_1, Vector3 p_2, float radius)
     {
-        int n_segments = 32;                  // Number of segments for the disc
-        Vector3 points[4 * (n_segments + 1)]; // Adjusted size to include closing points
-        float angle_step = (angle_f - angle_o) / n_segments;
+        Vector3 direction = Vector3Subtract(p_2, p_1);
+        Matrix scale = MatrixScale(radius, Vector3Length(direction), radius);
+        Matrix rotation = get_rotation_from_y_axis(direction);
+        return MatrixMultiply(MatrixMultiply(scale, rotation), MatrixTranslate(p_1.x, p_1.y, p_1.z));
+    }
 
-        // Normalize the axis to get the disc's orientation
-        Vector3 z_axis = Vector3Normalize(axis);
+    Frustum get_frustum(const Matrix &view_projection)
+    {
+        const Matrix &m = view_projection;
+        // Rows of the matrix that maps world coordinates to clip coordinates
+        Vector4 row_0 = {m.m0, m.m4, m.m8, m.m12};
+        Vector4 row_1 = {m.m1, m.m5, m.m9, m.m13};
+        Vector4 row_2 = {m.m2, m.m6, m.m10, m.m14};
+        Vector4 row_3 = {m.m3, m.m7, m.m11, m.m15};
+
+        Frustum frustum = {{
+            {row_3.x + row_0.x, row_3.y + row_0.y, row_3.z + row_0.z, row_3.w + row_0.w}, // Left
+            {row_3.x - row_0.x, row_3.y - row_0.y, row_3.z - row_0.z, row_3.w - row_0.w}, // Right
+            {row_3.x + row_1.x, row_3.y + row_1.y, row_3.z + row_1.z, row_3.w + row_1.w}, // Bottom
+            {row_3.x - row_1.x, row_3.y - row_1.y, row_3.z - row_1.z, row_3.w - row_1.w}, // Top
+            {row_3.x + row_2.x, row_3.y + row_2.y, row_3.z + row_2.z, row_3.w + row_2.w}, // Near
+            {row_3.x - row_2.x, row_3.y - row_2.y, row_3.z - row_2.z, row_3.w - row_2.w}, // Far
+        }};
+
+        for (Vector4 &plane : frustum.planes)
+        {
+            float length = sqrtf(plane.x * plane.x + plane.y * plane.y + plane.z * plane.z);
+            if (length > 0.0f)
+            {
+                plane = {plane.x / length, plane.y / length, plane.z / length, plane.w / length};
+            }
+        }
+        return frustum;
+    }
 
-        // Find two orthogonal vectors in the plane of the disc
-        Vector3 x_axis;
-        if (fabs(z_axis.x) < 0.001f && fabs(z_axis.z) < 0.001f)
+    FrustumTest test_frustum_box(const Frustum &frustum, const BoundingBox &box)
+    {
+        FrustumTest result = FrustumTest::INSIDE;
+        for (const Vector4 &plane : frustum.planes)
         {
-            x_axis = (Vector3){1, 0, 0}; // Handle the special case when z_axis is close to the y-axis
+            // Corner of the box furthest along the plane normal (and the one furthest against it)
+            Vector3 positive = {plane.x >= 0.0f ? box.max.x : box.min.x,
+                                plane.y >= 0.0f ? box.max.y : box.min.y,
+                                plane.z >= 0.0f ? box.max.z : box.min.z};
+            Vector3 negative = {plane.x >= 0.0f ? box.min.x : box.max.x,
+                                plane.y >= 0.0f ? box.min.y : box.max.y,
+                                plane.z >= 0.0f ? box.min.z : box.max.z};
+
+            if (plane.x * positive.x + plane.y * positive.y + plane.z * positive.z + plane.w < 0.0f)
+            {
+                return FrustumTest::OUTSIDE;
+            }
+            if (plane.x * negative.x + plane.y * negative.y + plane.z * negative.z + plane.w < 0.0f)
+            {
+                result = FrustumTest::INTERSECTING;
+            }
         }
-        else
+        return result;
+    }
+
+    BoundingBox transform_bounding_box(const BoundingBox &box, const Matrix &transform)
+    {
+        // Arvo's method: the transformed extents are the sum of the extents projected on each matrix row
+        const float row[3][3] = {{transform.m0, transform.m4, transform.m8},
+                                 {transform.m1, transform.m5, transform.m9},
+                                 {transform.m2, transform.m6, transform.m10}};
+        const float min[3] = {box.min.x, box.min.y, box.min.z};
+        const float max[3] = {box.max.x, box.max.y, box.max.z};
+        float out_min[3] = {transform.m12, transform.m13, transform.m14};
+        float out_max[3] = {transform.m12, transform.m13, transform.m14};
+
+        for (int i = 0; i < 3; i++)
         {
-            x_axis = Vector3Normalize(Vector3CrossProduct((Vector3){0, 1, 0}, z_axis)); // Perpendicular vector
+            for (int j = 0; j < 3; j++)
+            {
+                float a = row[i][j] * min[j];
+                float b = row[i][j] * max[j];
+                out_min[i] += fminf(a, b);
+                out_max[i] += fmaxf(a, b);
+            }
         }
-        Vector3 y_axis = Vector3CrossProduct(z_axis, x_axis); // Second perpendicular vector in the disc's plane
+        return BoundingBox{{out_min[0], out_min[1], out_min[2]}, {out_max[0], out_max[1], out_max[2]}};
+    }
 
-        // Generate points for the front and back faces, making a continuous strip
-        for (int i = 0; i <= n_segments; i++)
+    BoundingBox get_model_meshes_bounding_box(const Model &model)
+    {
+        if (model.meshCount == 0)
         {
-            float angle = i * angle_step + angle_o;
+            return BoundingBox{Vector3Zero(), Vector3Zero()};
+        }
+        BoundingBox bounds = GetMeshBoundingBox(model.meshes[0]);
+        for (int i = 1; i < model.meshCount; i++)
+        {
+            BoundingBox mesh_bounds = GetMeshBoundingBox(model.meshes[i]);
+            bounds.min = Vector3Min(bounds.min, mesh_bounds.min);
+            bounds.max = Vector3Max(bounds.max, mesh_bounds.max);
+        }
+        return bounds;
+    }
+
+    void set_vertex_attribute(unsigned int index, int comp_size, int type, bool normalized, int stride, int offset)
+    {
+#if (RAYLIB_VERSION_MAJOR > 5) || (RAYLIB_VERSION_MAJOR == 5 && RAYLIB_VERSION_MINOR >= 5)
+        rlSetVertexAttribute(index, comp_size, type, normalized, stride, offset);
+#else
+        rlSetVertexAttribute(index, comp_size, type, normalized, stride, (const void *)(size_t)offset);
+#endif
+    }
 
-            float x_1 = cosf(angle) * r_1;
-            float y_1 = sinf(angle) * r_1;
+    void enable_default_shader()
+    {
+        int *locs = rlGetShaderLocsDefault();
+        float white[4] = {1.0f, 1.0f, 1.0f, 1.0f};
+        rlEnableShader(rlGetShaderIdDefault());
+        rlSetUniformMatrix(locs[RL_SHADER_LOC_MATRIX_MVP], MatrixMultiply(rlGetMatrixModelview(), rlGetMatrixProjection()));
+        rlSetUniform(locs[RL_SHADER_LOC_COLOR_DIFFUSE], white, RL_SHADER_UNIFORM_VEC4, 1);
+        rlActiveTextureSlot(0);
+        rlEnableTexture(rlGetTextureIdDefault());
+    }
 
-            float x_2 = cosf(angle) * r_2;
-            float y_2 = sinf(angle) * r_2;
+    void disable_default_shader()
+    {
+        rlDisableTexture();
+        rlDisableShader();
+    }
 
-            // Place the edge points in 3D space based on the disc orientation
-            Vector3 p_1 = Vector3Add(
-                Vector3Add(position, Vector3Scale(x_axis, x_1)), // Offset along x_axis
-                Vector3Scale(y_axis, y_1));                      // Offset along y_axis
+    void DirtyRange::add(size_t first, size_t last)
+    {
+        if (this->begin == this->end)
+        {
+            this->begin = first;
+            this->end = last;
+        }
+        else
+        {
+            this->begin = std::min(this->begin, first);
+            this->end = std::max(this->end, last);
+        }
+    }
 
-            // Place the edge points in 3D space based on the disc orientation
-            Vector3 p_2 = Vector3Add(
-                Vector3Add(position, Vector3Scale(x_axis, x_2)), // Offset along x_axis
-                Vector3Scale(y_axis, y_2));                      // Offset along y_axis
+    void DirtyRange::clear()
+    {
+        this->begin = this->end = 0;
+    }
 
-            // Front face (counter-clockwise winding)
-            points[2 * i] = p_1;     // Edge point for the front face
-            points[2 * i + 1] = p_2; // Center point for the front face
+    bool reserve_colored_vertex_buffers(ColoredVertexBuffers &buffers, size_t count, size_t min_capacity)
+    {
+        if (buffers.vao == 0)
+        {
+            buffers.vao = rlLoadVertexArray();
+        }
+        if (count <= buffers.capacity)
+        {
+            return false;
+        }
 
-            // Back face (clockwise winding to flip normal)            
-            points[4 * (n_segments + 1) - 2 * (i + 1)] = p_1;     // Inner radius point for the back face (clockwise)
-            points[4 * (n_segments + 1) - 2 * (i + 1) + 1] = p_2; // Outer radius point for the back face (clockwise)
+        rlEnableVertexArray(buffers.vao);
+        if (buffers.position_vbo != 0)
+        {
+            rlUnloadVertexBuffer(buffers.position_vbo);
+            rlUnloadVertexBuffer(buffers.color_vbo);
         }
+        buffers.capacity = std::max(count, std::max(buffers.capacity * 2, min_capacity));
+        buffers.position_vbo = rlLoadVertexBuffer(nullptr, buffers.capacity * sizeof(Vector3), true);
+        rlEnableVertexBuffer(buffers.position_vbo);
+        set_vertex_attribute(RL_DEFAULT_SHADER_ATTRIB_LOCATION_POSITION, 3, RL_FLOAT, false, 0, 0);
+        rlEnableVertexAttribute(RL_DEFAULT_SHADER_ATTRIB_LOCATION_POSITION);
+        buffers.color_vbo = rlLoadVertexBuffer(nullptr, buffers.capacity * sizeof(Color), true);
+        rlEnableVertexBuffer(buffers.color_vbo);
+        set_vertex_attribute(RL_DEFAULT_SHADER_ATTRIB_LOCATION_COLOR, 4, RL_UNSIGNED_BYTE, true, 0, 0);
+        rlEnableVertexAttribute(RL_DEFAULT_SHADER_ATTRIB_LOCATION_COLOR);
+        rlDisableVertexBuffer();
+        rlDisableVertexArray();
+        return true;
+    }
 
-        // Draw the full strip (both faces)
-        DrawTriangleStrip3D(points, 4 * (n_segments + 1), color);
+    void upload_colored_vertices(const ColoredVertexBuffers &buffers, const Vector3 *positions, const Color *colors, size_t begin, size_t end)
+    {
+        if (begin >= end)
+        {
+            return;
+        }
+        size_t count = end - begin;
+        rlUpdateVertexBuffer(buffers.position_vbo, positions + begin, count * sizeof(Vector3), begin * sizeof(Vector3));
+        rlUpdateVertexBuffer(buffers.color_vbo, colors + begin, count * sizeof(Color), begin * sizeof(Color));
     }
 
-    Matrix get_transform(const Vector3 &v, const Quaternion &q)
+    void unload_colored_vertex_buffers(ColoredVertexBuffers &buffers)
     {
-        Vector3 axis;
-        float angle;
-        QuaternionToAxisAngle(q, &axis, &angle);
-        Matrix rotationMatrix = MatrixRotate(axis, angle);
-        Matrix translationMatrix = MatrixTranslate(v.x, v.y, v.z);
-        return MatrixMultiply(rotationMatrix, translationMatrix);
+        if (buffers.position_vbo != 0)
+        {
+            rlUnloadVertexBuffer(buffers.position_vbo);
+            rlUnloadVertexBuffer(buffers.color_vbo);
+        }
+        if (buffers.vao != 0)
+        {
+            rlUnloadVertexArray(buffers.vao);
+        }
+        buffers = ColoredVertexBuffers();
     }
 
 }
@@ -1,8 +1,60 @@
+#pragma once
 #include <raylib.h>
 #include <raymath.h>
+#include <cstddef>
+#include <vector>
+#include "rlgl.h"
 
 namespace du
 {
+    /**
+     * @brief View frustum described by six inward facing planes (a, b, c, d) with a*x + b*y + c*z + d >= 0 inside.
+     */
+    struct Frustum
+    {
+        Vector4 planes[6]; // Left, right, bottom, top, near and far planes.
+    };
+
+    /**
+     * @brief Result of testing a bounding volume against a frustum.
+     */
+    enum class FrustumTest
+    {
+        OUTSIDE,
+        INTERSECTING,
+        INSIDE
+    };
+
+    /**
+     * @brief Range of elements modified since the last upload of a buffer (empty when begin == end).
+     */
+    struct DirtyRange
+    {
+        size_t begin = 0; // First modified element.
+        size_t end = 0;   // One past the last modified element.
+
+        /**
+         * @brief Extends the range to cover [first, last).
+         */
+        void add(size_t first, size_t last);
+
+        /**
+         * @brief Empties the range.
+         */
+        void clear();
+    };
+
+    /**
+     * @brief Vertex array with one buffer of positions and one of colors, bound to the default shader attributes.
+     */
+    struct ColoredVertexBuffers
+    {
+        unsigned int vao = 0;          // Vertex array.
+        unsigned int position_vbo = 0; // GPU buffer holding the positions.
+        unsigned int color_vbo = 0;    // GPU buffer holding the colors.
+        size_t capacity = 0;           // Number of vertices the buffers can hold.
+    };
+
     void draw_arrow(Vector3 start_position, Vector3 end_position, Color color, float radius);
 
     void draw_axes(Vector3 position, Quaternion orientation, float scale = 1.0);
@@ -16,6 +68,11 @@ namespace du
     */
     void draw_segment(Vector3 p_1, Vector3 p_2, Color color, float scale);
 
+    constexpr int MAX_CIRCLE_SEGMENTS = 256; // Largest segment count of the circle tables.
+
+    /**
+     * @brief Draws a full disc facing the given axis (two sided, immediate mode).
+    */
     void draw_disc_section(Vector3 position, Vector3 axis, float radius, Color color);
 
     /**
@@ -30,10 +87,151 @@ namespace du
     */
     void draw_ring_section(Vector3 position, Vector3 axis, float r_1 , float r_2, float angle_f = 2*PI, float angle_o = 0.0, Color color = GREEN);
 
+    /**
+     * @brief Gets the points of a unit circle split in segments (segments + 1 points, the last one repeats the first).
+     * The table of a segment count is computed on its first use.
+     * @param segments : Number of segments (clamped to [3, MAX_CIRCLE_SEGMENTS])
+    */
+    const Vector2 *get_unit_circle(int segments);
+
+    /**
+     * @brief Appends the triangles of a flat ring section (a disc section when one of the radii is 0).
+     * The triangles are emitted once and must be drawn with back face culling disabled to show both faces.
+     * @param triangles : Output vertices, three per triangle
+     * @param segments : Number of segments of the section
+    */
+    void gen_ring_section_triangles(std::vector<Vector3> &triangles, Vector3 position, Vector3 axis, float r_1, float r_2,
+                                    float angle_f, float angle_o, int segments);
+
     /**
      * @brief Gets the 4x4 transformation matrix given the position vector and the orientation quaternion.
      * @param v Position vector.
      * @param q Orientation quaternion.
     */
     Matrix get_transform(const Vector3 &v, const Quaternion &q);
+
+    /**
+     * @brief Draws a model with a precomputed transform (same result as DrawModelEx with the equivalent position, rotation and scale).
+     * @param model : Model
+     * @param transform : Transform from mesh space to world space (it already includes the model transform, see VisualObject::get_transform)
+     * @param tint : Color multiplied with the diffuse color of the materials
+    */
+    void draw_model(const Model &model, const Matrix &transform, Color tint);
+
+    /**
+     * @brief Draws the wireframe of a model with a precomputed transform (same result as DrawModelWiresEx).
+     * @param model : Model
+     * @param transform : Transform from mesh space to world space (it already includes the model transform, see VisualObject::get_transform)
+     * @param tint : Color multiplied with the diffuse color of the materials
+    */
+    void draw_model_wires(const Model &model, const Matrix &transform, Color tint);
+
+    /**
+     * @brief Draws a model in a single pass with its triangle edges highlighted (replaces drawing the model and its wireframe).
+     * @param model : Model (its materials are used)
+     * @param edge_meshes : Meshes of the model generated with gen_mesh_barycentric
+     * @param transform : Transform from mesh space to world space (it already includes the model transform, see VisualObject::get_transform)
+     * @param tint : Color multiplied with the diffuse color of the materials (edges are drawn 30% darker)
+     * @param edge_shader : Shader that reads the barycentric coordinates from the second texture coordinates
+    */
+    void draw_model_edges(const Model &model, const Mesh *edge_meshes, const Matrix &transform, Color tint, const Shader &edge_shader);
+
+    /**
+     * @brief Generates an unindexed copy of a mesh with the barycentric coordinates of every triangle corner in its
+     * second texture coordinates ((1, 0), (0, 1) and (0, 0)), used to draw the triangle edges from the fragment shader.
+     * The copy is uploaded to the GPU. Animation data is not copied.
+     * @param mesh : Mesh (with its CPU data)
+    */
+    Mesh gen_mesh_barycentric(const Mesh &mesh);
+
+    /**
+     * @brief Loads a shader, inserting preprocessor definitions after the #version line of both stages.
+     * @param vs_path : Path to the vertex shader
+     * @param fs_path : Path to the fragment shader
+     * @param defines : Lines inserted in the sources (e.g. "#define EDGE_OVERLAY\n")
+     * @return The loaded shader (raylib's default shader if the files can not be read or compiled)
+    */
+    Shader load_shader_with_defines(const char *vs_path, const char *fs_path, const char *defines);
+
+    /**
+     * @brief Gets the rotation matrix that maps the +Y axis onto the given direction.
+     * @param direction Target direction (does not need to be normalized).
+    */
+    Matrix get_rotation_from_y_axis(Vector3 direction);
+
+    /**
+     * @brief Gets the transform that maps a unit primitive aligned with +Y (from y = 0 to y = 1) onto the segment p_1 -> p_2.
+     * @param p_1 : Start point of the segment
+     * @param p_2 : End point of the segment
+     * @param radius : Scale applied to the X and Z axes of the primitive
+    */
+    Matrix get_segment_transform(Vector3 p_1, Vector3 p_2, float radius);
+
+    /**
+     * @brief Extracts the frustum planes from a view-projection matrix (as built by MatrixMultiply(view, projection)).
+     * @param view_projection View-projection matrix.
+    */
+    Frustum get_frustum(const Matrix &view_projection);
+
+    /**
+     * @brief Tests an axis aligned bounding box against a frustum.
+     * @param frustum : Frustum
+     * @param box : Bounding box in the same space as the frustum
+    */
+    FrustumTest test_frustum_box(const Frustum &frustum, const BoundingBox &box);
+
+    /**
+     * @brief Gets the axis aligned bounding box that encloses a transformed bounding box.
+     * @param box : Bounding box
+     * @param transform : Transformation matrix
+    */
+    BoundingBox transform_bounding_box(const BoundingBox &box, const Matrix &transform);
+
+    /**
+     * @brief Gets the bounding box of all the meshes of a model in mesh space (the model transform is not applied).
+     * @param model : Model
+    */
+    BoundingBox get_model_meshes_bounding_box(const Model &model);
+
+    /**
+     * @brief Sets a vertex attribute pointer of the currently bound vertex buffer.
+     * Wraps rlSetVertexAttribute, whose offset parameter changed type in raylib 5.5.
+     * @param index : Attribute location
+     * @param comp_size : Number of components of the attribute
+     * @param type : Component type (RL_FLOAT, RL_UNSIGNED_BYTE, ...)
+     * @param normalized : Whether integer data is normalized to [0, 1]
+     * @param stride : Byte stride between consecutive elements
+     * @param offset : Byte offset of the attribute inside the element
+    */
+    void set_vertex_attribute(unsigned int index, int comp_size, int type, bool normalized, int stride, int offset);
+
+    /**
+     * @brief Enables the rlgl default shader for drawing vertex colored geometry from custom vertex arrays
+     * (sets the current model-view-projection matrix, a white diffuse color and the default white texture).
+     */
+    void enable_default_shader();
+
+    /**
+     * @brief Disables the shader and texture enabled by enable_default_shader.
+     */
+    void disable_default_shader();
+
+    /**
+     * @brief Creates the vertex array of colored vertex buffers if needed, and recreates the buffers when they
+     * cannot hold count vertices. The capacity at least doubles, so a slowly growing set of vertices does not
+     * reallocate on every change.
+     * @param min_capacity : Capacity of the first buffers
+     * @return True if the buffers were recreated (their previous contents are lost)
+    */
+    bool reserve_colored_vertex_buffers(ColoredVertexBuffers &buffers, size_t count, size_t min_capacity);
+
+    /**
+     * @brief Uploads the vertices [begin, end) of arrays of positions and colors (nothing if the range is empty).
+    */
+    void upload_colored_vertices(const ColoredVertexBuffers &buffers, const Vector3 *positions, const Color *colors, size_t begin, size_t end);
+
+    /**
+     * @brief Releases colored vertex buffers and resets them. Safe to call more than once.
+    */
+    void unload_colored_vertex_buffers(ColoredVertexBuffers &buffers);
 }
@@ -0,0 +1,340 @@
+#include "DynamicBvh.hpp"
+#include <algorithm>
+#include <utility>
+
+namespace
+{
+    BoundingBox combine(const BoundingBox &a, const BoundingBox &b)
+    {
+        return BoundingBox{Vector3Min(a.min, b.min), Vector3Max(a.max, b.max)};
+    }
+
+    float perimeter(const BoundingBox &box)
+    {
+        return 2.0f * ((box.max.x - box.min.x) + (box.max.y - box.min.y) + (box.max.z - box.min.z));
+    }
+
+    bool contains(const BoundingBox &outer, const BoundingBox &inner)
+    {
+        return outer.min.x <= inner.min.x && outer.min.y <= inner.min.y && outer.min.z <= inner.min.z &&
+               inner.max.x <= outer.max.x && inner.max.y <= outer.max.y && inner.max.z <= outer.max.z;
+    }
+
+    BoundingBox expand(const BoundingBox &box, float margin)
+    {
+        Vector3 r = {margin, margin, margin};
+        return BoundingBox{Vector3Subtract(box.min, r), Vector3Add(box.max, r)};
+    }
+}
+
+DynamicBvh::DynamicBvh(float margin) : margin_(margin)
+{
+}
+
+int DynamicBvh::allocate_node()
+{
+    if (this->free_list_ == NULL_NODE)
+    {
+        this->nodes_.push_back(Node());
+        this->free_list_ = this->nodes_.size() - 1;
+        this->nodes_[this->free_list_].parent = NULL_NODE;
+    }
+    int node = this->free_list_;
+    this->free_list_ = this->nodes_[node].parent;
+    this->nodes_[node] = Node();
+    this->nodes_[node].height = 0;
+    return node;
+}
+
+void DynamicBvh::free_node(int node)
+{
+    this->nodes_[node].parent = this->free_list_;
+    this->nodes_[node].height = -1;
+    this->free_list_ = node;
+}
+
+int DynamicBvh::create_proxy(const BoundingBox &box, int user_data)
+{
+    int proxy = this->allocate_node();
+    this->nodes_[proxy].box = expand(box, this->margin_);
+    this->nodes_[proxy].user_data = user_data;
+    this->insert_leaf(proxy);
+    return proxy;
+}
+
+void DynamicBvh::destroy_proxy(int proxy)
+{
+    this->remove_leaf(proxy);
+    this->free_node(proxy);
+}
+
+bool DynamicBvh::move_proxy(int proxy, const BoundingBox &box)
+{
+    const BoundingBox &fat_box = this->nodes_[proxy].box;
+    // Keep the proxy if it still fits and its fat box did not become much larger than needed (e.g. after a rescale)
+    if (contains(fat_box, box) && contains(expand(box, 4.0f * this->margin_), fat_box))
+    {
+        return false;
+    }
+    this->remove_leaf(proxy);
+    this->nodes_[proxy].box = expand(box, this->margin_);
+    this->insert_leaf(proxy);
+    return true;
+}
+
+const BoundingBox &DynamicBvh::get_fat_box(int proxy) const
+{
+    return this->nodes_[proxy].box;
+}
+
+int DynamicBvh::get_user_data(int proxy) const
+{
+    return this->nodes_[proxy].user_data;
+}
+
+void DynamicBvh::clear()
+{
+    this->nodes_.clear();
+    this->root_ = NULL_NODE;
+    this->free_list_ = NULL_NODE;
+}
+
+int DynamicBvh::get_height() const
+{
+    return this->root_ == NULL_NODE ? 0 : this->nodes_[this->root_].height;
+}
+
+void DynamicBvh::insert_leaf(int leaf)
+{
+    if (this->root_ == NULL_NODE)
+    {
+        this->root_ = leaf;
+        this->nodes_[leaf].parent = NULL_NODE;
+        return;
+    }
+
+    // Find the best sibling for the new leaf using the surface area heuristic
+    BoundingBox leaf_box = this->nodes_[leaf].box;
+    int index = this->root_;
+    while (!this->nodes_[index].is_leaf())
+    {
+        const Node &node = this->nodes_[index];
+        float area = perimeter(node.box);
+        float combined_area = perimeter(combine(node.box, leaf_box));
+
+        // Cost of creating a new parent for this node and the new leaf
+        float cost = 2.0f * combined_area;
+        // Minimum cost of pushing the leaf further down the tree
+        float inheritance_cost = 2.0f * (combined_area - area);
+
+        float child_costs[2];
+        int children[2] = {node.child_1, node.child_2};
+        for (int i = 0; i < 2; i++)
+        {
+            const Node &child = this->nodes_[children[i]];
+            float new_area = perimeter(combine(leaf_box, child.box));
+            child_costs[i] = (child.is_leaf() ? new_area : new_area - perimeter(child.box)) + inheritance_cost;
+        }
+
+        if (cost < child_costs[0] && cost < child_costs[1])
+        {
+            break;
+        }
+        index = child_costs[0] < child_costs[1] ? children[0] : children[1];
+    }
+    int sibling = index;
+
+    // Create a new parent for the sibling and the leaf
+    int old_parent = this->nodes_[sibling].parent;
+    int new_parent = this->allocate_node();
+    this->nodes_[new_parent].parent = old_parent;
+    this->nodes_[new_parent].box = combine(leaf_box, this->nodes_[sibling].box);
+    this->nodes_[new_parent].height = this->nodes_[sibling].height + 1;
+    this->nodes_[new_parent].child_1 = sibling;
+    this->nodes_[new_parent].child_2 = leaf;
+    this->nodes_[sibling].parent = new_parent;
+    this->nodes_[leaf].parent = new_parent;
+
+    if (old_parent != NULL_NODE)
+    {
+        if (this->nodes_[old_parent].child_1 == sibling)
+        {
+            this->nodes_[old_parent].child_1 = new_parent;
+        }
+        else
+        {
+            this->nodes_[old_parent].child_2 = new_parent;
+        }
+    }
+    else
+    {
+        this->root_ = new_parent;
+    }
+
+    // Walk back up the tree fixing heights and boxes
+    index = this->nodes_[leaf].parent;
+    while (index != NULL_NODE)
+    {
+        index = this->balance(index);
+        Node &node = this->nodes_[index];
+        node.height = 1 + std::max(this->nodes_[node.child_1].height, this->nodes_[node.child_2].height);
+        node.box = combine(this->nodes_[node.child_1].box, this->nodes_[node.child_2].box);
+        index = node.parent;
+    }
+}
+
+void DynamicBvh::remove_leaf(int leaf)
+{
+    if (leaf == this->root_)
+    {
+        this->root_ = NULL_NODE;
+        return;
+    }
+
+    int parent = this->nodes_[leaf].parent;
+    int grand_parent = this->nodes_[parent].parent;
+    int sibling = this->nodes_[parent].child_1 == leaf ? this->nodes_[parent].child_2 : this->nodes_[parent].child_1;
+
+    if (grand_parent == NULL_NODE)
+    {
+        this->root_ = sibling;
+        this->nodes_[sibling].parent = NULL_NODE;
+        this->free_node(parent);
+        return;
+    }
+
+    // Destroy the parent and connect the sibling to the grand parent
+    if (this->nodes_[grand_parent].child_1 == parent)
+    {
+        this->nodes_[grand_parent].child_1 = sibling;
+    }
+    else
+    {
+        this->nodes_[grand_parent].child_2 = sibling;
+    }
+    this->nodes_[sibling].parent = grand_parent;
+    this->free_node(parent);
+
+    int index = grand_parent;
+    while (index != NULL_NODE)
+    {
+        index = this->balance(index);
+        Node &node = this->nodes_[index];
+        node.height = 1 + std::max(this->nodes_[node.child_1].height, this->nodes_[node.child_2].height);
+        node.box = combine(this->nodes_[node.child_1].box, this->nodes_[node.child_2].box);
+        index = node.parent;
+    }
+}
+
+int DynamicBvh::balance(int i_a)
+{
+    Node &a = this->nodes_[i_a];
+    if (a.is_leaf() || a.height < 2)
+    {
+        return i_a;
+    }
+
+    int i_b = a.child_1;
+    int i_c = a.child_2;
+    Node &b = this->nodes_[i_b];
+    Node &c = this->nodes_[i_c];
+    int balance = c.height - b.height;
+
+    // Rotate the taller child up (the two cases are symmetric)
+    if (balance > 1 || balance < -1)
+    {
+        bool rotate_c = balance > 1;
+        int i_up = rotate_c ? i_c : i_b;     // Child moved up to replace A
+        int i_other = rotate_c ? i_b : i_c;  // Child that stays under A
+        Node &up = this->nodes_[i_up];
+        Node &other = this->nodes_[i_other];
+        int i_f = up.child_1;
+        int i_g = up.child_2;
+        Node &f = this->nodes_[i_f];
+        Node &g = this->nodes_[i_g];
+
+        // Swap A and its child
+        up.child_1 = i_a;
+        up.parent = a.parent;
+        a.parent = i_up;
+
+        if (up.parent != NULL_NODE)
+        {
+            if (this->nodes_[up.parent].child_1 == i_a)
+            {
+                this->nodes_[up.parent].child_1 = i_up;
+            }
+            else
+            {
+                this->nodes_[up.parent].child_2 = i_up;
+            }
+        }
+        else
+        {
+            this->root_ = i_up;
+        }
+
+        // The taller grandchild stays with the rotated node, the shorter one goes to A
+        int i_keep = f.height > g.height ? i_f : i_g;
+        int i_move = f.height > g.height ? i_g : i_f;
+        Node &keep = this->nodes_[i_keep];
+        Node &move = this->nodes_[i_move];
+
+        up.child_2 = i_keep;
+        if (rotate_c)
+        {
+            a.child_2 = i_move;
+        }
+        else
+        {
+            a.child_1 = i_move;
+        }
+        move.parent = i_a;
+
+        a.box = combine(other.box, move.box);
+        a.height = 1 + std::max(other.height, move.height);
+        up.box = combine(a.box, keep.box);
+        up.height = 1 + std::max(a.height, keep.height);
+
+        return i_up;
+    }
+
+    return i_a;
+}
+
+void DynamicBvh::query_frustum(const du::Frustum &frustum, std::vector<int> &user_data) const
+{
+    if (this->root_ == NULL_NODE)
+    {
+        return;
+    }
+
+    // Each entry stores a node and whether its parent was already fully inside the frustum
+    std::vector<std::pair<int, bool>> stack = {{this->root_, false}};
+    while (!stack.empty())
+    {
+        auto [index, inside] = stack.back();
+        stack.pop_back();
+        const Node &node = this->nodes_[index];
+
+        if (!inside)
+        {
+            du::FrustumTest test = du::test_frustum_box(frustum, node.box);
+            if (test == du::FrustumTest::OUTSIDE)
+            {
+                continue;
+            }
+            inside = test == du::FrustumTest::INSIDE;
+        }
+
+        if (node.is_leaf())
+        {
+            user_data.push_back(node.user_data);
+        }
+        else
+        {
+            stack.push_back({node.child_1, inside});
+            stack.push_back({node.child_2, inside});
+        }
+    }
+}
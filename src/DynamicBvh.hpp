@@ -0,0 +1,133 @@
+#pragma once
+#include <raylib.h>
+#include <raymath.h>
+#include <vector>
+
+#include "DrawingUtils.hpp"
+
+/**
+ * @brief Dynamic bounding volume hierarchy of axis aligned boxes (in the style of Box2D's dynamic tree).
+ *
+ * Every proxy stores a "fat" box, enlarged by a margin around the box it was given. Moving a proxy only
+ * touches the tree when its new box leaves the fat box, so small motions are free and the tree is refit
+ * incrementally instead of being rebuilt. The tree is kept balanced with rotations on insertion and removal.
+ */
+class DynamicBvh
+{
+public:
+    static constexpr int NULL_NODE = -1; // Index used for missing nodes.
+
+private:
+    /**
+     * @brief Node of the tree. Leaves hold the proxies, internal nodes always have two children.
+     */
+    struct Node
+    {
+        BoundingBox box;            // Fat box of the leaf or union of the children boxes.
+        int parent = NULL_NODE;     // Parent node (next free node when the node is in the free list).
+        int child_1 = NULL_NODE;    // First child (NULL_NODE for leaves).
+        int child_2 = NULL_NODE;    // Second child (NULL_NODE for leaves).
+        int height = -1;            // Height of the subtree (0 for leaves, -1 for free nodes).
+        int user_data = -1;         // Data associated with the proxy.
+
+        bool is_leaf() const { return this->child_1 == NULL_NODE; }
+    };
+
+    std::vector<Node> nodes_;    // Node pool.
+    int root_ = NULL_NODE;       // Root of the tree.
+    int free_list_ = NULL_NODE;  // First free node of the pool.
+    float margin_;               // Margin added around the proxy boxes.
+
+    int allocate_node();
+    void free_node(int node);
+    void insert_leaf(int leaf);
+    void remove_leaf(int leaf);
+    int balance(int node);
+
+public:
+    /**
+     * @brief Constructor for the DynamicBvh class.
+     * @param margin Margin added around the proxy boxes, larger margins mean fewer tree updates but looser boxes.
+     */
+    explicit DynamicBvh(float margin = 0.1f);
+
+    /**
+     * @brief Adds a proxy to the tree.
+     * @param box Bounding box of the proxy.
+     * @param user_data Data returned by the queries for this proxy.
+     * @return Id of the proxy.
+     */
+    int create_proxy(const BoundingBox &box, int user_data);
+
+    /**
+     * @brief Removes a proxy from the tree.
+     */
+    void destroy_proxy(int proxy);
+
+    /**
+     * @brief Updates the box of a proxy, reinserting it only if it left its fat box.
+     * @return True if the proxy was reinserted.
+     */
+    bool move_proxy(int proxy, const BoundingBox &box);
+
+    /**
+     * @brief Gets the fat box of a proxy.
+     */
+    const BoundingBox &get_fat_box(int proxy) const;
+
+    /**
+     * @brief Gets the user data of a proxy.
+     */
+    int get_user_data(int proxy) const;
+
+    /**
+     * @brief Removes all the proxies.
+     */
+    void clear();
+
+    /**
+     * @brief Gets the height of the tree (0 for an empty tree or a single proxy).
+     */
+    int get_height() const;
+
+    /**
+     * @brief Collects the user data of all the proxies whose fat box is (at least partially) inside a frustum.
+     * Subtrees that are completely inside the frustum are accepted without testing their nodes.
+     * @param frustum Frustum to test against.
+     * @param user_data Output vector where the user data of the visible proxies is appended.
+     */
+    void query_frustum(const du::Frustum &frustum, std::vector<int> &user_data) const;
+
+    /**
+     * @brief Visits the tree, descending only into the nodes whose box passes a test.
+     * @param node_test Function taking a BoundingBox and returning true if the node has to be visited.
+     * @param callback Function called with the user data of each visited leaf.
+     */
+    template <typename NodeTest, typename Callback>
+    void query(const NodeTest &node_test, const Callback &callback) const
+    {
+        if (this->root_ == NULL_NODE)
+        {
+            return;
+        }
+        std::vector<int> stack = {this->root_};
+        while (!stack.empty())
+        {
+            const Node &node = this->nodes_[stack.back()];
+            stack.pop_back();
+            if (!node_test(node.box))
+            {
+                continue;
+            }
+            if (node.is_leaf())
+            {
+                callback(node.user_data);
+            }
+            else
+            {
+                stack.push_back(node.child_1);
+                stack.push_back(node.child_2);
+            }
+        }
+    }
+};
@@ -0,0 +1,445 @@
+#include "FrameCapture.hpp"
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include "rlgl.h"
+
+// raylib compiles stb_image_write into the library without installing its header (ExportImage is not used on the
+// encoder thread because its extension checks go through raylib's shared text buffers). A shared raylib may not
+// export it, the weak declaration resolves to null then and the frames are written by write_stored_png
+#if defined(__GNUC__) || defined(__clang__)
+extern "C" int stbi_write_png(const char *filename, int w, int h, int comp, const void *data, int stride_in_bytes) __attribute__((weak));
+#define FRAME_CAPTURE_HAS_STB 1
+#else
+#define FRAME_CAPTURE_HAS_STB 0
+#endif
+
+namespace
+{
+    unsigned char to_byte(float value)
+    {
+        return (unsigned char)std::clamp(value + 0.5f, 0.0f, 255.0f);
+    }
+
+    uint32_t update_crc32(uint32_t crc, const unsigned char *data, size_t size)
+    {
+        static const std::array<uint32_t, 256> table = []
+        {
+            std::array<uint32_t, 256> values;
+            for (uint32_t i = 0; i < 256; i++)
+            {
+                uint32_t value = i;
+                for (int bit = 0; bit < 8; bit++)
+                {
+                    value = (value & 1) ? 0xEDB88320u ^ (value >> 1) : value >> 1;
+                }
+                values[i] = value;
+            }
+            return values;
+        }();
+        crc = ~crc;
+        for (size_t i = 0; i < size; i++)
+        {
+            crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+        }
+        return ~crc;
+    }
+
+    void append_u32(std::vector<unsigned char> &buffer, uint32_t value)
+    {
+        unsigned char bytes[4] = {(unsigned char)(value >> 24), (unsigned char)(value >> 16), (unsigned char)(value >> 8), (unsigned char)value};
+        buffer.insert(buffer.end(), bytes, bytes + 4);
+    }
+
+    void append_chunk(std::vector<unsigned char> &file, const char *type, const std::vector<unsigned char> &data)
+    {
+        append_u32(file, (uint32_t)data.size());
+        size_t start = file.size();
+        file.insert(file.end(), type, type + 4);
+        file.insert(file.end(), data.begin(), data.end());
+        append_u32(file, update_crc32(0, &file[start], file.size() - start));
+    }
+
+    /**
+     * @brief Writes RGBA pixels (top row first) to a PNG file with uncompressed deflate blocks.
+     * Larger than a compressed PNG, but it only needs the C library.
+     */
+    bool write_stored_png(const char *path, const unsigned char *pixels, int width, int height)
+    {
+        std::vector<unsigned char> header;
+        append_u32(header, (uint32_t)width);
+        append_u32(header, (uint32_t)height);
+        header.insert(header.end(), {8, 6, 0, 0, 0}); // 8 bits per channel, RGBA, no interlacing
+
+        // zlib stream of the rows, each preceded by filter type 0, split in stored blocks of up to 65535 bytes
+        size_t row_size = (size_t)width * 4;
+        std::vector<unsigned char> rows;
+        rows.reserve(height * (row_size + 1));
+        for (int y = 0; y < height; y++)
+        {
+            rows.push_back(0);
+            rows.insert(rows.end(), pixels + y * row_size, pixels + (y + 1) * row_size);
+        }
+        std::vector<unsigned char> data = {0x78, 0x01};
+        data.reserve(rows.size() + rows.size() / 65535 * 5 + 11);
+        size_t offset = 0;
+        do
+        {
+            size_t size = std::min(rows.size() - offset, (size_t)65535);
+            data.push_back(offset + size == rows.size() ? 1 : 0);
+            data.insert(data.end(), {(unsigned char)size, (unsigned char)(size >> 8), (unsigned char)~size, (unsigned char)(~size >> 8)});
+            data.insert(data.end(), rows.begin() + offset, rows.begin() + offset + size);
+            offset += size;
+        } while (offset < rows.size());
+        uint32_t a = 1, b = 0;
+        for (unsigned char byte : rows)
+        {
+            a = (a + byte) % 65521;
+            b = (b + a) % 65521;
+        }
+        append_u32(data, (b << 16) | a);
+
+        std::vector<unsigned char> file = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+        append_chunk(file, "IHDR", header);
+        append_chunk(file, "IDAT", data);
+        append_chunk(file, "IEND", {});
+
+        FILE *stream = fopen(path, "wb");
+        if (stream == nullptr)
+        {
+            return false;
+        }
+        bool written = fwrite(file.data(), 1, file.size(), stream) == file.size();
+        return fclose(stream) == 0 && written;
+    }
+}
+
+FrameCapture::~FrameCapture()
+{
+    // The pixel buffers need the OpenGL context and are released by stop, only the thread and file are cleaned up here
+    if (this->encoder_.joinable())
+    {
+        {
+            std::lock_guard<std::mutex> lock(this->mutex_);
+            this->stopping_ = true;
+        }
+        this->frame_ready_.notify_one();
+        this->encoder_.join();
+    }
+    if (this->stream_ != nullptr)
+    {
+        fclose(this->stream_);
+    }
+}
+
+bool FrameCapture::start(const std::string &path, CaptureFormat format, int width, int height, int fps)
+{
+    this->stop();
+
+    const gl_loader::Functions &gl = gl_loader::get_functions();
+    if (!gl.has_pixel_buffers())
+    {
+        TraceLog(LOG_WARNING, "CAPTURE: Pixel buffer objects are not available, capture disabled");
+        return false;
+    }
+
+    if (format == CaptureFormat::Y4M)
+    {
+        this->stream_ = fopen(path.c_str(), "wb");
+        if (this->stream_ == nullptr)
+        {
+            TraceLog(LOG_WARNING, "CAPTURE: Failed to open %s", path.c_str());
+            return false;
+        }
+        fprintf(this->stream_, "YUV4MPEG2 W%d H%d F%d:1 Ip A1:1 C420jpeg XCOLORRANGE=FULL\n", width, height, fps);
+    }
+    else
+    {
+        std::error_code error;
+        std::filesystem::create_directories(path, error);
+        if (error)
+        {
+            TraceLog(LOG_WARNING, "CAPTURE: Failed to create directory %s", path.c_str());
+            return false;
+        }
+    }
+
+    this->format_ = format;
+    this->path_ = path;
+    this->width_ = width;
+    this->height_ = height;
+    this->next_buffer_ = 0;
+    for (PixelBuffer &buffer : this->pixel_buffers_)
+    {
+        gl.glGenBuffers(1, &buffer.id);
+        gl.glBindBuffer(gl_loader::GL_PIXEL_PACK_BUFFER, buffer.id);
+        gl.glBufferData(gl_loader::GL_PIXEL_PACK_BUFFER, (ptrdiff_t)width * height * 4, nullptr, gl_loader::GL_STREAM_READ);
+        buffer.fence = nullptr;
+    }
+    gl.glBindBuffer(gl_loader::GL_PIXEL_PACK_BUFFER, 0);
+
+    this->stats_ = CaptureStats();
+    this->queue_.clear();
+    this->stopping_ = false;
+    this->encoder_ = std::thread(&FrameCapture::encode_frames, this);
+    this->capturing_ = true;
+    return true;
+}
+
+void FrameCapture::capture(const RenderTexture2D &target)
+{
+    if (!this->capturing_)
+    {
+        return;
+    }
+    const gl_loader::Functions &gl = gl_loader::get_functions();
+
+    // Hand the finished readbacks to the encoder (fences signal in submission order, oldest first)
+    for (int i = 0; i < PIXEL_BUFFER_COUNT; i++)
+    {
+        PixelBuffer &buffer = this->pixel_buffers_[(this->next_buffer_ + i) % PIXEL_BUFFER_COUNT];
+        if (buffer.fence == nullptr)
+        {
+            continue;
+        }
+        unsigned int status = gl.glClientWaitSync(buffer.fence, gl_loader::GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+        if (status != gl_loader::GL_ALREADY_SIGNALED && status != gl_loader::GL_CONDITION_SATISFIED)
+        {
+            break;
+        }
+        this->read_pixel_buffer(buffer);
+    }
+
+    // Drop the frame rather than wait when every buffer is still in flight
+    PixelBuffer &buffer = this->pixel_buffers_[this->next_buffer_];
+    if (buffer.fence != nullptr || target.texture.width != this->width_ || target.texture.height != this->height_)
+    {
+        std::lock_guard<std::mutex> lock(this->mutex_);
+        this->stats_.dropped_frames++;
+        return;
+    }
+
+    rlDrawRenderBatchActive();
+    gl.glBindFramebuffer(gl_loader::GL_READ_FRAMEBUFFER, target.id);
+    gl.glBindBuffer(gl_loader::GL_PIXEL_PACK_BUFFER, buffer.id);
+    gl.glReadPixels(0, 0, this->width_, this->height_, gl_loader::GL_RGBA, gl_loader::GL_UNSIGNED_BYTE, nullptr);
+    gl.glBindBuffer(gl_loader::GL_PIXEL_PACK_BUFFER, 0);
+    gl.glBindFramebuffer(gl_loader::GL_READ_FRAMEBUFFER, 0);
+    buffer.fence = gl.glFenceSync(gl_loader::GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    this->next_buffer_ = (this->next_buffer_ + 1) % PIXEL_BUFFER_COUNT;
+}
+
+void FrameCapture::read_pixel_buffer(PixelBuffer &buffer)
+{
+    const gl_loader::Functions &gl = gl_loader::get_functions();
+    gl.glBindBuffer(gl_loader::GL_PIXEL_PACK_BUFFER, buffer.id);
+    const void *pixels = gl.glMapBufferRange(gl_loader::GL_PIXEL_PACK_BUFFER, 0, (ptrdiff_t)this->width_ * this->height_ * 4, gl_loader::GL_MAP_READ_BIT);
+    if (pixels != nullptr)
+    {
+        this->push_frame((const unsigned char *)pixels);
+        gl.glUnmapBuffer(gl_loader::GL_PIXEL_PACK_BUFFER);
+    }
+    gl.glBindBuffer(gl_loader::GL_PIXEL_PACK_BUFFER, 0);
+    gl.glDeleteSync(buffer.fence);
+    buffer.fence = nullptr;
+}
+
+void FrameCapture::push_frame(const unsigned char *pixels)
+{
+    std::vector<unsigned char> frame;
+    {
+        std::lock_guard<std::mutex> lock(this->mutex_);
+        if (this->stats_.write_failed || this->queue_.size() >= MAX_QUEUED_FRAMES)
+        {
+            this->stats_.dropped_frames++;
+            return;
+        }
+        if (!this->free_frames_.empty())
+        {
+            frame = std::move(this->free_frames_.back());
+            this->free_frames_.pop_back();
+        }
+    }
+
+    // Copy outside the lock so the encoder is not held up
+    size_t size = (size_t)this->width_ * this->height_ * 4;
+    frame.resize(size);
+    memcpy(frame.data(), pixels, size);
+
+    {
+        std::lock_guard<std::mutex> lock(this->mutex_);
+        this->queue_.push_back(std::move(frame));
+        this->stats_.captured_frames++;
+        this->stats_.max_queue_depth = std::max(this->stats_.max_queue_depth, this->queue_.size());
+    }
+    this->frame_ready_.notify_one();
+}
+
+void FrameCapture::encode_frames()
+{
+    std::vector<unsigned char> scratch;
+    while (true)
+    {
+        std::vector<unsigned char> frame;
+        size_t index;
+        bool failed;
+        {
+            std::unique_lock<std::mutex> lock(this->mutex_);
+            this->frame_ready_.wait(lock, [this]
+                                    { return !this->queue_.empty() || this->stopping_; });
+            if (this->queue_.empty())
+            {
+                return;
+            }
+            frame = std::move(this->queue_.front());
+            this->queue_.pop_front();
+            index = this->stats_.written_frames;
+            failed = this->stats_.write_failed;
+        }
+
+        bool written = false;
+        if (!failed)
+        {
+            written = this->format_ == CaptureFormat::Y4M ? this->write_y4m(frame, scratch) : this->write_png(frame, index, scratch);
+        }
+
+        std::lock_guard<std::mutex> lock(this->mutex_);
+        if (written)
+        {
+            this->stats_.written_frames++;
+        }
+        else
+        {
+            this->stats_.write_failed = true;
+            this->stats_.dropped_frames++;
+        }
+        this->free_frames_.push_back(std::move(frame));
+    }
+}
+
+bool FrameCapture::write_png(const std::vector<unsigned char> &pixels, size_t index, std::vector<unsigned char> &scratch) const
+{
+    // OpenGL rows are stored bottom-up
+    size_t row_size = (size_t)this->width_ * 4;
+    scratch.resize(pixels.size());
+    for (int y = 0; y < this->height_; y++)
+    {
+        memcpy(&scratch[y * row_size], &pixels[(this->height_ - 1 - y) * row_size], row_size);
+    }
+
+    // TextFormat uses a shared buffer, which is not safe outside the render thread
+    char file_name[64];
+    snprintf(file_name, sizeof(file_name), "/frame_%06zu.png", index);
+    std::string path = this->path_ + file_name;
+#if FRAME_CAPTURE_HAS_STB
+    if (stbi_write_png != nullptr)
+    {
+        return stbi_write_png(path.c_str(), this->width_, this->height_, 4, scratch.data(), (int)row_size) != 0;
+    }
+#endif
+    return write_stored_png(path.c_str(), scratch.data(), this->width_, this->height_);
+}
+
+bool FrameCapture::write_y4m(const std::vector<unsigned char> &pixels, std::vector<unsigned char> &scratch) const
+{
+    int chroma_width = (this->width_ + 1) / 2;
+    int chroma_height = (this->height_ + 1) / 2;
+    size_t luma_size = (size_t)this->width_ * this->height_;
+    size_t chroma_size = (size_t)chroma_width * chroma_height;
+    scratch.resize(luma_size + 2 * chroma_size);
+    unsigned char *y_plane = scratch.data();
+    unsigned char *u_plane = y_plane + luma_size;
+    unsigned char *v_plane = u_plane + chroma_size;
+
+    // Full range BT.601 (JPEG) conversion, flipping the bottom-up OpenGL rows
+    auto pixel = [&pixels, this](int x, int y) -> const unsigned char *
+    {
+        return &pixels[((size_t)(this->height_ - 1 - y) * this->width_ + x) * 4];
+    };
+    for (int y = 0; y < this->height_; y++)
+    {
+        for (int x = 0; x < this->width_; x++)
+        {
+            const unsigned char *rgb = pixel(x, y);
+            y_plane[(size_t)y * this->width_ + x] = to_byte(0.299f * rgb[0] + 0.587f * rgb[1] + 0.114f * rgb[2]);
+        }
+    }
+    for (int y = 0; y < chroma_height; y++)
+    {
+        for (int x = 0; x < chroma_width; x++)
+        {
+            // Average the 2x2 block (clamped at odd borders)
+            float r = 0.0f, g = 0.0f, b = 0.0f;
+            for (int i = 0; i < 4; i++)
+            {
+                const unsigned char *rgb = pixel(std::min(2 * x + (i & 1), this->width_ - 1), std::min(2 * y + (i >> 1), this->height_ - 1));
+                r += rgb[0];
+                g += rgb[1];
+                b += rgb[2];
+            }
+            r *= 0.25f;
+            g *= 0.25f;
+            b *= 0.25f;
+            u_plane[(size_t)y * chroma_width + x] = to_byte(-0.168736f * r - 0.331264f * g + 0.5f * b + 128.0f);
+            v_plane[(size_t)y * chroma_width + x] = to_byte(0.5f * r - 0.418688f * g - 0.081312f * b + 128.0f);
+        }
+    }
+
+    return fputs("FRAME\n", this->stream_) >= 0 && fwrite(scratch.data(), 1, scratch.size(), this->stream_) == scratch.size();
+}
+
+void FrameCapture::stop()
+{
+    if (!this->capturing_)
+    {
+        return;
+    }
+
+    // Collect the readbacks still in flight, in submission order
+    const gl_loader::Functions &gl = gl_loader::get_functions();
+    for (int i = 0; i < PIXEL_BUFFER_COUNT; i++)
+    {
+        PixelBuffer &buffer = this->pixel_buffers_[(this->next_buffer_ + i) % PIXEL_BUFFER_COUNT];
+        if (buffer.fence != nullptr)
+        {
+            gl.glClientWaitSync(buffer.fence, gl_loader::GL_SYNC_FLUSH_COMMANDS_BIT, gl_loader::GL_TIMEOUT_IGNORED);
+            this->read_pixel_buffer(buffer);
+        }
+    }
+    for (PixelBuffer &buffer : this->pixel_buffers_)
+    {
+        gl.glDeleteBuffers(1, &buffer.id);
+        buffer = PixelBuffer();
+    }
+
+    // Let the encoder drain the queue
+    {
+        std::lock_guard<std::mutex> lock(this->mutex_);
+        this->stopping_ = true;
+    }
+    this->frame_ready_.notify_one();
+    this->encoder_.join();
+
+    if (this->stream_ != nullptr)
+    {
+        fclose(this->stream_);
+        this->stream_ = nullptr;
+    }
+    this->free_frames_.clear();
+    this->capturing_ = false;
+}
+
+bool FrameCapture::is_capturing() const
+{
+    return this->capturing_;
+}
+
+CaptureStats FrameCapture::get_stats() const
+{
+    std::lock_guard<std::mutex> lock(this->mutex_);
+    CaptureStats stats = this->stats_;
+    stats.queue_depth = this->queue_.size();
+    return stats;
+}
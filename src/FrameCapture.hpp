@@ -0,0 +1,121 @@
+#pragma once
+#include <raylib.h>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "GlLoader.hpp"
+
+/**
+ * @brief File formats written by the frame capture.
+ */
+enum class CaptureFormat
+{
+    PNG_SEQUENCE, // One PNG file per frame (frame_000000.png, frame_000001.png...) in the output directory.
+    Y4M           // Single raw YUV4MPEG2 stream (4:2:0), readable by ffmpeg and most video tools.
+};
+
+/**
+ * @brief Counters of a capture session.
+ */
+struct CaptureStats
+{
+    size_t captured_frames = 0; // Frames read back from the GPU.
+    size_t written_frames = 0;  // Frames written to disk by the encoder thread.
+    size_t dropped_frames = 0;  // Frames skipped because every pixel buffer or the encoder queue was full.
+    size_t queue_depth = 0;     // Frames waiting for the encoder thread.
+    size_t max_queue_depth = 0; // Largest queue depth of the session.
+    bool write_failed = false;  // Flag indicating whether a frame could not be written (the remaining frames are discarded).
+};
+
+/**
+ * @brief Records rendered frames to disk without stalling the render loop.
+ *
+ * Frames are copied from a render texture into a ring of pixel buffer objects (the copy runs on the GPU),
+ * mapped a few frames later once their fence is signaled and handed to an encoder thread that does the
+ * file writing. When the GPU or the encoder cannot keep up the frame is dropped instead of waiting.
+ */
+class FrameCapture
+{
+public:
+    static constexpr int PIXEL_BUFFER_COUNT = 3;     // Readbacks in flight.
+    static constexpr size_t MAX_QUEUED_FRAMES = 8;   // Frames waiting for the encoder before new frames are dropped.
+
+private:
+    /**
+     * @brief Pixel buffer receiving the readback of a frame.
+     */
+    struct PixelBuffer
+    {
+        unsigned int id = 0;                // Buffer object.
+        gl_loader::GLsync fence = nullptr;  // Fence signaled when the copy is done (null when the buffer is free).
+    };
+
+    PixelBuffer pixel_buffers_[PIXEL_BUFFER_COUNT]; // Ring of pixel buffers.
+    int next_buffer_ = 0;                           // Pixel buffer used by the next readback.
+    bool capturing_ = false;                        // Flag indicating whether a session is running.
+    CaptureFormat format_ = CaptureFormat::PNG_SEQUENCE;
+    std::string path_;                              // Output directory (PNG) or file (Y4M).
+    int width_ = 0;                                 // Width of the captured frames.
+    int height_ = 0;                                // Height of the captured frames.
+    FILE *stream_ = nullptr;                        // Output file of the Y4M format.
+
+    // Shared with the encoder thread
+    std::thread encoder_;
+    mutable std::mutex mutex_;
+    std::condition_variable frame_ready_;
+    std::deque<std::vector<unsigned char>> queue_;      // Frames waiting for the encoder (bottom-up RGBA rows).
+    std::vector<std::vector<unsigned char>> free_frames_; // Recycled frame storage, so captures do not allocate.
+    bool stopping_ = false;                             // Flag telling the encoder to exit once the queue is empty.
+    CaptureStats stats_;
+
+    void read_pixel_buffer(PixelBuffer &buffer);
+    void push_frame(const unsigned char *pixels);
+    void encode_frames();
+    bool write_png(const std::vector<unsigned char> &pixels, size_t index, std::vector<unsigned char> &scratch) const;
+    bool write_y4m(const std::vector<unsigned char> &pixels, std::vector<unsigned char> &scratch) const;
+
+public:
+    FrameCapture() = default;
+    FrameCapture(const FrameCapture &) = delete;
+    FrameCapture &operator=(const FrameCapture &) = delete;
+    ~FrameCapture();
+
+    /**
+     * @brief Starts a capture session. An OpenGL context must be current.
+     * @param path Output directory for PNG sequences (created if needed) or output file for Y4M.
+     * @param format File format.
+     * @param width Width of the frames (of the render texture that will be captured).
+     * @param height Height of the frames.
+     * @param fps Frame rate written in the Y4M header.
+     * @return True if the session started (false if pixel buffers are not supported or the output cannot be opened).
+     */
+    bool start(const std::string &path, CaptureFormat format, int width, int height, int fps = 60);
+
+    /**
+     * @brief Queues the readback of a render texture and hands the finished readbacks to the encoder.
+     * Never waits for the GPU or the disk. Call it after EndTextureMode.
+     */
+    void capture(const RenderTexture2D &target);
+
+    /**
+     * @brief Stops the session: waits for the readbacks in flight, flushes the encoder queue and closes the output.
+     */
+    void stop();
+
+    /**
+     * @brief Returns true if a session is running.
+     */
+    bool is_capturing() const;
+
+    /**
+     * @brief Gets the counters of the current (or last) session.
+     */
+    CaptureStats get_stats() const;
+};
@@ -0,0 +1,266 @@
+#include "FrameProfiler.hpp"
+#include <raylib.h>
+#include <algorithm>
+#include "imgui.h"
+#include "rlgl.h"
+
+#include "GlLoader.hpp"
+
+void FrameProfiler::set_enabled(bool enabled)
+{
+    this->enabled_ = enabled;
+    this->has_last_frame_ = false;
+}
+
+bool FrameProfiler::is_enabled() const
+{
+    return this->enabled_;
+}
+
+void FrameProfiler::begin_frame()
+{
+    if (!this->enabled_)
+    {
+        return;
+    }
+
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    if (this->has_last_frame_)
+    {
+        std::chrono::duration<float, std::milli> elapsed = now - this->last_frame_start_;
+        this->add_sample(ProfilerStage::FRAME, elapsed.count());
+    }
+    this->last_frame_start_ = now;
+    this->has_last_frame_ = true;
+
+    if (this->gpu_ready_)
+    {
+        this->collect_gpu_results(this->gpu_timers_[0], ProfilerStage::GPU_SCENE);
+        this->collect_gpu_results(this->gpu_timers_[1], ProfilerStage::GPU_GUI);
+    }
+}
+
+void FrameProfiler::add_sample(ProfilerStage stage, float milliseconds)
+{
+    History &history = this->histories_[(int)stage];
+    history.samples[history.next] = milliseconds;
+    history.next = (history.next + 1) % HISTORY_SIZE;
+    history.count = std::min(history.count + 1, HISTORY_SIZE);
+}
+
+bool FrameProfiler::load_gpu_timers()
+{
+    if (this->gpu_ready_)
+    {
+        return true;
+    }
+    const gl_loader::Functions &gl = gl_loader::get_functions();
+    if (!gl.has_timer_queries())
+    {
+        return false;
+    }
+    for (GpuTimer &timer : this->gpu_timers_)
+    {
+        gl.glGenQueries(GPU_QUERY_LATENCY, timer.queries);
+    }
+    this->gpu_ready_ = true;
+    return true;
+}
+
+FrameProfiler::GpuTimer *FrameProfiler::get_gpu_timer(ProfilerStage stage)
+{
+    switch (stage)
+    {
+    case ProfilerStage::GPU_SCENE:
+        return &this->gpu_timers_[0];
+    case ProfilerStage::GPU_GUI:
+        return &this->gpu_timers_[1];
+    default:
+        return nullptr;
+    }
+}
+
+void FrameProfiler::collect_gpu_results(GpuTimer &timer, ProfilerStage stage)
+{
+    const gl_loader::Functions &gl = gl_loader::get_functions();
+    for (int i = 0; i < GPU_QUERY_LATENCY; i++)
+    {
+        if (!timer.pending[i])
+        {
+            continue;
+        }
+        int available = 0;
+        gl.glGetQueryObjectiv(timer.queries[i], gl_loader::GL_QUERY_RESULT_AVAILABLE, &available);
+        if (available)
+        {
+            uint64_t nanoseconds = 0;
+            gl.glGetQueryObjectui64v(timer.queries[i], gl_loader::GL_QUERY_RESULT, &nanoseconds);
+            this->add_sample(stage, nanoseconds * 1e-6f);
+            timer.pending[i] = false;
+        }
+    }
+}
+
+void FrameProfiler::begin_gpu(ProfilerStage stage)
+{
+    if (!this->enabled_ || !this->load_gpu_timers())
+    {
+        return;
+    }
+    GpuTimer *timer = this->get_gpu_timer(stage);
+    // Skip the pass if every query is still waiting for its result (the GPU is several frames behind)
+    if (timer == nullptr || timer->active || timer->pending[timer->next])
+    {
+        return;
+    }
+    rlDrawRenderBatchActive();
+    gl_loader::get_functions().glBeginQuery(gl_loader::GL_TIME_ELAPSED, timer->queries[timer->next]);
+    timer->active = true;
+}
+
+void FrameProfiler::end_gpu(ProfilerStage stage)
+{
+    // Not gated on enabled_, a query started before the profiler was disabled still has to be ended
+    GpuTimer *timer = this->gpu_ready_ ? this->get_gpu_timer(stage) : nullptr;
+    if (timer == nullptr || !timer->active)
+    {
+        return;
+    }
+    rlDrawRenderBatchActive();
+    gl_loader::get_functions().glEndQuery(gl_loader::GL_TIME_ELAPSED);
+    timer->pending[timer->next] = true;
+    timer->next = (timer->next + 1) % GPU_QUERY_LATENCY;
+    timer->active = false;
+}
+
+ProfilerStats FrameProfiler::get_stats(ProfilerStage stage) const
+{
+    ProfilerStats stats;
+    const History &history = this->histories_[(int)stage];
+    if (history.count == 0)
+    {
+        return stats;
+    }
+
+    this->sorted_samples_.assign(history.samples, history.samples + history.count);
+    std::sort(this->sorted_samples_.begin(), this->sorted_samples_.end());
+
+    float sum = 0.0f;
+    for (float sample : this->sorted_samples_)
+    {
+        sum += sample;
+    }
+    auto percentile = [this](float p) -> float
+    {
+        size_t index = (size_t)(p * (this->sorted_samples_.size() - 1) + 0.5f);
+        return this->sorted_samples_[index];
+    };
+
+    stats.average = sum / history.count;
+    stats.p50 = percentile(0.50f);
+    stats.p95 = percentile(0.95f);
+    stats.p99 = percentile(0.99f);
+    stats.max = this->sorted_samples_.back();
+    stats.samples = history.count;
+    return stats;
+}
+
+const float *FrameProfiler::get_history(ProfilerStage stage, size_t &offset) const
+{
+    const History &history = this->histories_[(int)stage];
+    offset = history.count < HISTORY_SIZE ? 0 : history.next;
+    return history.samples;
+}
+
+void FrameProfiler::reset()
+{
+    for (History &history : this->histories_)
+    {
+        history = History();
+    }
+    this->has_last_frame_ = false;
+}
+
+void FrameProfiler::unload()
+{
+    if (!this->gpu_ready_)
+    {
+        return;
+    }
+    const gl_loader::Functions &gl = gl_loader::get_functions();
+    for (GpuTimer &timer : this->gpu_timers_)
+    {
+        gl.glDeleteQueries(GPU_QUERY_LATENCY, timer.queries);
+        timer = GpuTimer();
+    }
+    this->gpu_ready_ = false;
+}
+
+const char *FrameProfiler::get_stage_name(ProfilerStage stage)
+{
+    switch (stage)
+    {
+    case ProfilerStage::POSES:
+        return "Poses";
+    case ProfilerStage::CAMERA:
+        return "Camera";
+    case ProfilerStage::PICKING:
+        return "Picking";
+    case ProfilerStage::SHADOWS:
+        return "Shadows";
+    case ProfilerStage::OBJECTS:
+        return "Objects";
+    case ProfilerStage::PRIMITIVES:
+        return "Primitives";
+    case ProfilerStage::TEXT_LABELS:
+        return "Text labels";
+    case ProfilerStage::GUI:
+        return "GUI";
+    case ProfilerStage::BLIT:
+        return "Blit";
+    case ProfilerStage::PRESENT:
+        return "Present";
+    case ProfilerStage::FRAME:
+        return "Frame";
+    case ProfilerStage::GPU_SCENE:
+        return "GPU scene";
+    case ProfilerStage::GPU_GUI:
+        return "GPU GUI";
+    default:
+        return "Unknown";
+    }
+}
+
+void FrameProfiler::draw_panel()
+{
+    ImGui::Begin("Profiler");
+    bool enabled = this->enabled_;
+    if (ImGui::Checkbox("Enabled", &enabled))
+    {
+        this->set_enabled(enabled);
+    }
+    ImGui::SameLine();
+    if (ImGui::Button("Reset"))
+    {
+        this->reset();
+    }
+
+    size_t offset;
+    const float *frame_times = this->get_history(ProfilerStage::FRAME, offset);
+    ProfilerStats frame_stats = this->get_stats(ProfilerStage::FRAME);
+    ImGui::PlotLines("Frame (ms)", frame_times, HISTORY_SIZE, offset,
+                     TextFormat("avg %.2f ms", frame_stats.average), 0.0f, std::max(frame_stats.max, 1.0f) * 1.2f, ImVec2(0, 80));
+
+    ImGui::Text("%-12s %8s %8s %8s %8s", "Stage", "avg", "p50", "p95", "p99");
+    ImGui::Separator();
+    for (int i = 0; i < (int)ProfilerStage::COUNT; i++)
+    {
+        ProfilerStats stats = this->get_stats((ProfilerStage)i);
+        if (stats.samples == 0)
+        {
+            continue;
+        }
+        ImGui::Text("%-12s %8.3f %8.3f %8.3f %8.3f", get_stage_name((ProfilerStage)i), stats.average, stats.p50, stats.p95, stats.p99);
+    }
+    ImGui::End();
+}
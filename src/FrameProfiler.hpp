@@ -0,0 +1,184 @@
+#pragma once
+#include <chrono>
+#include <cstddef>
+#include <vector>
+
+/**
+ * @brief Stages of a visualizer frame measured by the profiler.
+ */
+enum class ProfilerStage
+{
+    POSES = 0,   // Applying the poses published by the simulation thread.
+    CAMERA,      // Camera update and focus.
+    PICKING,     // Mouse picking of visual objects.
+    SHADOWS,     // Drawing the shadow casters into the shadow maps.
+    OBJECTS,     // Culling and drawing the visual objects.
+    PRIMITIVES,  // Draining the per-frame primitive queues (lines, arrows, spheres...).
+    TEXT_LABELS, // Drawing the text labels.
+    GUI,         // Building and drawing the ImGui interface.
+    BLIT,        // Drawing the scene texture to the screen.
+    PRESENT,     // Swapping buffers and waiting for the target frame rate.
+    FRAME,       // Time between the start of two consecutive frames.
+    GPU_SCENE,   // GPU time of the 3D pass (render texture).
+    GPU_GUI,     // GPU time of the GUI pass.
+    COUNT
+};
+
+/**
+ * @brief Statistics of a profiler stage over the recorded window, in milliseconds.
+ */
+struct ProfilerStats
+{
+    float average = 0.0f; // Mean duration.
+    float p50 = 0.0f;     // Median duration.
+    float p95 = 0.0f;     // 95th percentile of the duration.
+    float p99 = 0.0f;     // 99th percentile of the duration.
+    float max = 0.0f;     // Longest duration.
+    size_t samples = 0;   // Number of samples the statistics are computed from.
+};
+
+/**
+ * @brief Records CPU stage timings and GPU pass timings of the last frames.
+ *
+ * CPU stages are timed with scopes, GPU passes with GL_TIME_ELAPSED queries (read back a few frames
+ * later so the CPU never waits for the GPU). When the profiler is disabled the scopes only test a flag.
+ */
+class FrameProfiler
+{
+public:
+    static constexpr size_t HISTORY_SIZE = 240; // Number of frames kept per stage.
+
+    /**
+     * @brief Measures the CPU time spent between its construction and its destruction.
+     */
+    class Scope
+    {
+    private:
+        FrameProfiler *profiler_;                          // Profiler receiving the sample (null when disabled).
+        ProfilerStage stage_;                              // Stage being measured.
+        std::chrono::steady_clock::time_point start_;      // Time at which the scope started.
+
+    public:
+        Scope(FrameProfiler &profiler, ProfilerStage stage)
+            : profiler_(profiler.enabled_ ? &profiler : nullptr), stage_(stage)
+        {
+            if (this->profiler_ != nullptr)
+            {
+                this->start_ = std::chrono::steady_clock::now();
+            }
+        }
+
+        ~Scope()
+        {
+            if (this->profiler_ != nullptr)
+            {
+                std::chrono::duration<float, std::milli> elapsed = std::chrono::steady_clock::now() - this->start_;
+                this->profiler_->add_sample(this->stage_, elapsed.count());
+            }
+        }
+
+        Scope(const Scope &) = delete;
+        Scope &operator=(const Scope &) = delete;
+    };
+
+private:
+    static constexpr int GPU_QUERY_LATENCY = 4; // Queries in flight per GPU pass.
+
+    /**
+     * @brief Ring buffer of the durations of a stage.
+     */
+    struct History
+    {
+        float samples[HISTORY_SIZE] = {0}; // Durations in milliseconds.
+        size_t next = 0;                   // Position of the next sample.
+        size_t count = 0;                  // Number of valid samples.
+    };
+
+    /**
+     * @brief Timer queries of a GPU pass.
+     */
+    struct GpuTimer
+    {
+        unsigned int queries[GPU_QUERY_LATENCY] = {0}; // Query objects.
+        bool pending[GPU_QUERY_LATENCY] = {false};      // Flags indicating whether a query result has not been read yet.
+        int next = 0;                                   // Query used by the next pass.
+        bool active = false;                            // Flag indicating whether a query is running.
+    };
+
+    bool enabled_ = false;                                   // Flag indicating whether samples are recorded.
+    bool gpu_ready_ = false;                                 // Flag indicating whether the timer queries are created.
+    History histories_[(int)ProfilerStage::COUNT];           // Recorded durations per stage.
+    GpuTimer gpu_timers_[2];                                 // Timers of the GPU_SCENE and GPU_GUI passes.
+    std::chrono::steady_clock::time_point last_frame_start_; // Start of the previous frame.
+    bool has_last_frame_ = false;                            // Flag indicating whether last_frame_start_ is valid.
+    mutable std::vector<float> sorted_samples_;              // Scratch buffer used to compute percentiles.
+
+    bool load_gpu_timers();
+    GpuTimer *get_gpu_timer(ProfilerStage stage);
+    void collect_gpu_results(GpuTimer &timer, ProfilerStage stage);
+
+public:
+    /**
+     * @brief Enables or disables the recording (recorded samples are kept).
+     */
+    void set_enabled(bool enabled);
+
+    /**
+     * @brief Returns true if the profiler is recording.
+     */
+    bool is_enabled() const;
+
+    /**
+     * @brief Marks the start of a frame: records the FRAME stage and reads the finished GPU queries.
+     */
+    void begin_frame();
+
+    /**
+     * @brief Adds a duration to a stage.
+     * @param stage Stage.
+     * @param milliseconds Duration in milliseconds.
+     */
+    void add_sample(ProfilerStage stage, float milliseconds);
+
+    /**
+     * @brief Starts timing a GPU pass (GPU_SCENE or GPU_GUI). Flushes the pending rlgl batch.
+     */
+    void begin_gpu(ProfilerStage stage);
+
+    /**
+     * @brief Stops timing a GPU pass. Flushes the pending rlgl batch.
+     */
+    void end_gpu(ProfilerStage stage);
+
+    /**
+     * @brief Gets the statistics of a stage over the recorded frames.
+     */
+    ProfilerStats get_stats(ProfilerStage stage) const;
+
+    /**
+     * @brief Gets the recorded durations of a stage (ring buffer of HISTORY_SIZE samples).
+     * @param offset Output position of the oldest sample.
+     * @return Pointer to the samples.
+     */
+    const float *get_history(ProfilerStage stage, size_t &offset) const;
+
+    /**
+     * @brief Removes all the recorded samples.
+     */
+    void reset();
+
+    /**
+     * @brief Deletes the GPU queries. Safe to call more than once.
+     */
+    void unload();
+
+    /**
+     * @brief Gets the display name of a stage.
+     */
+    static const char *get_stage_name(ProfilerStage stage);
+
+    /**
+     * @brief Draws the profiler panel (statistics table and frame time graph) with ImGui.
+     */
+    void draw_panel();
+};
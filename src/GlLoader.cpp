@@ -0,0 +1,88 @@
+#include "GlLoader.hpp"
+
+// GLFW is linked in by desktop raylib, the weak declaration resolves to null when it is not
+#if defined(__GNUC__) || defined(__clang__)
+typedef void (*GLFWglproc)(void);
+extern "C" GLFWglproc glfwGetProcAddress(const char *procname) __attribute__((weak));
+#define GL_LOADER_HAS_GLFW 1
+#else
+#define GL_LOADER_HAS_GLFW 0
+#endif
+
+namespace gl_loader
+{
+    namespace
+    {
+        template <typename Proc>
+        void load_function(Proc &function, const char *name)
+        {
+#if GL_LOADER_HAS_GLFW
+            if (glfwGetProcAddress != nullptr)
+            {
+                function = reinterpret_cast<Proc>(glfwGetProcAddress(name));
+            }
+#else
+            (void)name;
+#endif
+        }
+    }
+
+    bool Functions::has_timer_queries() const
+    {
+        return this->glGenQueries != nullptr && this->glDeleteQueries != nullptr &&
+               this->glBeginQuery != nullptr && this->glEndQuery != nullptr &&
+               this->glGetQueryObjectiv != nullptr && this->glGetQueryObjectui64v != nullptr;
+    }
+
+    bool Functions::has_pixel_buffers() const
+    {
+        return this->glGenBuffers != nullptr && this->glDeleteBuffers != nullptr && this->glBindBuffer != nullptr &&
+               this->glBufferData != nullptr && this->glMapBufferRange != nullptr && this->glUnmapBuffer != nullptr &&
+               this->glBindFramebuffer != nullptr && this->glReadPixels != nullptr && this->glFenceSync != nullptr &&
+               this->glClientWaitSync != nullptr && this->glDeleteSync != nullptr;
+    }
+
+    bool Functions::has_uniform_buffers() const
+    {
+        return this->glGenBuffers != nullptr && this->glDeleteBuffers != nullptr && this->glBindBuffer != nullptr &&
+               this->glBufferData != nullptr && this->glBufferSubData != nullptr && this->glBindBufferBase != nullptr &&
+               this->glGetUniformBlockIndex != nullptr && this->glUniformBlockBinding != nullptr;
+    }
+
+    const Functions &get_functions()
+    {
+        static Functions functions;
+        static bool loaded = false;
+        if (!loaded)
+        {
+            load_function(functions.glGenQueries, "glGenQueries");
+            load_function(functions.glDeleteQueries, "glDeleteQueries");
+            load_function(functions.glBeginQuery, "glBeginQuery");
+            load_function(functions.glEndQuery, "glEndQuery");
+            load_function(functions.glGetQueryObjectiv, "glGetQueryObjectiv");
+            load_function(functions.glGetQueryObjectui64v, "glGetQueryObjectui64v");
+            load_function(functions.glGenBuffers, "glGenBuffers");
+            load_function(functions.glDeleteBuffers, "glDeleteBuffers");
+            load_function(functions.glBindBuffer, "glBindBuffer");
+            load_function(functions.glBufferData, "glBufferData");
+            load_function(functions.glMapBufferRange, "glMapBufferRange");
+            load_function(functions.glUnmapBuffer, "glUnmapBuffer");
+            load_function(functions.glBindFramebuffer, "glBindFramebuffer");
+            load_function(functions.glReadPixels, "glReadPixels");
+            load_function(functions.glFenceSync, "glFenceSync");
+            load_function(functions.glClientWaitSync, "glClientWaitSync");
+            load_function(functions.glDeleteSync, "glDeleteSync");
+            load_function(functions.glDrawElements, "glDrawElements");
+            load_function(functions.glMultiDrawArrays, "glMultiDrawArrays");
+            load_function(functions.glDrawArrays, "glDrawArrays");
+            load_function(functions.glEnable, "glEnable");
+            load_function(functions.glDisable, "glDisable");
+            load_function(functions.glBufferSubData, "glBufferSubData");
+            load_function(functions.glBindBufferBase, "glBindBufferBase");
+            load_function(functions.glGetUniformBlockIndex, "glGetUniformBlockIndex");
+            load_function(functions.glUniformBlockBinding, "glUniformBlockBinding");
+            loaded = true;
+        }
+        return functions;
+    }
+}
@@ -0,0 +1,123 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+#if defined(_WIN32) && !defined(_WIN64)
+#define GL_LOADER_APIENTRY __stdcall
+#else
+#define GL_LOADER_APIENTRY
+#endif
+
+/**
+ * @brief Minimal loader for the OpenGL functions rlgl does not expose (timer queries, pixel buffers, uniform buffers, line, point and multi draws).
+ *
+ * The entry points are resolved through GLFW (the platform layer of desktop raylib), looked up as a weak
+ * symbol so builds using another platform layer still link. Functions that cannot be resolved stay null
+ * and the features using them turn themselves off.
+ */
+namespace gl_loader
+{
+    constexpr unsigned int GL_TIME_ELAPSED = 0x88BF;
+    constexpr unsigned int GL_QUERY_RESULT = 0x8866;
+    constexpr unsigned int GL_QUERY_RESULT_AVAILABLE = 0x8867;
+    constexpr unsigned int GL_PIXEL_PACK_BUFFER = 0x88EB;
+    constexpr unsigned int GL_STREAM_READ = 0x88E1;
+    constexpr unsigned int GL_MAP_READ_BIT = 0x0001;
+    constexpr unsigned int GL_READ_FRAMEBUFFER = 0x8CA8;
+    constexpr unsigned int GL_RGBA = 0x1908;
+    constexpr unsigned int GL_UNSIGNED_BYTE = 0x1401;
+    constexpr unsigned int GL_SYNC_GPU_COMMANDS_COMPLETE = 0x9117;
+    constexpr unsigned int GL_ALREADY_SIGNALED = 0x911A;
+    constexpr unsigned int GL_CONDITION_SATISFIED = 0x911C;
+    constexpr unsigned int GL_SYNC_FLUSH_COMMANDS_BIT = 0x0001;
+    constexpr uint64_t GL_TIMEOUT_IGNORED = 0xFFFFFFFFFFFFFFFFull;
+    constexpr unsigned int GL_LINES = 0x0001;
+    constexpr unsigned int GL_LINE_STRIP = 0x0003;
+    constexpr unsigned int GL_POINTS = 0x0000;
+    constexpr unsigned int GL_PROGRAM_POINT_SIZE = 0x8642;
+    constexpr unsigned int GL_UNSIGNED_INT = 0x1405;
+    constexpr unsigned int GL_UNIFORM_BUFFER = 0x8A11;
+    constexpr unsigned int GL_DYNAMIC_DRAW = 0x88E8;
+    constexpr unsigned int GL_INVALID_INDEX = 0xFFFFFFFFu;
+
+    using GLsync = struct __GLsync *;
+
+    using GenQueriesProc = void(GL_LOADER_APIENTRY *)(int n, unsigned int *ids);
+    using DeleteQueriesProc = void(GL_LOADER_APIENTRY *)(int n, const unsigned int *ids);
+    using BeginQueryProc = void(GL_LOADER_APIENTRY *)(unsigned int target, unsigned int id);
+    using EndQueryProc = void(GL_LOADER_APIENTRY *)(unsigned int target);
+    using GetQueryObjectivProc = void(GL_LOADER_APIENTRY *)(unsigned int id, unsigned int pname, int *params);
+    using GetQueryObjectui64vProc = void(GL_LOADER_APIENTRY *)(unsigned int id, unsigned int pname, uint64_t *params);
+    using GenBuffersProc = void(GL_LOADER_APIENTRY *)(int n, unsigned int *buffers);
+    using DeleteBuffersProc = void(GL_LOADER_APIENTRY *)(int n, const unsigned int *buffers);
+    using BindBufferProc = void(GL_LOADER_APIENTRY *)(unsigned int target, unsigned int buffer);
+    using BufferDataProc = void(GL_LOADER_APIENTRY *)(unsigned int target, ptrdiff_t size, const void *data, unsigned int usage);
+    using MapBufferRangeProc = void *(GL_LOADER_APIENTRY *)(unsigned int target, ptrdiff_t offset, ptrdiff_t length, unsigned int access);
+    using UnmapBufferProc = unsigned char(GL_LOADER_APIENTRY *)(unsigned int target);
+    using BindFramebufferProc = void(GL_LOADER_APIENTRY *)(unsigned int target, unsigned int framebuffer);
+    using ReadPixelsProc = void(GL_LOADER_APIENTRY *)(int x, int y, int width, int height, unsigned int format, unsigned int type, void *pixels);
+    using FenceSyncProc = GLsync(GL_LOADER_APIENTRY *)(unsigned int condition, unsigned int flags);
+    using ClientWaitSyncProc = unsigned int(GL_LOADER_APIENTRY *)(GLsync sync, unsigned int flags, uint64_t timeout);
+    using DeleteSyncProc = void(GL_LOADER_APIENTRY *)(GLsync sync);
+    using DrawElementsProc = void(GL_LOADER_APIENTRY *)(unsigned int mode, int count, unsigned int type, const void *indices);
+    using DrawArraysProc = void(GL_LOADER_APIENTRY *)(unsigned int mode, int first, int count);
+    using EnableProc = void(GL_LOADER_APIENTRY *)(unsigned int capability);
+    using MultiDrawArraysProc = void(GL_LOADER_APIENTRY *)(unsigned int mode, const int *first, const int *count, int draw_count);
+    using BufferSubDataProc = void(GL_LOADER_APIENTRY *)(unsigned int target, ptrdiff_t offset, ptrdiff_t size, const void *data);
+    using BindBufferBaseProc = void(GL_LOADER_APIENTRY *)(unsigned int target, unsigned int index, unsigned int buffer);
+    using GetUniformBlockIndexProc = unsigned int(GL_LOADER_APIENTRY *)(unsigned int program, const char *name);
+    using UniformBlockBindingProc = void(GL_LOADER_APIENTRY *)(unsigned int program, unsigned int block_index, unsigned int binding);
+
+    /**
+     * @brief OpenGL entry points resolved by the loader (null when not available).
+     */
+    struct Functions
+    {
+        GenQueriesProc glGenQueries = nullptr;
+        DeleteQueriesProc glDeleteQueries = nullptr;
+        BeginQueryProc glBeginQuery = nullptr;
+        EndQueryProc glEndQuery = nullptr;
+        GetQueryObjectivProc glGetQueryObjectiv = nullptr;
+        GetQueryObjectui64vProc glGetQueryObjectui64v = nullptr;
+        GenBuffersProc glGenBuffers = nullptr;
+        DeleteBuffersProc glDeleteBuffers = nullptr;
+        BindBufferProc glBindBuffer = nullptr;
+        BufferDataProc glBufferData = nullptr;
+        MapBufferRangeProc glMapBufferRange = nullptr;
+        UnmapBufferProc glUnmapBuffer = nullptr;
+        BindFramebufferProc glBindFramebuffer = nullptr;
+        ReadPixelsProc glReadPixels = nullptr;
+        FenceSyncProc glFenceSync = nullptr;
+        ClientWaitSyncProc glClientWaitSync = nullptr;
+        DeleteSyncProc glDeleteSync = nullptr;
+        DrawElementsProc glDrawElements = nullptr;
+        MultiDrawArraysProc glMultiDrawArrays = nullptr;
+        DrawArraysProc glDrawArrays = nullptr;
+        EnableProc glEnable = nullptr;
+        EnableProc glDisable = nullptr;
+        BufferSubDataProc glBufferSubData = nullptr;
+        BindBufferBaseProc glBindBufferBase = nullptr;
+        GetUniformBlockIndexProc glGetUniformBlockIndex = nullptr;
+        UniformBlockBindingProc glUniformBlockBinding = nullptr;
+
+        /**
+         * @brief Returns true if the GL_TIME_ELAPSED query functions are available.
+         */
+        bool has_timer_queries() const;
+
+        /**
+         * @brief Returns true if the functions needed for asynchronous pixel readback (pixel buffers and fences) are available.
+         */
+        bool has_pixel_buffers() const;
+
+        /**
+         * @brief Returns true if the functions needed to fill and bind uniform buffers are available.
+         */
+        bool has_uniform_buffers() const;
+    };
+
+    /**
+     * @brief Gets the OpenGL functions, resolving them on the first call (an OpenGL context must be current).
+     */
+    const Functions &get_functions();
+}
@@ -0,0 +1,287 @@
+#include "InstancedRenderer.hpp"
+#include <algorithm>
+#include <cstddef>
+#include <string>
+
+void InstancedRenderer::load()
+{
+    if (this->ready_)
+    {
+        return;
+    }
+
+    // SHADER_BASE_PATH is defined in the CMAKE file
+    std::string vs_path = std::string(SHADER_BASE_PATH) + "/instanced.vs";
+    std::string fs_path = std::string(SHADER_BASE_PATH) + "/instanced.fs";
+    this->shader_ = LoadShader(vs_path.c_str(), fs_path.c_str());
+
+    // raylib falls back to the default shader if the instancing shader fails to compile
+    if (this->shader_.id == 0 || this->shader_.id == rlGetShaderIdDefault())
+    {
+        TraceLog(LOG_WARNING, "ROBOVIS: Instancing shader not available, using immediate mode primitives");
+        return;
+    }
+
+    this->view_projection_loc_ = GetShaderLocation(this->shader_, "matViewProjection");
+    this->transform_attrib_loc_ = GetShaderLocationAttrib(this->shader_, "instanceTransform");
+    this->color_attrib_loc_ = GetShaderLocationAttrib(this->shader_, "instanceColor");
+
+    this->batches_[(int)InstancedPrimitive::CYLINDER].mesh = GenMeshCylinder(1.0f, 1.0f, 16);
+    this->batches_[(int)InstancedPrimitive::CONE].mesh = GenMeshCone(1.0f, 1.0f, 20);
+    this->batches_[(int)InstancedPrimitive::SPHERE].mesh = GenMeshSphere(1.0f, 16, 16);
+
+    this->ready_ = true;
+}
+
+void InstancedRenderer::unload()
+{
+    if (!this->ready_)
+    {
+        return;
+    }
+
+    for (auto &batch : this->batches_)
+    {
+        if (batch.instance_vbo != 0)
+        {
+            rlUnloadVertexBuffer(batch.instance_vbo);
+        }
+        UnloadMesh(batch.mesh);
+        batch = Batch();
+    }
+    if (this->surface_vao_ != 0)
+    {
+        rlUnloadVertexBuffer(this->surface_vertex_vbo_);
+        rlUnloadVertexBuffer(this->surface_color_vbo_);
+        rlUnloadVertexArray(this->surface_vao_);
+    }
+    this->surface_vao_ = 0;
+    this->surface_vertex_vbo_ = 0;
+    this->surface_color_vbo_ = 0;
+    this->surface_capacity_ = 0;
+    UnloadShader(this->shader_);
+    this->shader_ = {0};
+    this->ready_ = false;
+}
+
+bool InstancedRenderer::is_ready() const
+{
+    return this->ready_;
+}
+
+void InstancedRenderer::bind_instance_buffer(Batch &batch)
+{
+    rlEnableVertexArray(batch.mesh.vaoId);
+    rlEnableVertexBuffer(batch.instance_vbo);
+
+    // A mat4 attribute takes four consecutive locations, one per column
+    for (int i = 0; i < 4; i++)
+    {
+        rlEnableVertexAttribute(this->transform_attrib_loc_ + i);
+        du::set_vertex_attribute(this->transform_attrib_loc_ + i, 4, RL_FLOAT, false, sizeof(InstanceData), i * 4 * sizeof(float));
+        rlSetVertexAttributeDivisor(this->transform_attrib_loc_ + i, 1);
+    }
+
+    if (this->color_attrib_loc_ >= 0)
+    {
+        rlEnableVertexAttribute(this->color_attrib_loc_);
+        du::set_vertex_attribute(this->color_attrib_loc_, 4, RL_FLOAT, false, sizeof(InstanceData), offsetof(InstanceData, color));
+        rlSetVertexAttributeDivisor(this->color_attrib_loc_, 1);
+    }
+
+    rlDisableVertexBuffer();
+    rlDisableVertexArray();
+}
+
+void InstancedRenderer::upload_instances(Batch &batch)
+{
+    size_t count = batch.instances.size();
+    if (count > batch.capacity)
+    {
+        if (batch.instance_vbo != 0)
+        {
+            rlUnloadVertexBuffer(batch.instance_vbo);
+        }
+        // Grow geometrically so that a slowly increasing number of primitives does not reallocate every frame
+        batch.capacity = std::max(count, std::max(batch.capacity * 2, (size_t)256));
+        batch.instance_vbo = rlLoadVertexBuffer(nullptr, batch.capacity * sizeof(InstanceData), true);
+        this->bind_instance_buffer(batch);
+    }
+    rlUpdateVertexBuffer(batch.instance_vbo, batch.instances.data(), count * sizeof(InstanceData), 0);
+}
+
+void InstancedRenderer::add_instance(InstancedPrimitive primitive, const Matrix &transform, Color color)
+{
+    this->batches_[(int)primitive].instances.push_back(InstanceData{
+        .transform = MatrixToFloatV(transform),
+        .color = ColorNormalize(color)});
+}
+
+void InstancedRenderer::add_arrow(Vector3 start_position, Vector3 end_position, float radius, Color color)
+{
+    if (!this->ready_)
+    {
+        du::draw_arrow(start_position, end_position, color, radius);
+        return;
+    }
+    Vector3 dir_vector = Vector3Subtract(end_position, start_position);
+    Vector3 tip_start_pos = Vector3Add(start_position, Vector3Scale(dir_vector, 0.9));
+
+    this->add_instance(InstancedPrimitive::CYLINDER, du::get_segment_transform(start_position, tip_start_pos, radius), color);
+    this->add_instance(InstancedPrimitive::CONE, du::get_segment_transform(tip_start_pos, end_position, radius * 2.0), color);
+}
+
+void InstancedRenderer::add_segment(Vector3 p_1, Vector3 p_2, float scale, Color color)
+{
+    if (!this->ready_)
+    {
+        du::draw_segment(p_1, p_2, color, scale);
+        return;
+    }
+    float radius = scale * 0.03;
+
+    this->add_instance(InstancedPrimitive::CYLINDER, du::get_segment_transform(p_1, p_2, radius), color);
+    this->add_sphere(p_1, radius * 1.5, color);
+    this->add_sphere(p_2, radius * 1.5, color);
+}
+
+void InstancedRenderer::add_sphere(Vector3 position, float radius, Color color)
+{
+    if (!this->ready_)
+    {
+        DrawSphere(position, radius, color);
+        return;
+    }
+    Matrix transform = MatrixMultiply(MatrixScale(radius, radius, radius), MatrixTranslate(position.x, position.y, position.z));
+    this->add_instance(InstancedPrimitive::SPHERE, transform, color);
+}
+
+void InstancedRenderer::add_disc(Vector3 center, Vector3 axis, float radius, Color color)
+{
+    if (!this->ready_)
+    {
+        du::draw_disc_section(center, axis, radius, color);
+        return;
+    }
+    this->add_ring_section(center, axis, 0.0f, radius, 2.0f * PI, 0.0f, color);
+}
+
+void InstancedRenderer::add_ring_section(Vector3 center, Vector3 axis, float r_1, float r_2, float angle_f, float angle_o, Color color)
+{
+    if (!this->ready_)
+    {
+        du::draw_ring_section(center, axis, r_1, r_2, angle_f, angle_o, color);
+        return;
+    }
+    size_t first = this->surface_vertices_.size();
+    du::gen_ring_section_triangles(this->surface_vertices_, center, axis, r_1, r_2, angle_f, angle_o, this->circle_segments_);
+    this->surface_colors_.resize(this->surface_vertices_.size(), color);
+    std::fill(this->surface_colors_.begin() + first, this->surface_colors_.end(), color);
+}
+
+void InstancedRenderer::set_circle_segments(int segments)
+{
+    this->circle_segments_ = std::clamp(segments, 3, du::MAX_CIRCLE_SEGMENTS);
+}
+
+void InstancedRenderer::add_axes(Vector3 position, Quaternion orientation, float scale)
+{
+    if (!this->ready_)
+    {
+        du::draw_axes(position, orientation, scale);
+        return;
+    }
+    float lenght = 1.0 * (scale < 0.0 ? 0.0 : scale);
+    float radius = lenght * 0.03;
+    orientation = QuaternionNormalize(orientation);
+    this->add_arrow(position, Vector3Add(position, Vector3RotateByQuaternion({lenght, 0.0, 0.0}, orientation)), radius, RED);
+    this->add_arrow(position, Vector3Add(position, Vector3RotateByQuaternion({0.0, lenght, 0.0}, orientation)), radius, GREEN);
+    this->add_arrow(position, Vector3Add(position, Vector3RotateByQuaternion({0.0, 0.0, lenght}, orientation)), radius, BLUE);
+}
+
+void InstancedRenderer::draw()
+{
+    if (!this->ready_)
+    {
+        return;
+    }
+
+    // Flush the immediate mode geometry queued so far so that it keeps its draw order
+    rlDrawRenderBatchActive();
+
+    rlEnableShader(this->shader_.id);
+    Matrix view_projection = MatrixMultiply(rlGetMatrixModelview(), rlGetMatrixProjection());
+    rlSetUniformMatrix(this->view_projection_loc_, view_projection);
+
+    for (auto &batch : this->batches_)
+    {
+        if (batch.instances.empty())
+        {
+            continue;
+        }
+        this->upload_instances(batch);
+
+        rlEnableVertexArray(batch.mesh.vaoId);
+        if (batch.mesh.indices != nullptr)
+        {
+            rlDrawVertexArrayElementsInstanced(0, batch.mesh.triangleCount * 3, 0, batch.instances.size());
+        }
+        else
+        {
+            rlDrawVertexArrayInstanced(0, batch.mesh.vertexCount, batch.instances.size());
+        }
+        rlDisableVertexArray();
+        batch.instances.clear();
+    }
+
+    rlDisableShader();
+    this->draw_surfaces();
+}
+
+void InstancedRenderer::draw_surfaces()
+{
+    size_t count = this->surface_vertices_.size();
+    if (count == 0)
+    {
+        return;
+    }
+
+    if (count > this->surface_capacity_)
+    {
+        if (this->surface_vao_ == 0)
+        {
+            this->surface_vao_ = rlLoadVertexArray();
+        }
+        else
+        {
+            rlUnloadVertexBuffer(this->surface_vertex_vbo_);
+            rlUnloadVertexBuffer(this->surface_color_vbo_);
+        }
+        this->surface_capacity_ = std::max(count, std::max(this->surface_capacity_ * 2, (size_t)4096));
+
+        rlEnableVertexArray(this->surface_vao_);
+        this->surface_vertex_vbo_ = rlLoadVertexBuffer(nullptr, this->surface_capacity_ * sizeof(Vector3), true);
+        rlEnableVertexBuffer(this->surface_vertex_vbo_);
+        du::set_vertex_attribute(RL_DEFAULT_SHADER_ATTRIB_LOCATION_POSITION, 3, RL_FLOAT, false, 0, 0);
+        rlEnableVertexAttribute(RL_DEFAULT_SHADER_ATTRIB_LOCATION_POSITION);
+        this->surface_color_vbo_ = rlLoadVertexBuffer(nullptr, this->surface_capacity_ * sizeof(Color), true);
+        rlEnableVertexBuffer(this->surface_color_vbo_);
+        du::set_vertex_attribute(RL_DEFAULT_SHADER_ATTRIB_LOCATION_COLOR, 4, RL_UNSIGNED_BYTE, true, 0, 0);
+        rlEnableVertexAttribute(RL_DEFAULT_SHADER_ATTRIB_LOCATION_COLOR);
+        rlDisableVertexBuffer();
+        rlDisableVertexArray();
+    }
+    rlUpdateVertexBuffer(this->surface_vertex_vbo_, this->surface_vertices_.data(), count * sizeof(Vector3), 0);
+    rlUpdateVertexBuffer(this->surface_color_vbo_, this->surface_colors_.data(), count * sizeof(Color), 0);
+
+    du::enable_default_shader();
+    rlDisableBackfaceCulling();
+    rlEnableVertexArray(this->surface_vao_);
+    rlDrawVertexArray(0, count);
+    rlDisableVertexArray();
+    rlEnableBackfaceCulling();
+    du::disable_default_shader();
+
+    this->surface_vertices_.clear();
+    this->surface_colors_.clear();
+}
@@ -0,0 +1,145 @@
+#pragma once
+#include <raylib.h>
+#include <raymath.h>
+#include <vector>
+#include "rlgl.h"
+
+#include "DrawingUtils.hpp"
+
+/**
+ * @brief Unit primitives that can be drawn by the instanced renderer.
+ */
+enum class InstancedPrimitive
+{
+    CYLINDER = 0, // Cylinder of radius 1 going from y = 0 to y = 1.
+    CONE,         // Cone of base radius 1 going from y = 0 (base) to y = 1 (apex).
+    SPHERE,       // Sphere of radius 1 centered at the origin.
+    COUNT
+};
+
+/**
+ * @brief Per-instance data uploaded to the GPU.
+ */
+struct InstanceData
+{
+    float16 transform; // Model matrix of the instance (column major).
+    Vector4 color;     // Normalized color of the instance.
+};
+
+/**
+ * @brief Draws the per-frame primitives (arrows, segments, spheres, discs, rings) with one draw call per primitive kind.
+ *
+ * A single unit mesh per primitive kind is kept on the GPU, every primitive pushed during the frame
+ * is stored as a transform and a color, and draw() uploads and renders each batch at once.
+ * Discs and ring sections (whose shape depends on their radii and angles) are written as triangles into
+ * one shared vertex buffer, drawn two sided with a single call.
+ * If the instancing shader cannot be loaded the add_* functions fall back to the immediate mode drawing utils.
+ */
+class InstancedRenderer
+{
+private:
+    /**
+     * @brief Instances of a single primitive kind accumulated for the current frame.
+     */
+    struct Batch
+    {
+        Mesh mesh = {0};                      // Unit mesh of the primitive.
+        std::vector<InstanceData> instances;  // Instances to be drawn this frame.
+        unsigned int instance_vbo = 0;        // GPU buffer holding the instance data.
+        size_t capacity = 0;                  // Number of instances the GPU buffer can hold.
+    };
+
+    Batch batches_[(int)InstancedPrimitive::COUNT]; // One batch per primitive kind.
+    Shader shader_ = {0};                           // Instancing shader.
+    int view_projection_loc_ = -1;                  // Location of the view-projection matrix uniform.
+    int transform_attrib_loc_ = -1;                 // Location of the (first column of the) instance transform attribute.
+    int color_attrib_loc_ = -1;                     // Location of the instance color attribute.
+    bool ready_ = false;                            // Flag indicating whether the GPU resources are loaded.
+    std::vector<Vector3> surface_vertices_;         // Triangles of the discs and rings of the frame (three vertices per triangle).
+    std::vector<Color> surface_colors_;             // Color of every surface vertex.
+    unsigned int surface_vao_ = 0;                  // Vertex array of the surface buffers.
+    unsigned int surface_vertex_vbo_ = 0;           // GPU buffer holding the surface vertices.
+    unsigned int surface_color_vbo_ = 0;            // GPU buffer holding the surface colors.
+    size_t surface_capacity_ = 0;                   // Number of vertices the surface buffers can hold.
+    int circle_segments_ = 32;                      // Segments of the discs and ring sections.
+
+    /**
+     * @brief Attaches the instance buffer of a batch to the vertex array of its mesh.
+     */
+    void bind_instance_buffer(Batch &batch);
+
+    /**
+     * @brief Uploads the instances of a batch, growing the GPU buffer if needed.
+     */
+    void upload_instances(Batch &batch);
+
+    /**
+     * @brief Uploads and draws the disc and ring triangles with the default shader, culling disabled.
+     */
+    void draw_surfaces();
+
+public:
+    /**
+     * @brief Loads the unit meshes and the instancing shader. Requires an active OpenGL context.
+     */
+    void load();
+
+    /**
+     * @brief Unloads all the GPU resources. Safe to call more than once.
+     */
+    void unload();
+
+    /**
+     * @brief Returns true if the instanced path is available.
+     */
+    bool is_ready() const;
+
+    /**
+     * @brief Adds an instance of a unit primitive.
+     * @param primitive Kind of primitive.
+     * @param transform Model matrix applied to the unit primitive.
+     * @param color Color of the instance.
+     */
+    void add_instance(InstancedPrimitive primitive, const Matrix &transform, Color color);
+
+    /**
+     * @brief Adds an arrow going from start_position to end_position (same shape as du::draw_arrow).
+     */
+    void add_arrow(Vector3 start_position, Vector3 end_position, float radius, Color color);
+
+    /**
+     * @brief Adds a segment between p_1 and p_2 (same shape as du::draw_segment).
+     */
+    void add_segment(Vector3 p_1, Vector3 p_2, float scale, Color color);
+
+    /**
+     * @brief Adds a sphere.
+     */
+    void add_sphere(Vector3 position, float radius, Color color);
+
+    /**
+     * @brief Adds a full disc facing the given axis (same shape as du::draw_disc_section).
+     */
+    void add_disc(Vector3 center, Vector3 axis, float radius, Color color);
+
+    /**
+     * @brief Adds a ring section facing the given axis (same shape as du::draw_ring_section).
+     */
+    void add_ring_section(Vector3 center, Vector3 axis, float r_1, float r_2, float angle_f, float angle_o, Color color);
+
+    /**
+     * @brief Sets the number of segments of the discs and ring sections (clamped to [3, du::MAX_CIRCLE_SEGMENTS]).
+     */
+    void set_circle_segments(int segments);
+
+    /**
+     * @brief Adds the three arrows of a coordinate frame (same shape as du::draw_axes).
+     */
+    void add_axes(Vector3 position, Quaternion orientation, float scale = 1.0);
+
+    /**
+     * @brief Draws all the accumulated instances and clears the batches.
+     * Must be called between BeginMode3D and EndMode3D.
+     */
+    void draw();
+};
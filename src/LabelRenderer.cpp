@@ -0,0 +1,269 @@
+#include "LabelRenderer.hpp"
+#include <algorithm>
+#include "rlgl.h"
+
+namespace
+{
+    constexpr float SPACING_RATIO = 0.3f;     // Space between the characters, relative to the font size.
+    constexpr float LINE_HEIGHT_RATIO = 1.2f; // Distance between the lines, relative to the font size.
+    constexpr float BACKGROUND_MARGIN = 0.05f; // Margin of the background around the text, relative to the text size.
+}
+
+bool LabelRenderer::load_sdf_font(const char *path, int base_size)
+{
+    if (this->sdf_loaded_)
+    {
+        UnloadFont(this->sdf_font_);
+        UnloadShader(this->sdf_shader_);
+        this->sdf_loaded_ = false;
+    }
+
+    int data_size = 0;
+    unsigned char *data = LoadFileData(path, &data_size);
+    if (data == nullptr)
+    {
+        return false;
+    }
+    Font font = {0};
+    font.baseSize = base_size;
+    font.glyphCount = 95; // Printable ASCII characters
+    font.glyphs = LoadFontData(data, data_size, base_size, nullptr, font.glyphCount, FONT_SDF);
+    UnloadFileData(data);
+    if (font.glyphs == nullptr)
+    {
+        return false;
+    }
+    Image atlas = GenImageFontAtlas(font.glyphs, &font.recs, font.glyphCount, base_size, 0, 1);
+    font.texture = LoadTextureFromImage(atlas);
+    UnloadImage(atlas);
+    SetTextureFilter(font.texture, TEXTURE_FILTER_BILINEAR);
+
+    // SHADER_BASE_PATH is defined in the CMAKE file
+    std::string fs_path = std::string(SHADER_BASE_PATH) + "/sdf.fs";
+    Shader shader = LoadShader(nullptr, fs_path.c_str());
+    if (shader.id == 0 || shader.id == rlGetShaderIdDefault())
+    {
+        TraceLog(LOG_WARNING, "ROBOVIS: Distance field shader not available, using the default font for the labels");
+        UnloadFont(font);
+        return false;
+    }
+    this->sdf_font_ = font;
+    this->sdf_shader_ = shader;
+    this->sdf_loaded_ = true;
+    return true;
+}
+
+void LabelRenderer::unload()
+{
+    if (this->sdf_loaded_)
+    {
+        UnloadFont(this->sdf_font_);
+        UnloadShader(this->sdf_shader_);
+    }
+    this->sdf_font_ = {0};
+    this->sdf_shader_ = {0};
+    this->sdf_loaded_ = false;
+    // Texture ids can be reused by new fonts, the layouts must not outlive their atlas
+    this->layouts_.clear();
+    this->cached_layouts_ = 0;
+}
+
+void LabelRenderer::begin(const Camera &camera, int width, int height)
+{
+    // Same matrices as GetWorldToScreenEx, computed once per frame instead of once per label
+    Matrix projection;
+    if (camera.projection == CAMERA_ORTHOGRAPHIC)
+    {
+        double aspect = (double)width / height;
+        double top = camera.fovy / 2.0;
+        projection = MatrixOrtho(-top * aspect, top * aspect, -top, top, 0.01, 1000.0);
+    }
+    else
+    {
+        projection = MatrixPerspective(camera.fovy * DEG2RAD, (double)width / height, RL_CULL_DISTANCE_NEAR, RL_CULL_DISTANCE_FAR);
+    }
+    Matrix view = MatrixLookAt(camera.position, camera.target, camera.up);
+    this->view_projection_ = MatrixMultiply(view, projection);
+    this->camera_position_ = camera.position;
+    this->camera_forward_ = Vector3Normalize(Vector3Subtract(camera.target, camera.position));
+    this->width_ = width;
+    this->height_ = height;
+    this->queued_.clear();
+    this->rejected_labels_ = 0;
+}
+
+LabelRenderer::Layout &LabelRenderer::get_layout(const Font &font, const std::string &text)
+{
+    std::unordered_map<std::string, Layout> &font_layouts = this->layouts_[font.texture.id];
+    auto found = font_layouts.find(text);
+    if (found != font_layouts.end())
+    {
+        return found->second;
+    }
+
+    // Same layout as DrawTextEx, at the base size of the font
+    Layout &layout = font_layouts[text];
+    this->cached_layouts_++;
+    float spacing = SPACING_RATIO * font.baseSize;
+    float padding = font.glyphPadding;
+    float x = 0.0f;
+    float y = 0.0f;
+    float width = 0.0f;
+    for (size_t i = 0; i < text.size();)
+    {
+        int codepoint_size = 0;
+        int codepoint = GetCodepointNext(&text[i], &codepoint_size);
+        i += std::max(codepoint_size, 1);
+        if (codepoint == '\n')
+        {
+            width = std::max(width, x - spacing);
+            x = 0.0f;
+            y += LINE_HEIGHT_RATIO * font.baseSize;
+            continue;
+        }
+
+        int index = GetGlyphIndex(font, codepoint);
+        const Rectangle &rec = font.recs[index];
+        const GlyphInfo &glyph = font.glyphs[index];
+        if (codepoint != ' ' && codepoint != '\t')
+        {
+            layout.glyphs.push_back(LayoutGlyph{
+                {rec.x - padding, rec.y - padding, rec.width + 2.0f * padding, rec.height + 2.0f * padding},
+                {x + glyph.offsetX - padding, y + glyph.offsetY - padding, rec.width + 2.0f * padding, rec.height + 2.0f * padding}});
+        }
+        x += (glyph.advanceX != 0 ? glyph.advanceX : rec.width) + spacing;
+    }
+    width = std::max(width, x - spacing);
+    layout.size = {std::max(width, 0.0f), y + font.baseSize};
+    return layout;
+}
+
+void LabelRenderer::add(const std::string &text, const Font &font, Vector3 position, float font_size, Color color, bool background, Color background_color)
+{
+    // Behind the camera: rejected before any projection or layout
+    Vector3 offset = Vector3Subtract(position, this->camera_position_);
+    if (text.empty() || Vector3DotProduct(offset, this->camera_forward_) <= 0.0f)
+    {
+        this->rejected_labels_++;
+        return;
+    }
+    float text_size = font_size / Vector3Length(offset);
+    if (text_size < 1.0f)
+    {
+        this->rejected_labels_++;
+        return;
+    }
+
+    Quaternion clip = QuaternionTransform({position.x, position.y, position.z, 1.0f}, this->view_projection_);
+    Vector2 screen_position = {(clip.x / clip.w + 1.0f) * 0.5f * this->width_, (1.0f - clip.y / clip.w) * 0.5f * this->height_};
+    // The text extends to the right and below its position
+    if (screen_position.x > this->width_ || screen_position.y > this->height_)
+    {
+        this->rejected_labels_++;
+        return;
+    }
+
+    const Font &label_font = this->sdf_loaded_ && font.texture.id == GetFontDefault().texture.id ? this->sdf_font_ : font;
+    Layout &layout = this->get_layout(label_font, text);
+    float scale = text_size / label_font.baseSize;
+    if (screen_position.x + layout.size.x * scale * (1.0f + BACKGROUND_MARGIN) < 0.0f ||
+        screen_position.y + layout.size.y * scale * (1.0f + BACKGROUND_MARGIN) < 0.0f)
+    {
+        this->rejected_labels_++;
+        return;
+    }
+    layout.last_used_frame = this->frame_;
+    this->queued_.push_back(QueuedLabel{&layout, label_font.texture, screen_position, scale, color, background, background_color});
+}
+
+void LabelRenderer::draw()
+{
+    // Backgrounds use the shapes texture (the default font atlas), so they share a single batch
+    for (const QueuedLabel &label : this->queued_)
+    {
+        if (label.background)
+        {
+            Vector2 size = Vector2Scale(label.layout->size, label.scale);
+            Vector2 position = Vector2Subtract(label.position, Vector2Scale(size, BACKGROUND_MARGIN));
+            DrawRectangleV(position, Vector2Scale(size, 1.0f + 2.0f * BACKGROUND_MARGIN), label.background_color);
+        }
+    }
+
+    // Glyphs grouped by font atlas, one batch per atlas
+    std::sort(this->queued_.begin(), this->queued_.end(), [](const QueuedLabel &a, const QueuedLabel &b)
+              { return a.texture.id < b.texture.id; });
+    for (size_t first = 0; first < this->queued_.size();)
+    {
+        const Texture2D &texture = this->queued_[first].texture;
+        bool sdf = this->sdf_loaded_ && texture.id == this->sdf_font_.texture.id;
+        if (sdf)
+        {
+            BeginShaderMode(this->sdf_shader_);
+        }
+        rlSetTexture(texture.id);
+        size_t last = first;
+        for (; last < this->queued_.size() && this->queued_[last].texture.id == texture.id; last++)
+        {
+            const QueuedLabel &label = this->queued_[last];
+            for (const LayoutGlyph &glyph : label.layout->glyphs)
+            {
+                float x = label.position.x + glyph.destination.x * label.scale;
+                float y = label.position.y + glyph.destination.y * label.scale;
+                float w = glyph.destination.width * label.scale;
+                float h = glyph.destination.height * label.scale;
+                float u_0 = glyph.source.x / texture.width;
+                float v_0 = glyph.source.y / texture.height;
+                float u_1 = (glyph.source.x + glyph.source.width) / texture.width;
+                float v_1 = (glyph.source.y + glyph.source.height) / texture.height;
+
+                // Consecutive quads with the same texture are merged into the same draw call by rlgl
+                rlCheckRenderBatchLimit(4);
+                rlBegin(RL_QUADS);
+                rlColor4ub(label.color.r, label.color.g, label.color.b, label.color.a);
+                rlNormal3f(0.0f, 0.0f, 1.0f);
+                rlTexCoord2f(u_0, v_0);
+                rlVertex2f(x, y);
+                rlTexCoord2f(u_0, v_1);
+                rlVertex2f(x, y + h);
+                rlTexCoord2f(u_1, v_1);
+                rlVertex2f(x + w, y + h);
+                rlTexCoord2f(u_1, v_0);
+                rlVertex2f(x + w, y);
+                rlEnd();
+            }
+        }
+        rlSetTexture(0);
+        if (sdf)
+        {
+            EndShaderMode();
+        }
+        first = last;
+    }
+    this->queued_.clear();
+
+    // Drop the layouts of the texts that were not shown this frame once the cache is full
+    if (this->cached_layouts_ > MAX_CACHED_LAYOUTS)
+    {
+        for (auto &[_, font_layouts] : this->layouts_)
+        {
+            for (auto it = font_layouts.begin(); it != font_layouts.end();)
+            {
+                if (it->second.last_used_frame != this->frame_)
+                {
+                    it = font_layouts.erase(it);
+                    this->cached_layouts_--;
+                }
+                else
+                {
+                    ++it;
+                }
+            }
+        }
+    }
+    this->frame_++;
+}
+
+size_t LabelRenderer::get_rejected_labels() const
+{
+    return this->rejected_labels_;
+}
@@ -0,0 +1,121 @@
+#pragma once
+#include <raylib.h>
+#include <raymath.h>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @brief Draws the screen space text labels of a frame in a few batched draw calls.
+ *
+ * The glyph layout and the size of every text are computed once and cached (per font atlas), so a label
+ * only costs a projection and a copy of its quads while its text does not change. Labels behind the
+ * camera, too small to be read or outside the viewport are rejected before their layout is looked up.
+ * All the backgrounds are drawn first, then the glyphs grouped by font atlas.
+ * An optional signed distance field font replaces the default font, so the labels stay sharp at any size.
+ */
+class LabelRenderer
+{
+public:
+    static constexpr size_t MAX_CACHED_LAYOUTS = 4096; // Layouts kept before the ones unused in the last frame are dropped.
+
+private:
+    /**
+     * @brief Quad of a glyph of a layout.
+     */
+    struct LayoutGlyph
+    {
+        Rectangle source;      // Rectangle of the glyph in the font atlas (pixels).
+        Rectangle destination; // Rectangle of the glyph relative to the label position, at the base size of the font.
+    };
+
+    /**
+     * @brief Cached layout of a text.
+     */
+    struct Layout
+    {
+        std::vector<LayoutGlyph> glyphs; // Quads of the visible glyphs.
+        Vector2 size;                    // Size of the text at the base size of the font.
+        uint64_t last_used_frame = 0;    // Frame in which the layout was last used.
+    };
+
+    /**
+     * @brief Label accepted for the current frame.
+     */
+    struct QueuedLabel
+    {
+        const Layout *layout;   // Layout of the text.
+        Texture2D texture;      // Font atlas.
+        Vector2 position;       // Screen position of the top left corner of the text.
+        float scale;            // Scale from the base size of the font to the screen size.
+        Color color;            // Color of the text.
+        bool background;        // Flag indicating whether a background is drawn behind the text.
+        Color background_color; // Color of the background.
+    };
+
+    std::unordered_map<unsigned int, std::unordered_map<std::string, Layout>> layouts_; // Cached layouts by font atlas and text.
+    size_t cached_layouts_ = 0;          // Number of cached layouts.
+    std::vector<QueuedLabel> queued_;    // Labels of the current frame (reused every frame).
+    Matrix view_projection_ = MatrixIdentity(); // View-projection matrix of the frame.
+    Vector3 camera_position_ = {0.0f, 0.0f, 0.0f}; // Position of the camera.
+    Vector3 camera_forward_ = {0.0f, 0.0f, -1.0f}; // Viewing direction of the camera.
+    float width_ = 0.0f;                 // Width of the viewport.
+    float height_ = 0.0f;                // Height of the viewport.
+    uint64_t frame_ = 0;                 // Number of frames drawn.
+    size_t rejected_labels_ = 0;         // Labels rejected in the current frame.
+    Font sdf_font_ = {0};                // Signed distance field font (replaces the default font when loaded).
+    Shader sdf_shader_ = {0};            // Shader rendering the signed distance field glyphs.
+    bool sdf_loaded_ = false;            // Flag indicating whether the signed distance field font is loaded.
+
+    /**
+     * @brief Gets the cached layout of a text, computing it on the first use.
+     */
+    Layout &get_layout(const Font &font, const std::string &text);
+
+public:
+    /**
+     * @brief Loads a signed distance field font from a TTF/OTF file. It is used instead of the default font.
+     * @param path Path to the font file.
+     * @param base_size Size at which the distance field is generated.
+     * @return True if the font and its shader were loaded.
+     */
+    bool load_sdf_font(const char *path, int base_size = 48);
+
+    /**
+     * @brief Unloads the signed distance field font and drops the cached layouts. Safe to call more than once.
+     */
+    void unload();
+
+    /**
+     * @brief Starts a frame of labels.
+     * @param camera Camera of the scene.
+     * @param width Width of the viewport in pixels.
+     * @param height Height of the viewport in pixels.
+     */
+    void begin(const Camera &camera, int width, int height);
+
+    /**
+     * @brief Adds a label to the frame (it is rejected if it cannot be seen).
+     * @param text Text of the label.
+     * @param font Font of the label.
+     * @param position World position of the top left corner of the text.
+     * @param font_size Size of the text at a distance of 1 (the text shrinks with the distance).
+     * @param color Color of the text.
+     * @param background Flag indicating whether a background is drawn behind the text.
+     * @param background_color Color of the background.
+     */
+    void add(const std::string &text, const Font &font, Vector3 position, float font_size, Color color, bool background, Color background_color);
+
+    /**
+     * @brief Draws the labels of the frame (backgrounds first, then the glyphs of each font atlas) and clears them.
+     * Must be called outside BeginMode3D.
+     */
+    void draw();
+
+    /**
+     * @brief Gets the number of labels rejected in the last frame.
+     */
+    size_t get_rejected_labels() const;
+};
@@ -0,0 +1,220 @@
+#include "LineSet.hpp"
+#include <algorithm>
+#include "rlgl.h"
+
+#include "DrawingUtils.hpp"
+#include "GlLoader.hpp"
+
+unsigned int LineSet::add_vertex(Vector3 position, Color color)
+{
+    this->vertices_.push_back(position);
+    this->colors_.push_back(color);
+    this->dirty_.add(this->vertices_.size() - 1, this->vertices_.size());
+    this->changes_++;
+    return this->vertices_.size() - 1;
+}
+
+void LineSet::add_line(Vector3 start_pos, Vector3 end_pos, Color color)
+{
+    unsigned int start = this->add_vertex(start_pos, color);
+    unsigned int end = this->add_vertex(end_pos, color);
+    this->indices_.push_back(start);
+    this->indices_.push_back(end);
+    this->indices_dirty_ = true;
+}
+
+unsigned int LineSet::add_polyline(const Vector3 *points, size_t count, Color color, bool closed)
+{
+    unsigned int first = this->vertices_.size();
+    if (count < 2)
+    {
+        return first;
+    }
+    this->vertices_.insert(this->vertices_.end(), points, points + count);
+    this->colors_.resize(this->vertices_.size(), color);
+    this->dirty_.add(first, this->vertices_.size());
+    this->changes_++;
+
+    this->indices_.reserve(this->indices_.size() + 2 * count);
+    for (size_t i = 0; i + 1 < count; i++)
+    {
+        this->indices_.push_back(first + i);
+        this->indices_.push_back(first + i + 1);
+    }
+    if (closed)
+    {
+        this->indices_.push_back(first + count - 1);
+        this->indices_.push_back(first);
+    }
+    this->indices_dirty_ = true;
+    return first;
+}
+
+void LineSet::add_edges(const unsigned int *edges, size_t edge_count)
+{
+    size_t previous_size = this->indices_.size();
+    for (size_t i = 0; i < edge_count; i++)
+    {
+        unsigned int start = edges[2 * i];
+        unsigned int end = edges[2 * i + 1];
+        // Indices past the last vertex would make the draw call read outside the vertex buffer
+        if (start < this->vertices_.size() && end < this->vertices_.size())
+        {
+            this->indices_.push_back(start);
+            this->indices_.push_back(end);
+        }
+    }
+    if (this->indices_.size() != previous_size)
+    {
+        this->indices_dirty_ = true;
+        this->changes_++;
+    }
+}
+
+void LineSet::set_vertex(unsigned int index, Vector3 position)
+{
+    this->set_vertices(index, &position, 1);
+}
+
+void LineSet::set_vertices(unsigned int first, const Vector3 *positions, size_t count)
+{
+    if (first >= this->vertices_.size())
+    {
+        return;
+    }
+    count = std::min(count, this->vertices_.size() - first);
+    std::copy(positions, positions + count, this->vertices_.begin() + first);
+    this->dirty_.add(first, first + count);
+    this->changes_++;
+}
+
+void LineSet::set_vertex_color(unsigned int index, Color color)
+{
+    if (index >= this->colors_.size())
+    {
+        return;
+    }
+    this->colors_[index] = color;
+    this->dirty_.add(index, index + 1);
+    this->changes_++;
+}
+
+void LineSet::clear()
+{
+    this->vertices_.clear();
+    this->colors_.clear();
+    this->indices_.clear();
+    this->dirty_.clear();
+    this->indices_dirty_ = true;
+    this->changes_++;
+}
+
+size_t LineSet::get_vertex_count() const
+{
+    return this->vertices_.size();
+}
+
+size_t LineSet::get_line_count() const
+{
+    return this->indices_.size() / 2;
+}
+
+uint64_t LineSet::get_change_count() const
+{
+    return this->changes_;
+}
+
+const std::vector<Vector3> &LineSet::get_vertices() const
+{
+    return this->vertices_;
+}
+
+const std::vector<Color> &LineSet::get_colors() const
+{
+    return this->colors_;
+}
+
+const std::vector<unsigned int> &LineSet::get_indices() const
+{
+    return this->indices_;
+}
+
+void LineSet::upload()
+{
+    if (du::reserve_colored_vertex_buffers(this->vertex_buffers_, this->vertices_.size(), 1024))
+    {
+        this->dirty_.add(0, this->vertices_.size());
+    }
+    rlEnableVertexArray(this->vertex_buffers_.vao);
+    if (this->indices_.size() > this->index_capacity_)
+    {
+        if (this->index_ebo_ != 0)
+        {
+            rlUnloadVertexBuffer(this->index_ebo_);
+        }
+        this->index_capacity_ = std::max(this->indices_.size(), std::max(this->index_capacity_ * 2, (size_t)2048));
+        // Loaded while the vertex array is bound, so the vertex array keeps the element buffer binding
+        this->index_ebo_ = rlLoadVertexBufferElement(nullptr, this->index_capacity_ * sizeof(unsigned int), true);
+        this->indices_dirty_ = true;
+    }
+
+    du::upload_colored_vertices(this->vertex_buffers_, this->vertices_.data(), this->colors_.data(), this->dirty_.begin,
+                                std::min(this->dirty_.end, this->vertices_.size()));
+    this->dirty_.clear();
+
+    if (this->indices_dirty_ && !this->indices_.empty())
+    {
+        rlUpdateVertexBufferElements(this->index_ebo_, this->indices_.data(), this->indices_.size() * sizeof(unsigned int), 0);
+    }
+    this->indices_dirty_ = false;
+    rlDisableVertexArray();
+}
+
+void LineSet::draw()
+{
+    if (this->indices_.empty())
+    {
+        return;
+    }
+    rlDrawRenderBatchActive();
+
+    const gl_loader::Functions &gl = gl_loader::get_functions();
+    if (gl.glDrawElements == nullptr)
+    {
+        rlBegin(RL_LINES);
+        for (unsigned int index : this->indices_)
+        {
+            const Color &color = this->colors_[index];
+            rlColor4ub(color.r, color.g, color.b, color.a);
+            rlVertex3f(this->vertices_[index].x, this->vertices_[index].y, this->vertices_[index].z);
+        }
+        rlEnd();
+        return;
+    }
+
+    this->upload();
+    du::enable_default_shader();
+    rlEnableVertexArray(this->vertex_buffers_.vao);
+    gl.glDrawElements(gl_loader::GL_LINES, this->indices_.size(), gl_loader::GL_UNSIGNED_INT, nullptr);
+    rlDisableVertexArray();
+    du::disable_default_shader();
+}
+
+void LineSet::unload()
+{
+    if (this->vertex_buffers_.vao == 0)
+    {
+        return;
+    }
+    du::unload_colored_vertex_buffers(this->vertex_buffers_);
+    if (this->index_ebo_ != 0)
+    {
+        rlUnloadVertexBuffer(this->index_ebo_);
+    }
+    this->index_ebo_ = 0;
+    this->index_capacity_ = 0;
+
+    // The new buffers of the next draw start empty
+    this->dirty_.add(0, this->vertices_.size());
+    this->indices_dirty_ = true;
+}
@@ -0,0 +1,130 @@
+#pragma once
+#include <raylib.h>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "DrawingUtils.hpp"
+
+/**
+ * @brief Retained set of 3D lines stored in GPU buffers and drawn with a single call.
+ *
+ * Vertices are shared between the lines through an index buffer, so polylines and graphs store every
+ * point once. The buffers are only uploaded when the set changes: moving or adding vertices uploads the
+ * modified range, adding lines uploads the indices (the buffers grow geometrically).
+ * Lines are drawn unlit with their vertex colors. The GPU buffers are released by unload (not by the
+ * destructor, which can run without an OpenGL context).
+ */
+class LineSet
+{
+private:
+    std::vector<Vector3> vertices_;      // Vertex positions.
+    std::vector<Color> colors_;          // Vertex colors.
+    std::vector<unsigned int> indices_;  // Pairs of vertex indices, one pair per line.
+
+    du::ColoredVertexBuffers vertex_buffers_; // GPU buffers holding the positions and colors (and the vertex array).
+    unsigned int index_ebo_ = 0;         // GPU buffer holding the indices.
+    size_t index_capacity_ = 0;          // Number of indices the GPU buffer can hold.
+    du::DirtyRange dirty_;               // Vertices modified since the last upload.
+    bool indices_dirty_ = false;         // Flag indicating whether the indices changed since the last upload.
+    uint64_t changes_ = 0;               // Incremented by every modification (tells when the set has to be redrawn).
+
+    void upload();
+
+public:
+    LineSet() = default;
+    LineSet(const LineSet &) = delete;
+    LineSet &operator=(const LineSet &) = delete;
+
+    /**
+     * @brief Adds a vertex that can be connected with add_edges or moved with set_vertex.
+     * @return Index of the vertex.
+     */
+    unsigned int add_vertex(Vector3 position, Color color);
+
+    /**
+     * @brief Adds a line between two new vertices.
+     */
+    void add_line(Vector3 start_pos, Vector3 end_pos, Color color);
+
+    /**
+     * @brief Adds a polyline connecting consecutive points (each point is stored once).
+     * @param points Points of the polyline.
+     * @param count Number of points.
+     * @param color Color of the polyline.
+     * @param closed Flag indicating whether the last point is connected to the first.
+     * @return Index of the vertex of the first point (the others follow it).
+     */
+    unsigned int add_polyline(const Vector3 *points, size_t count, Color color, bool closed = false);
+
+    /**
+     * @brief Adds lines between existing vertices (e.g. the edges of a graph).
+     * @param edges Pairs of vertex indices, edges referencing a vertex that does not exist are skipped.
+     * @param edge_count Number of edges (pairs).
+     */
+    void add_edges(const unsigned int *edges, size_t edge_count);
+
+    /**
+     * @brief Moves a vertex (only the modified range of the vertex buffer is uploaded).
+     */
+    void set_vertex(unsigned int index, Vector3 position);
+
+    /**
+     * @brief Moves consecutive vertices, e.g. the points of a polyline.
+     * @param first Index of the first vertex.
+     * @param positions New positions.
+     * @param count Number of vertices.
+     */
+    void set_vertices(unsigned int first, const Vector3 *positions, size_t count);
+
+    /**
+     * @brief Changes the color of a vertex.
+     */
+    void set_vertex_color(unsigned int index, Color color);
+
+    /**
+     * @brief Removes all the lines (the GPU buffers are kept for reuse).
+     */
+    void clear();
+
+    /**
+     * @brief Gets the number of vertices.
+     */
+    size_t get_vertex_count() const;
+
+    /**
+     * @brief Gets the number of lines.
+     */
+    size_t get_line_count() const;
+
+    /**
+     * @brief Gets the number of modifications so far (it changes whenever the drawn lines may change).
+     */
+    uint64_t get_change_count() const;
+
+    /**
+     * @brief Gets the vertex positions.
+     */
+    const std::vector<Vector3> &get_vertices() const;
+
+    /**
+     * @brief Gets the vertex colors.
+     */
+    const std::vector<Color> &get_colors() const;
+
+    /**
+     * @brief Gets the pairs of vertex indices of the lines.
+     */
+    const std::vector<unsigned int> &get_indices() const;
+
+    /**
+     * @brief Uploads the pending changes and draws the lines with one draw call.
+     * Must be called between BeginMode3D and EndMode3D.
+     */
+    void draw();
+
+    /**
+     * @brief Releases the GPU buffers. Safe to call more than once.
+     */
+    void unload();
+};
@@ -0,0 +1,166 @@
+#include "ModelCache.hpp"
+#include <algorithm>
+#include <filesystem>
+
+std::string ModelCache::primitive_key(PrimitiveShape shape, int rings, int slices)
+{
+    switch (shape)
+    {
+    case PrimitiveShape::BOX:
+        return "primitive:box";
+    case PrimitiveShape::SPHERE:
+        return "primitive:sphere:" + std::to_string(rings) + "x" + std::to_string(slices);
+    case PrimitiveShape::CYLINDER:
+        return "primitive:cylinder:" + std::to_string(slices);
+    case PrimitiveShape::CONE:
+        return "primitive:cone:" + std::to_string(slices);
+    case PrimitiveShape::PLANE:
+        return "primitive:plane:" + std::to_string(rings) + "x" + std::to_string(slices);
+    }
+    return "primitive:unknown";
+}
+
+std::string ModelCache::make_unique_key(const std::string &prefix)
+{
+    return "unique:" + prefix + ":" + std::to_string(this->next_unique_id_++);
+}
+
+Model ModelCache::acquire(const std::string &key, const std::function<Model(void)> &load)
+{
+    auto it = this->models_.find(key);
+    if (it == this->models_.end())
+    {
+        Model model = load();
+        it = this->models_.insert({key, CachedModel{.model = model, .bounds = du::get_model_meshes_bounding_box(model), .ref_count = 0}}).first;
+    }
+    it->second.ref_count++;
+    return it->second.model;
+}
+
+void ModelCache::get_primitive_lod(PrimitiveShape shape, int level, int &rings, int &slices)
+{
+    // Every level doubles (roughly) the slices of the previous one, level 2 is the former fixed tessellation
+    static constexpr int LOD_SLICES[PRIMITIVE_LOD_LEVELS] = {6, 10, 16, 28, 48};
+    static constexpr int LOD_RINGS[PRIMITIVE_LOD_LEVELS] = {4, 8, 16, 24, 40};
+    level = std::clamp(level, 0, PRIMITIVE_LOD_LEVELS - 1);
+    slices = LOD_SLICES[level];
+    rings = shape == PrimitiveShape::SPHERE ? LOD_RINGS[level] : 0;
+}
+
+Model ModelCache::acquire_primitive(PrimitiveShape shape, int rings, int slices, std::string &key)
+{
+    key = primitive_key(shape, rings, slices);
+    return this->acquire(key, [shape, rings, slices]() -> Model
+                         {
+        switch (shape)
+        {
+        case PrimitiveShape::BOX:
+            return LoadModelFromMesh(GenMeshCube(1.0f, 1.0f, 1.0f));
+        case PrimitiveShape::SPHERE:
+            return LoadModelFromMesh(GenMeshSphere(1.0f, rings, slices));
+        case PrimitiveShape::CYLINDER:
+            return LoadModelFromMesh(GenMeshCylinder(1.0f, 1.0f, slices));
+        case PrimitiveShape::CONE:
+            return LoadModelFromMesh(GenMeshCone(1.0f, 1.0f, slices));
+        case PrimitiveShape::PLANE:
+            return LoadModelFromMesh(GenMeshPlane(1.0f, 1.0f, slices, rings));
+        }
+        return LoadModelFromMesh(GenMeshCube(1.0f, 1.0f, 1.0f)); });
+}
+
+Model ModelCache::acquire_file(const char *filename, std::string &key)
+{
+    // Resolve the path so that different spellings of the same file share the entry
+    std::error_code error;
+    std::filesystem::path path = std::filesystem::weakly_canonical(filename, error);
+    if (error)
+    {
+        path = filename;
+    }
+    std::string resolved_path = path.string();
+
+    key = "file:" + resolved_path + "@" + std::to_string(GetFileModTime(resolved_path.c_str()));
+    return this->acquire(key, [resolved_path]() -> Model
+                         { return LoadModel(resolved_path.c_str()); });
+}
+
+void ModelCache::release(const std::string &key)
+{
+    auto it = this->models_.find(key);
+    if (it == this->models_.end())
+    {
+        return;
+    }
+    it->second.ref_count--;
+    if (it->second.ref_count <= 0)
+    {
+        unload_entry(it->second);
+        this->models_.erase(it);
+    }
+}
+
+void ModelCache::unload_entry(CachedModel &cached_model)
+{
+    for (Mesh &edge_mesh : cached_model.edge_meshes)
+    {
+        UnloadMesh(edge_mesh);
+    }
+    cached_model.edge_meshes.clear();
+    UnloadModel(cached_model.model);
+}
+
+BoundingBox ModelCache::get_bounds(const std::string &key) const
+{
+    auto it = this->models_.find(key);
+    if (it == this->models_.end())
+    {
+        return BoundingBox{Vector3Zero(), Vector3Zero()};
+    }
+    return it->second.bounds;
+}
+
+std::shared_ptr<const std::vector<TriangleBvh>> ModelCache::get_mesh_bvhs(const std::string &key)
+{
+    auto it = this->models_.find(key);
+    if (it == this->models_.end())
+    {
+        return nullptr;
+    }
+    if (it->second.mesh_bvhs == nullptr)
+    {
+        it->second.mesh_bvhs = std::make_shared<const std::vector<TriangleBvh>>(TriangleBvh::build_model(it->second.model));
+    }
+    return it->second.mesh_bvhs;
+}
+
+const Mesh *ModelCache::get_edge_meshes(const std::string &key)
+{
+    auto it = this->models_.find(key);
+    if (it == this->models_.end())
+    {
+        return nullptr;
+    }
+    CachedModel &cached_model = it->second;
+    if (cached_model.edge_meshes.empty())
+    {
+        for (int i = 0; i < cached_model.model.meshCount; i++)
+        {
+            cached_model.edge_meshes.push_back(du::gen_mesh_barycentric(cached_model.model.meshes[i]));
+        }
+    }
+    return cached_model.edge_meshes.data();
+}
+
+void ModelCache::unload()
+{
+    for (auto &[_, cached_model] : this->models_)
+    {
+        unload_entry(cached_model);
+    }
+    this->models_.clear();
+}
+
+size_t ModelCache::size() const
+{
+    return this->models_.size();
+}
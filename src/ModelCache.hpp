@@ -0,0 +1,148 @@
+#pragma once
+#include <raylib.h>
+#include <raymath.h>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "DrawingUtils.hpp"
+#include "TriangleBvh.hpp"
+
+/**
+ * @brief Geometric primitives whose unit meshes are shared through the model cache.
+ */
+enum class PrimitiveShape
+{
+    BOX,      // Cube of side 1 centered at the origin.
+    SPHERE,   // Sphere of radius 1 centered at the origin.
+    CYLINDER, // Cylinder of radius 1 going from y = 0 to y = 1.
+    CONE,     // Cone of base radius 1 going from y = 0 (base) to y = 1 (apex).
+    PLANE     // Plane of side 1 on the XZ plane centered at the origin.
+};
+
+/**
+ * @brief Reference counted cache of GPU models shared between visual objects.
+ *
+ * Every entry is uploaded once and handed out as a shallow copy of its Model struct, so all
+ * the users share the same meshes and materials while keeping their own transform.
+ * An entry is unloaded when the last user releases it.
+ */
+class ModelCache
+{
+private:
+    /**
+     * @brief Model stored in the cache together with the number of visual objects using it.
+     */
+    struct CachedModel
+    {
+        Model model;        // Model uploaded to the GPU.
+        BoundingBox bounds; // Bounds of the meshes of the model (without the model transform).
+        int ref_count = 0;  // Number of users of the model.
+        std::shared_ptr<const std::vector<TriangleBvh>> mesh_bvhs; // Triangle hierarchies of the meshes (built on the first raycast).
+        std::vector<Mesh> edge_meshes; // Copies of the meshes with barycentric coordinates (built on the first edge overlay draw).
+    };
+
+    /**
+     * @brief Unloads the model of an entry and the meshes derived from it.
+     */
+    static void unload_entry(CachedModel &cached_model);
+
+    std::map<std::string, CachedModel> models_; // Cached models by key.
+    size_t next_unique_id_ = 0;                  // Counter used to build unique keys.
+
+public:
+    static constexpr int PRIMITIVE_LOD_LEVELS = 5;  // Tessellation levels of the curved primitives (spheres, cylinders and cones).
+    static constexpr int PRIMITIVE_DEFAULT_LOD = 2; // Level used until the screen size of an object is known (16 slices).
+
+    /**
+     * @brief Gets the tessellation of a level of detail of a curved primitive, from 0 (coarsest) to PRIMITIVE_LOD_LEVELS - 1 (finest).
+     * @param shape Primitive shape (spheres, cylinders or cones).
+     * @param level Level of detail.
+     * @param rings Output number of rings (only used by spheres).
+     * @param slices Output number of slices.
+     */
+    static void get_primitive_lod(PrimitiveShape shape, int level, int &rings, int &slices);
+
+    /**
+     * @brief Gets the key of the unit model of a primitive with the given tessellation.
+     * @param shape Primitive shape.
+     * @param rings Number of rings (or subdivisions along Z for planes). Ignored when the shape does not use it.
+     * @param slices Number of slices (or subdivisions along X for planes). Ignored when the shape does not use it.
+     */
+    static std::string primitive_key(PrimitiveShape shape, int rings, int slices);
+
+    /**
+     * @brief Builds a key that is not shared with any other model, for models that are generated once (e.g. heightmaps).
+     * @param prefix Prefix of the key.
+     */
+    std::string make_unique_key(const std::string &prefix);
+
+    /**
+     * @brief Gets a model from the cache, loading it with the given function if it is not cached yet.
+     * Increases the reference count of the entry.
+     * @param key Key of the model.
+     * @param load Function that loads the model when it is not in the cache.
+     * @return Shallow copy of the cached model (meshes and materials are shared).
+     */
+    Model acquire(const std::string &key, const std::function<Model(void)> &load);
+
+    /**
+     * @brief Gets the unit model of a primitive, generating its mesh if it is not cached yet.
+     * @param shape Primitive shape.
+     * @param rings Number of rings (spheres) or subdivisions along Z (planes).
+     * @param slices Number of slices (spheres, cylinders, cones) or subdivisions along X (planes).
+     * @param key Output key of the acquired model, used to release it.
+     * @return Shallow copy of the cached model.
+     */
+    Model acquire_primitive(PrimitiveShape shape, int rings, int slices, std::string &key);
+
+    /**
+     * @brief Gets a model loaded from a file, loading it only if no visual object uses it yet.
+     * Files are identified by their resolved path and modification time, so a file that changed on disk is loaded again.
+     * @param filename Path to the model file.
+     * @param key Output key of the acquired model, used to release it.
+     * @return Shallow copy of the cached model.
+     */
+    Model acquire_file(const char *filename, std::string &key);
+
+    /**
+     * @brief Releases one reference to a cached model, unloading it when it is no longer used.
+     * @param key Key of the model.
+     */
+    void release(const std::string &key);
+
+    /**
+     * @brief Gets the bounds of the meshes of a cached model, computed once when the model is loaded.
+     * @param key Key of the model.
+     * @return Bounds in mesh space (the model transform is not applied), or an empty box if the key is not cached.
+     */
+    BoundingBox get_bounds(const std::string &key) const;
+
+    /**
+     * @brief Gets the triangle hierarchies of the meshes of a cached model, building them the first time they are requested.
+     * The hierarchies are shared by all the users of the model and kept alive while any of them holds the pointer.
+     * @param key Key of the model.
+     * @return One hierarchy per mesh, or nullptr if the key is not cached.
+     */
+    std::shared_ptr<const std::vector<TriangleBvh>> get_mesh_bvhs(const std::string &key);
+
+    /**
+     * @brief Gets the copies of the meshes of a cached model used to draw its edges in a single pass
+     * (see du::gen_mesh_barycentric), generating them the first time they are requested.
+     * @param key Key of the model.
+     * @return One mesh per mesh of the model, or nullptr if the key is not cached.
+     */
+    const Mesh *get_edge_meshes(const std::string &key);
+
+    /**
+     * @brief Unloads every cached model regardless of its reference count.
+     */
+    void unload();
+
+    /**
+     * @brief Returns the number of unique models held by the cache.
+     */
+    size_t size() const;
+};
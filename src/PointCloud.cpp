@@ -0,0 +1,327 @@
+#include "PointCloud.hpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <unordered_set>
+#include "rlgl.h"
+
+#include "DrawingUtils.hpp"
+#include "GlLoader.hpp"
+
+namespace
+{
+    constexpr float NO_INTENSITY = std::numeric_limits<float>::quiet_NaN(); // Intensity of the points colored directly.
+
+    /**
+     * @brief Maps a value in [0, 1] to a blue-cyan-green-yellow-red color map.
+     */
+    Color intensity_color(float t)
+    {
+        static const Color stops[5] = {{0, 0, 255, 255}, {0, 255, 255, 255}, {0, 255, 0, 255}, {255, 255, 0, 255}, {255, 0, 0, 255}};
+        float scaled = Clamp(t, 0.0f, 1.0f) * 4.0f;
+        int index = std::min((int)scaled, 3);
+        float f = scaled - index;
+        const Color &a = stops[index];
+        const Color &b = stops[index + 1];
+        return {(unsigned char)(a.r + (b.r - a.r) * f), (unsigned char)(a.g + (b.g - a.g) * f), (unsigned char)(a.b + (b.b - a.b) * f), 255};
+    }
+}
+
+void PointCloud::mark_dirty(size_t begin, size_t end)
+{
+    this->dirty_.add(begin, end);
+    this->version_++;
+}
+
+void PointCloud::resize(size_t count, Color color)
+{
+    std::lock_guard<std::mutex> lock(this->mutex_);
+    this->changes_++;
+    size_t previous = this->positions_.size();
+    this->positions_.resize(count, Vector3{0.0f, 0.0f, 0.0f});
+    this->colors_.resize(count, color);
+    this->intensities_.resize(count, NO_INTENSITY);
+    if (count > previous)
+    {
+        this->mark_dirty(previous, count);
+    }
+    else
+    {
+        this->version_++;
+    }
+}
+
+size_t PointCloud::size() const
+{
+    std::lock_guard<std::mutex> lock(this->mutex_);
+    return this->positions_.size();
+}
+
+uint64_t PointCloud::get_change_count() const
+{
+    std::lock_guard<std::mutex> lock(this->mutex_);
+    return this->changes_;
+}
+
+void PointCloud::set_points(size_t offset, const Vector3 *positions, size_t count, const Color *colors)
+{
+    std::lock_guard<std::mutex> lock(this->mutex_);
+    this->changes_++;
+    if (offset >= this->positions_.size())
+    {
+        return;
+    }
+    count = std::min(count, this->positions_.size() - offset);
+    std::copy(positions, positions + count, this->positions_.begin() + offset);
+    if (colors != nullptr)
+    {
+        std::copy(colors, colors + count, this->colors_.begin() + offset);
+        std::fill(this->intensities_.begin() + offset, this->intensities_.begin() + offset + count, NO_INTENSITY);
+    }
+    this->mark_dirty(offset, offset + count);
+}
+
+void PointCloud::set_colors(size_t offset, const Color *colors, size_t count)
+{
+    std::lock_guard<std::mutex> lock(this->mutex_);
+    this->changes_++;
+    if (offset >= this->colors_.size())
+    {
+        return;
+    }
+    count = std::min(count, this->colors_.size() - offset);
+    std::copy(colors, colors + count, this->colors_.begin() + offset);
+    std::fill(this->intensities_.begin() + offset, this->intensities_.begin() + offset + count, NO_INTENSITY);
+    this->mark_dirty(offset, offset + count);
+}
+
+void PointCloud::set_intensities(size_t offset, const float *intensities, size_t count)
+{
+    std::lock_guard<std::mutex> lock(this->mutex_);
+    this->changes_++;
+    if (offset >= this->colors_.size())
+    {
+        return;
+    }
+    count = std::min(count, this->colors_.size() - offset);
+    std::copy(intensities, intensities + count, this->intensities_.begin() + offset);
+    this->apply_intensities(offset, offset + count);
+}
+
+void PointCloud::set_intensity_range(float min_intensity, float max_intensity)
+{
+    std::lock_guard<std::mutex> lock(this->mutex_);
+    this->changes_++;
+    if (min_intensity == this->min_intensity_ && max_intensity == this->max_intensity_)
+    {
+        return;
+    }
+    this->min_intensity_ = min_intensity;
+    this->max_intensity_ = max_intensity;
+    // The points colored from their intensities are colored again with the new range
+    this->apply_intensities(0, this->intensities_.size());
+}
+
+void PointCloud::apply_intensities(size_t begin, size_t end)
+{
+    float range = this->max_intensity_ - this->min_intensity_;
+    float scale = range != 0.0f ? 1.0f / range : 0.0f;
+    size_t first = end;
+    size_t last = begin;
+    for (size_t i = begin; i < end; i++)
+    {
+        if (std::isnan(this->intensities_[i]))
+        {
+            continue;
+        }
+        this->colors_[i] = intensity_color((this->intensities_[i] - this->min_intensity_) * scale);
+        first = std::min(first, i);
+        last = i + 1;
+    }
+    if (first < last)
+    {
+        this->mark_dirty(first, last);
+    }
+}
+
+void PointCloud::set_pose(Vector3 position, Quaternion orientation)
+{
+    std::lock_guard<std::mutex> lock(this->mutex_);
+    this->changes_++;
+    this->position_ = position;
+    this->orientation_ = orientation;
+}
+
+void PointCloud::set_point_size(float size, PointSizeMode mode, bool round)
+{
+    std::lock_guard<std::mutex> lock(this->mutex_);
+    this->changes_++;
+    this->point_size_ = std::max(size, 0.0f);
+    this->size_mode_ = mode;
+    this->round_points_ = round;
+}
+
+void PointCloud::set_voxel_filter(float voxel_size, float distance)
+{
+    std::lock_guard<std::mutex> lock(this->mutex_);
+    this->changes_++;
+    this->voxel_size_ = std::max(voxel_size, 0.0f);
+    this->lod_distance_ = std::max(distance, 0.0f);
+    // The filtered cloud is stale (filtered_version_ belongs to the render thread)
+    this->version_++;
+}
+
+void PointCloud::voxel_downsample(const Vector3 *positions, const Color *colors, size_t count, float voxel_size,
+                                  std::vector<Vector3> &out_positions, std::vector<Color> &out_colors)
+{
+    out_positions.clear();
+    out_colors.clear();
+    if (voxel_size <= 0.0f)
+    {
+        out_positions.assign(positions, positions + count);
+        out_colors.assign(colors, colors + count);
+        return;
+    }
+
+    // Voxel coordinates packed in 21 bits each (clouds spanning up to ~2M voxels per axis)
+    float inv_size = 1.0f / voxel_size;
+    std::unordered_set<uint64_t> occupied;
+    occupied.reserve(count / 4);
+    for (size_t i = 0; i < count; i++)
+    {
+        uint64_t x = (uint64_t)((int64_t)std::floor(positions[i].x * inv_size) & 0x1FFFFF);
+        uint64_t y = (uint64_t)((int64_t)std::floor(positions[i].y * inv_size) & 0x1FFFFF);
+        uint64_t z = (uint64_t)((int64_t)std::floor(positions[i].z * inv_size) & 0x1FFFFF);
+        if (occupied.insert(x | (y << 21) | (z << 42)).second)
+        {
+            out_positions.push_back(positions[i]);
+            out_colors.push_back(colors[i]);
+        }
+    }
+}
+
+void PointCloud::upload_full()
+{
+    size_t count = this->positions_.size();
+    if (du::reserve_colored_vertex_buffers(this->full_buffer_.gpu, count, 4096))
+    {
+        this->dirty_.add(0, count);
+    }
+    du::upload_colored_vertices(this->full_buffer_.gpu, this->positions_.data(), this->colors_.data(), this->dirty_.begin,
+                                std::min(this->dirty_.end, count));
+    this->dirty_.clear();
+    this->full_buffer_.count = count;
+}
+
+bool PointCloud::copy_filter_input()
+{
+    if (this->filtered_version_ == this->version_)
+    {
+        return false;
+    }
+    this->filter_input_positions_.assign(this->positions_.begin(), this->positions_.end());
+    this->filter_input_colors_.assign(this->colors_.begin(), this->colors_.end());
+    this->filter_input_version_ = this->version_;
+    this->filter_voxel_size_ = this->voxel_size_;
+    return true;
+}
+
+void PointCloud::update_filtered()
+{
+    voxel_downsample(this->filter_input_positions_.data(), this->filter_input_colors_.data(), this->filter_input_positions_.size(),
+                     this->filter_voxel_size_, this->filtered_positions_, this->filtered_colors_);
+    du::reserve_colored_vertex_buffers(this->filtered_buffer_.gpu, this->filtered_positions_.size(), 4096);
+    du::upload_colored_vertices(this->filtered_buffer_.gpu, this->filtered_positions_.data(), this->filtered_colors_.data(), 0,
+                                this->filtered_positions_.size());
+    this->filtered_buffer_.count = this->filtered_positions_.size();
+    this->filtered_version_ = this->filter_input_version_;
+}
+
+void PointCloud::draw_immediate(const Vector3 *positions, const Color *colors, size_t count, const Matrix &transform)
+{
+    // Same tiny lines as DrawPoint3D
+    rlPushMatrix();
+    rlMultMatrixf(MatrixToFloatV(transform).v);
+    rlBegin(RL_LINES);
+    for (size_t i = 0; i < count; i++)
+    {
+        rlColor4ub(colors[i].r, colors[i].g, colors[i].b, colors[i].a);
+        rlVertex3f(positions[i].x, positions[i].y, positions[i].z);
+        rlVertex3f(positions[i].x + 0.001f, positions[i].y, positions[i].z);
+    }
+    rlEnd();
+    rlPopMatrix();
+}
+
+void PointCloud::draw(const Shader &shader, Vector3 camera_position, int viewport_height)
+{
+    const gl_loader::Functions &gl = gl_loader::get_functions();
+    bool gpu_path = shader.id != 0 && shader.id != rlGetShaderIdDefault() && gl.glDrawArrays != nullptr &&
+                    gl.glEnable != nullptr && gl.glDisable != nullptr;
+
+    // The lock is only held while the staging data is copied (to the GPU or to the filter input), not while
+    // filtering or drawing
+    std::unique_lock<std::mutex> lock(this->mutex_);
+    if (this->positions_.empty())
+    {
+        return;
+    }
+    Matrix transform = du::get_transform(this->position_, this->orientation_);
+    bool filtered = this->voxel_size_ > 0.0f && Vector3Distance(camera_position, this->position_) >= this->lod_distance_;
+    float point_size = this->point_size_;
+    PointSizeMode size_mode = this->size_mode_;
+    int round_points = this->round_points_;
+
+    rlDrawRenderBatchActive();
+    if (!gpu_path && !filtered)
+    {
+        draw_immediate(this->positions_.data(), this->colors_.data(), this->positions_.size(), transform);
+        return;
+    }
+    if (gpu_path)
+    {
+        this->upload_full();
+    }
+    bool refilter = filtered && this->copy_filter_input();
+    lock.unlock();
+
+    // The writers can fill the cloud again while it is filtered
+    if (refilter)
+    {
+        this->update_filtered();
+    }
+    if (!gpu_path)
+    {
+        draw_immediate(this->filtered_positions_.data(), this->filtered_colors_.data(), this->filtered_positions_.size(), transform);
+        return;
+    }
+
+    const PointBuffer &buffer = filtered ? this->filtered_buffer_ : this->full_buffer_;
+    Matrix projection = rlGetMatrixProjection();
+    float point_scale = size_mode == PointSizeMode::WORLD ? 0.5f * viewport_height * projection.m5 : 0.0f;
+
+    rlEnableShader(shader.id);
+    rlSetUniformMatrix(shader.locs[SHADER_LOC_MATRIX_MVP], MatrixMultiply(transform, MatrixMultiply(rlGetMatrixModelview(), projection)));
+    rlSetUniform(GetShaderLocation(shader, "pointSize"), &point_size, RL_SHADER_UNIFORM_FLOAT, 1);
+    rlSetUniform(GetShaderLocation(shader, "pointScale"), &point_scale, RL_SHADER_UNIFORM_FLOAT, 1);
+    rlSetUniform(GetShaderLocation(shader, "roundPoints"), &round_points, RL_SHADER_UNIFORM_INT, 1);
+    gl.glEnable(gl_loader::GL_PROGRAM_POINT_SIZE);
+    rlEnableVertexArray(buffer.gpu.vao);
+    gl.glDrawArrays(gl_loader::GL_POINTS, 0, buffer.count);
+    rlDisableVertexArray();
+    gl.glDisable(gl_loader::GL_PROGRAM_POINT_SIZE);
+    rlDisableShader();
+}
+
+void PointCloud::unload()
+{
+    std::lock_guard<std::mutex> lock(this->mutex_);
+    for (PointBuffer *buffer : {&this->full_buffer_, &this->filtered_buffer_})
+    {
+        du::unload_colored_vertex_buffers(buffer->gpu);
+        buffer->count = 0;
+    }
+    // Both clouds are rebuilt from the staging data by the next draw
+    this->filtered_version_ = UINT64_MAX;
+    this->mark_dirty(0, this->positions_.size());
+}
@@ -0,0 +1,192 @@
+#pragma once
+#include <raylib.h>
+#include <raymath.h>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+#include "DrawingUtils.hpp"
+
+/**
+ * @brief Units of the point size of a point cloud.
+ */
+enum class PointSizeMode
+{
+    PIXELS, // Points have the same size on screen at any distance.
+    WORLD   // Points have a size in world units (they shrink with the distance).
+};
+
+/**
+ * @brief Point cloud stored in GPU buffers and drawn with a single call.
+ *
+ * The points are written into a CPU staging copy, which can be done from any thread (e.g. a sensor
+ * callback) while the render thread draws: only the range modified since the last draw is uploaded,
+ * so streaming a scan in packets costs as much as the packets. Points can be colored one by one or
+ * from an intensity mapped to a color map. A voxel grid filter can replace the cloud by one point per
+ * voxel when the cloud is far from the camera.
+ */
+class PointCloud
+{
+private:
+    /**
+     * @brief GPU copy of a set of points.
+     */
+    struct PointBuffer
+    {
+        du::ColoredVertexBuffers gpu; // GPU buffers holding the positions and colors.
+        size_t count = 0;             // Number of points uploaded.
+    };
+
+    mutable std::mutex mutex_;          // Protects the staging data, written by the sensor threads.
+    std::vector<Vector3> positions_;    // Positions of the points, in the frame of the cloud.
+    std::vector<Color> colors_;         // Colors of the points.
+    std::vector<float> intensities_;    // Intensities of the points (NaN for the points colored directly).
+    du::DirtyRange dirty_;              // Points modified since the last upload.
+    uint64_t version_ = 0;              // Incremented on every change (tells when the filtered cloud is stale).
+    uint64_t changes_ = 0;              // Incremented by every setter (tells when the cloud has to be redrawn).
+    Vector3 position_ = {0.0f, 0.0f, 0.0f};            // Position of the frame of the cloud (e.g. of the sensor).
+    Quaternion orientation_ = {0.0f, 0.0f, 0.0f, 1.0f}; // Orientation of the frame of the cloud.
+    float min_intensity_ = 0.0f;        // Intensity mapped to the first color of the color map.
+    float max_intensity_ = 1.0f;        // Intensity mapped to the last color of the color map.
+
+    float point_size_ = 2.0f;                        // Size of the points (see size_mode_).
+    PointSizeMode size_mode_ = PointSizeMode::PIXELS; // Units of the point size.
+    bool round_points_ = false;                      // Flag indicating whether the points are drawn as discs instead of squares.
+    float voxel_size_ = 0.0f;                        // Edge of the voxels of the filtered cloud (0 disables the filter).
+    float lod_distance_ = 0.0f;                      // Distance to the camera from which the filtered cloud is drawn.
+
+    // Render thread only
+    PointBuffer full_buffer_;                // All the points.
+    PointBuffer filtered_buffer_;            // One point per voxel.
+    uint64_t filtered_version_ = UINT64_MAX; // Version of the cloud the filtered buffer was built from.
+    std::vector<Vector3> filtered_positions_; // Staging of the filtered cloud (reused between rebuilds).
+    std::vector<Color> filtered_colors_;      // Staging of the filtered cloud colors.
+    std::vector<Vector3> filter_input_positions_; // Copy of the points being filtered (taken under the mutex, filtered without it).
+    std::vector<Color> filter_input_colors_;      // Copy of the colors of the points being filtered.
+    uint64_t filter_input_version_ = 0;       // Version of the cloud copied into the filter input.
+    float filter_voxel_size_ = 0.0f;          // Voxel size of the filter input.
+
+    /**
+     * @brief Adds a range of points to the upload and marks the filtered cloud stale. Must be called with the mutex locked.
+     */
+    void mark_dirty(size_t begin, size_t end);
+
+    /**
+     * @brief Colors the points of a range that have an intensity with the color map. Must be called with the mutex locked.
+     */
+    void apply_intensities(size_t begin, size_t end);
+
+    /**
+     * @brief Uploads the points modified since the last draw. Must be called with the mutex locked.
+     */
+    void upload_full();
+
+    /**
+     * @brief Copies the points into the filter input if they changed since the filtered cloud was built.
+     * Must be called with the mutex locked.
+     * @return True if the filtered cloud has to be rebuilt with update_filtered.
+     */
+    bool copy_filter_input();
+
+    /**
+     * @brief Rebuilds the filtered cloud from the filter input and uploads it. Does not need the mutex.
+     */
+    void update_filtered();
+
+    /**
+     * @brief Draws points in immediate mode (fallback when the point shader is not available).
+     */
+    static void draw_immediate(const Vector3 *positions, const Color *colors, size_t count, const Matrix &transform);
+
+public:
+    PointCloud() = default;
+    PointCloud(const PointCloud &) = delete;
+    PointCloud &operator=(const PointCloud &) = delete;
+
+    /**
+     * @brief Sets the number of points (new points are placed at the origin with the given color).
+     */
+    void resize(size_t count, Color color = WHITE);
+
+    /**
+     * @brief Gets the number of points.
+     */
+    size_t size() const;
+
+    /**
+     * @brief Gets the number of calls to the setters so far (it changes whenever the drawn cloud may change).
+     */
+    uint64_t get_change_count() const;
+
+    /**
+     * @brief Writes consecutive points in place (points past the end of the cloud are ignored).
+     * @param offset Index of the first point written.
+     * @param positions Positions of the points, in the frame of the cloud.
+     * @param count Number of points.
+     * @param colors Colors of the points, or nullptr to keep their current colors.
+     */
+    void set_points(size_t offset, const Vector3 *positions, size_t count, const Color *colors = nullptr);
+
+    /**
+     * @brief Writes the colors of consecutive points.
+     */
+    void set_colors(size_t offset, const Color *colors, size_t count);
+
+    /**
+     * @brief Colors consecutive points from their intensities (see set_intensity_range).
+     */
+    void set_intensities(size_t offset, const float *intensities, size_t count);
+
+    /**
+     * @brief Sets the intensities mapped to the ends of the color map (blue to red). The points colored from
+     * their intensities are colored again.
+     */
+    void set_intensity_range(float min_intensity, float max_intensity);
+
+    /**
+     * @brief Places the frame of the cloud (e.g. the pose of the sensor). The points are not uploaded again.
+     */
+    void set_pose(Vector3 position, Quaternion orientation);
+
+    /**
+     * @brief Sets the size of the points.
+     * @param size Size in pixels or in world units, depending on mode.
+     * @param mode Units of the size.
+     * @param round Draws the points as discs instead of squares.
+     */
+    void set_point_size(float size, PointSizeMode mode = PointSizeMode::PIXELS, bool round = false);
+
+    /**
+     * @brief Enables the voxel grid filter used as level of detail.
+     * @param voxel_size Edge of the voxels (0 disables the filter). Each voxel is drawn as its first point.
+     * @param distance Distance from the camera to the origin of the cloud beyond which the filtered cloud is drawn.
+     */
+    void set_voxel_filter(float voxel_size, float distance = 0.0f);
+
+    /**
+     * @brief Uploads the pending changes and draws the points. Render thread only,
+     * must be called between BeginMode3D and EndMode3D.
+     * @param shader Point cloud shader (point_cloud.vs/fs), the points are drawn in immediate mode if it is not valid.
+     * @param camera_position Position of the camera (selects the level of detail).
+     * @param viewport_height Height of the render target in pixels (scales the world sized points).
+     */
+    void draw(const Shader &shader, Vector3 camera_position, int viewport_height);
+
+    /**
+     * @brief Releases the GPU buffers (the points are kept). Render thread only.
+     */
+    void unload();
+
+    /**
+     * @brief Keeps the first point of every voxel of a grid.
+     * @param positions Positions of the points.
+     * @param colors Colors of the points.
+     * @param count Number of points.
+     * @param voxel_size Edge of the voxels.
+     * @param out_positions Output positions (cleared first).
+     * @param out_colors Output colors (cleared first).
+     */
+    static void voxel_downsample(const Vector3 *positions, const Color *colors, size_t count, float voxel_size,
+                                 std::vector<Vector3> &out_positions, std::vector<Color> &out_colors);
+};
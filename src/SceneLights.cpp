@@ -0,0 +1,341 @@
+#include "SceneLights.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include "GlLoader.hpp"
+#include "rlgl.h"
+
+int SceneLights::add_light(const Light &light)
+{
+    if (this->lights_.size() >= MAX_LIGHTS)
+    {
+        return -1;
+    }
+    this->lights_dirty_ = true;
+    return this->lights_.insert(light);
+}
+
+bool SceneLights::load(int width, int height)
+{
+    this->unload();
+    const gl_loader::Functions &gl = gl_loader::get_functions();
+    if (!gl.has_uniform_buffers())
+    {
+        TraceLog(LOG_WARNING, "ROBOVIS: Uniform buffers not available, only the main light is used");
+        return false;
+    }
+
+    gl.glGenBuffers(1, &this->buffer_);
+    gl.glBindBuffer(gl_loader::GL_UNIFORM_BUFFER, this->buffer_);
+    gl.glBufferData(gl_loader::GL_UNIFORM_BUFFER, sizeof(GpuLight) * MAX_LIGHTS + 4 * sizeof(int), nullptr, gl_loader::GL_DYNAMIC_DRAW);
+    gl.glBindBuffer(gl_loader::GL_UNIFORM_BUFFER, 0);
+
+    this->width_ = width;
+    this->height_ = height;
+    this->tiles_x_ = (width + TILE_SIZE - 1) / TILE_SIZE;
+    this->tiles_y_ = (height + TILE_SIZE - 1) / TILE_SIZE;
+    this->tile_lights_.assign((size_t)this->tiles_x_ * this->tiles_y_ * TILE_SLOTS, 0);
+    this->tile_counts_.assign((size_t)this->tiles_x_ * this->tiles_y_, 0);
+    this->tile_texture_ = rlLoadTexture(this->tile_lights_.data(), this->tiles_x_ * TILE_SLOTS / 4, this->tiles_y_, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8, 1);
+    this->tiles_empty_ = true;
+    this->lights_dirty_ = true;
+    this->loaded_ = true;
+    return true;
+}
+
+void SceneLights::unload()
+{
+    if (this->buffer_ != 0)
+    {
+        gl_loader::get_functions().glDeleteBuffers(1, &this->buffer_);
+        this->buffer_ = 0;
+    }
+    if (this->tile_texture_ != 0)
+    {
+        rlUnloadTexture(this->tile_texture_);
+        this->tile_texture_ = 0;
+    }
+    // The block bindings are set when the locations are looked up, so they are looked up again after a reload
+    this->locations_.clear();
+    this->loaded_ = false;
+}
+
+void SceneLights::set_main_light(Vector3 direction, Color color)
+{
+    this->main_direction_ = Vector3Normalize(direction);
+    this->main_color_ = color;
+}
+
+int SceneLights::add_directional_light(Vector3 direction, Color color, float intensity)
+{
+    return this->add_light(Light{LightType::DIRECTIONAL, Vector3Zero(), Vector3Normalize(direction), color, intensity, 0.0f, 1.0f, 1.0f});
+}
+
+int SceneLights::add_point_light(Vector3 position, Color color, float intensity, float range)
+{
+    return this->add_light(Light{LightType::POINT, position, {0.0f, -1.0f, 0.0f}, color, intensity, range, -1.0f, -1.0f});
+}
+
+int SceneLights::add_spot_light(Vector3 position, Vector3 direction, Color color, float intensity, float range, float inner_angle, float outer_angle)
+{
+    outer_angle = std::clamp(outer_angle, 0.0f, 90.0f);
+    inner_angle = std::clamp(inner_angle, 0.0f, outer_angle);
+    return this->add_light(Light{LightType::SPOT, position, Vector3Normalize(direction), color, intensity, range,
+                                 cosf(inner_angle * DEG2RAD), cosf(outer_angle * DEG2RAD)});
+}
+
+void SceneLights::set_light_pose(int handle, Vector3 position, Vector3 direction)
+{
+    Light *light = this->lights_.get(handle);
+    if (light == nullptr)
+    {
+        return;
+    }
+    light->position = position;
+    if (Vector3Length(direction) > 0.0f)
+    {
+        light->direction = Vector3Normalize(direction);
+    }
+    this->lights_dirty_ = true;
+}
+
+void SceneLights::set_light_color(int handle, Color color, float intensity)
+{
+    Light *light = this->lights_.get(handle);
+    if (light == nullptr)
+    {
+        return;
+    }
+    light->color = color;
+    light->intensity = intensity;
+    this->lights_dirty_ = true;
+}
+
+void SceneLights::remove_light(int handle)
+{
+    if (this->lights_.erase(handle))
+    {
+        this->lights_dirty_ = true;
+    }
+}
+
+void SceneLights::clear()
+{
+    this->lights_.clear();
+    this->lights_dirty_ = true;
+}
+
+size_t SceneLights::size() const
+{
+    return this->lights_.size();
+}
+
+void SceneLights::upload_lights()
+{
+    // Directional lights first, they are evaluated for every fragment and never appear in the tile lists
+    this->gpu_lights_.clear();
+    for (int pass = 0; pass < 2; pass++)
+    {
+        for (const Light &light : this->lights_)
+        {
+            if ((light.type == LightType::DIRECTIONAL) != (pass == 0))
+            {
+                continue;
+            }
+            float scale = light.intensity / 255.0f;
+            this->gpu_lights_.push_back(GpuLight{
+                {light.position.x, light.position.y, light.position.z, (float)light.type},
+                {light.direction.x, light.direction.y, light.direction.z, light.range},
+                {light.color.r * scale, light.color.g * scale, light.color.b * scale, 1.0f},
+                {light.inner_cos, light.outer_cos, 0.0f, 0.0f}});
+        }
+        if (pass == 0)
+        {
+            this->directional_count_ = this->gpu_lights_.size();
+        }
+    }
+
+    const gl_loader::Functions &gl = gl_loader::get_functions();
+    int counts[4] = {(int)this->gpu_lights_.size(), (int)this->directional_count_, 0, 0};
+    gl.glBindBuffer(gl_loader::GL_UNIFORM_BUFFER, this->buffer_);
+    if (!this->gpu_lights_.empty())
+    {
+        gl.glBufferSubData(gl_loader::GL_UNIFORM_BUFFER, 0, sizeof(GpuLight) * this->gpu_lights_.size(), this->gpu_lights_.data());
+    }
+    gl.glBufferSubData(gl_loader::GL_UNIFORM_BUFFER, sizeof(GpuLight) * MAX_LIGHTS, sizeof(counts), counts);
+    gl.glBindBuffer(gl_loader::GL_UNIFORM_BUFFER, 0);
+    this->lights_dirty_ = false;
+}
+
+void SceneLights::build_tiles(const Matrix &view, const Matrix &projection, bool perspective)
+{
+    std::fill(this->tile_lights_.begin(), this->tile_lights_.end(), 0);
+    std::fill(this->tile_counts_.begin(), this->tile_counts_.end(), 0);
+    this->dropped_lights_ = 0;
+
+    // Maps a normalized device coordinate to a tile index
+    auto to_tile = [](float ndc, int size, int tiles) -> int
+    {
+        return std::clamp((int)((ndc * 0.5f + 0.5f) * size / TILE_SIZE), 0, tiles - 1);
+    };
+
+    for (size_t i = this->directional_count_; i < this->gpu_lights_.size(); i++)
+    {
+        const GpuLight &light = this->gpu_lights_[i];
+        float range = light.direction[3];
+        Vector3 center = Vector3Transform({light.position[0], light.position[1], light.position[2]}, view);
+        float depth = -center.z;
+        if (depth + range <= RL_CULL_DISTANCE_NEAR)
+        {
+            continue; // Behind the camera
+        }
+
+        // Screen rectangle of the box around the light range, in normalized device coordinates
+        float x_min = -1.0f, x_max = 1.0f, y_min = -1.0f, y_max = 1.0f;
+        if (!perspective)
+        {
+            x_min = (center.x - range) * projection.m0;
+            x_max = (center.x + range) * projection.m0;
+            y_min = (center.y - range) * projection.m5;
+            y_max = (center.y + range) * projection.m5;
+        }
+        else if (depth - range > RL_CULL_DISTANCE_NEAR)
+        {
+            // Bounds of x / depth over the box (the nearest depth gives the widest extent)
+            float near_depth = depth - range;
+            float far_depth = depth + range;
+            auto lower = [&](float v) { return v < 0.0f ? v / near_depth : v / far_depth; };
+            auto upper = [&](float v) { return v > 0.0f ? v / near_depth : v / far_depth; };
+            x_min = lower(center.x - range) * projection.m0;
+            x_max = upper(center.x + range) * projection.m0;
+            y_min = lower(center.y - range) * projection.m5;
+            y_max = upper(center.y + range) * projection.m5;
+        }
+        // Otherwise the camera is inside (or very close to) the range and the light covers the whole screen
+        if (x_max < -1.0f || x_min > 1.0f || y_max < -1.0f || y_min > 1.0f)
+        {
+            continue;
+        }
+
+        // Tile rows start at the bottom of the screen, like gl_FragCoord
+        int tx_min = to_tile(x_min, this->width_, this->tiles_x_);
+        int tx_max = to_tile(x_max, this->width_, this->tiles_x_);
+        int ty_min = to_tile(y_min, this->height_, this->tiles_y_);
+        int ty_max = to_tile(y_max, this->height_, this->tiles_y_);
+        for (int ty = ty_min; ty <= ty_max; ty++)
+        {
+            for (int tx = tx_min; tx <= tx_max; tx++)
+            {
+                size_t tile = (size_t)ty * this->tiles_x_ + tx;
+                unsigned char &count = this->tile_counts_[tile];
+                if (count < TILE_SLOTS)
+                {
+                    this->tile_lights_[tile * TILE_SLOTS + count] = (unsigned char)(i + 1);
+                    count++;
+                }
+                else
+                {
+                    this->dropped_lights_++;
+                }
+            }
+        }
+    }
+
+    rlUpdateTexture(this->tile_texture_, 0, 0, this->tiles_x_ * TILE_SLOTS / 4, this->tiles_y_, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8, this->tile_lights_.data());
+    this->tiles_empty_ = this->gpu_lights_.size() == this->directional_count_;
+}
+
+void SceneLights::update(const Camera &camera, int width, int height)
+{
+    if (!this->loaded_)
+    {
+        return;
+    }
+    if (width != this->width_ || height != this->height_)
+    {
+        this->load(width, height);
+    }
+    bool lights_changed = this->lights_dirty_;
+    if (lights_changed)
+    {
+        this->upload_lights();
+    }
+
+    // Same matrices as BeginMode3D
+    Matrix projection;
+    bool perspective = camera.projection != CAMERA_ORTHOGRAPHIC;
+    if (!perspective)
+    {
+        double aspect = (double)width / height;
+        double top = camera.fovy / 2.0;
+        projection = MatrixOrtho(-top * aspect, top * aspect, -top, top, RL_CULL_DISTANCE_NEAR, RL_CULL_DISTANCE_FAR);
+    }
+    else
+    {
+        projection = MatrixPerspective(camera.fovy * DEG2RAD, (double)width / height, RL_CULL_DISTANCE_NEAR, RL_CULL_DISTANCE_FAR);
+    }
+    Matrix view = MatrixLookAt(camera.position, camera.target, camera.up);
+    Matrix view_projection = MatrixMultiply(view, projection);
+
+    // The lists only change with the camera or the lights, and stay cleared while there are no point or spot lights
+    bool camera_changed = std::memcmp(&view_projection, &this->view_projection_, sizeof(Matrix)) != 0;
+    bool local_lights = this->gpu_lights_.size() > this->directional_count_;
+    if ((!lights_changed && !camera_changed) || (!local_lights && this->tiles_empty_))
+    {
+        return;
+    }
+    this->view_projection_ = view_projection;
+    this->build_tiles(view, projection, perspective);
+}
+
+void SceneLights::apply(const Shader &shader)
+{
+    auto found = this->locations_.find(shader.id);
+    if (found == this->locations_.end())
+    {
+        ShaderLocations locations = {
+            GetShaderLocation(shader, "mainLightDirection"),
+            GetShaderLocation(shader, "mainLightColor"),
+            GetShaderLocation(shader, "extraLightsEnabled"),
+            GetShaderLocation(shader, "lightTiles")};
+        found = this->locations_.insert({shader.id, locations}).first;
+        if (this->loaded_)
+        {
+            const gl_loader::Functions &gl = gl_loader::get_functions();
+            unsigned int block = gl.glGetUniformBlockIndex(shader.id, "Lights");
+            if (block != gl_loader::GL_INVALID_INDEX)
+            {
+                gl.glUniformBlockBinding(shader.id, block, BLOCK_BINDING);
+            }
+        }
+    }
+    const ShaderLocations &locations = found->second;
+
+    float color[4] = {this->main_color_.r / 255.0f, this->main_color_.g / 255.0f, this->main_color_.b / 255.0f, 1.0f};
+    SetShaderValue(shader, locations.main_direction, &this->main_direction_, SHADER_UNIFORM_VEC3);
+    SetShaderValue(shader, locations.main_color, color, SHADER_UNIFORM_VEC4);
+    int extra_lights = this->loaded_ && !this->gpu_lights_.empty() ? 1 : 0;
+    SetShaderValue(shader, locations.extra_lights, &extra_lights, SHADER_UNIFORM_INT);
+    if (!extra_lights)
+    {
+        return;
+    }
+    int unit = TEXTURE_UNIT;
+    SetShaderValue(shader, locations.tiles, &unit, SHADER_UNIFORM_INT);
+    gl_loader::get_functions().glBindBufferBase(gl_loader::GL_UNIFORM_BUFFER, BLOCK_BINDING, this->buffer_);
+    rlActiveTextureSlot(TEXTURE_UNIT);
+    rlEnableTexture(this->tile_texture_);
+    rlActiveTextureSlot(0);
+}
+
+void SceneLights::unbind() const
+{
+    rlActiveTextureSlot(TEXTURE_UNIT);
+    rlDisableTexture();
+    rlActiveTextureSlot(0);
+}
+
+size_t SceneLights::get_dropped_lights() const
+{
+    return this->dropped_lights_;
+}
@@ -0,0 +1,200 @@
+#pragma once
+#include <raylib.h>
+#include <raymath.h>
+#include <cstddef>
+#include <map>
+#include <vector>
+
+#include "SlotMap.hpp"
+
+/**
+ * @brief Lights of the lighting shader: a main directional light (the one casting the shadows) and up to MAX_LIGHTS
+ * additional directional, point and spot lights.
+ *
+ * The additional lights are stored in a uniform buffer, uploaded only when they change. Point and spot lights are
+ * culled per screen tile on the CPU: the bounds of every light are projected to the screen and the light is added
+ * to the list of the tiles it covers. The lists are uploaded in a small texture read by the fragment shader, so a
+ * fragment only evaluates the lights that can reach its tile. The lists are only rebuilt when the camera or the lights change.
+ * If uniform buffers are not available, only the main light is used.
+ */
+class SceneLights
+{
+public:
+    static constexpr size_t MAX_LIGHTS = 64;       // Capacity of the uniform buffer (MAX_LIGHTS in lighting.fs).
+    static constexpr int TILE_SIZE = 16;           // Width and height of the screen tiles in pixels (LIGHT_TILE_SIZE in lighting.fs).
+    static constexpr int TILE_SLOTS = 32;          // Maximum number of point and spot lights per tile (4 per texel of the tile texture).
+    static constexpr int TEXTURE_UNIT = 13;        // Texture unit of the tile lists while the scene is drawn.
+    static constexpr unsigned int BLOCK_BINDING = 1; // Binding point of the uniform buffer.
+
+private:
+    /**
+     * @brief Types of the additional lights (the values are read by lighting.fs).
+     */
+    enum class LightType
+    {
+        DIRECTIONAL = 0, // Parallel rays, lights the whole scene.
+        POINT = 1,       // Omnidirectional light with a limited range.
+        SPOT = 2         // Cone of light with a limited range.
+    };
+
+    /**
+     * @brief Light added by the user.
+     */
+    struct Light
+    {
+        LightType type;     // Type of the light.
+        Vector3 position;   // Position (point and spot lights).
+        Vector3 direction;  // Direction of the rays (directional and spot lights).
+        Color color;        // Color of the light.
+        float intensity;    // Factor applied to the color.
+        float range;        // Distance at which the light fades out completely (point and spot lights).
+        float inner_cos;    // Cosine of the angle inside which a spot light has its full intensity.
+        float outer_cos;    // Cosine of the angle outside which a spot light does not light.
+    };
+
+    /**
+     * @brief Light as stored in the uniform buffer (std140 layout).
+     */
+    struct GpuLight
+    {
+        float position[4];  // Position and type.
+        float direction[4]; // Direction and range.
+        float color[4];     // Color multiplied by the intensity.
+        float cone[4];      // Cosines of the inner and outer angles of a spot light.
+    };
+
+    /**
+     * @brief Uniform locations of the light inputs of a lighting shader.
+     */
+    struct ShaderLocations
+    {
+        int main_direction; // mainLightDirection
+        int main_color;     // mainLightColor
+        int extra_lights;   // extraLightsEnabled
+        int tiles;          // lightTiles
+    };
+
+    SlotMap<Light> lights_;                    // Additional lights referenced by generational handles.
+    Vector3 main_direction_ = {0.0f, -1.0f, 0.0f}; // Direction of the rays of the main light.
+    Color main_color_ = WHITE;                 // Color of the main light.
+    std::vector<GpuLight> gpu_lights_;         // Content of the uniform buffer, directional lights first.
+    size_t directional_count_ = 0;             // Number of directional lights at the start of the uniform buffer.
+    std::vector<unsigned char> tile_lights_;   // Light index + 1 of every slot of every tile (0 ends a list).
+    std::vector<unsigned char> tile_counts_;   // Number of lights of every tile (reused every rebuild).
+    int width_ = 0;                            // Width of the render target in pixels.
+    int height_ = 0;                           // Height of the render target in pixels.
+    int tiles_x_ = 0;                          // Number of tile columns.
+    int tiles_y_ = 0;                          // Number of tile rows.
+    bool tiles_empty_ = true;                  // Flag indicating whether the tile lists are all empty.
+    Matrix view_projection_ = MatrixIdentity(); // View-projection the tile lists were built with.
+    unsigned int buffer_ = 0;                  // Uniform buffer of the additional lights.
+    unsigned int tile_texture_ = 0;            // Tile lists (RGBA8, TILE_SLOTS / 4 texels per tile).
+    bool loaded_ = false;                      // Flag indicating whether the uniform buffer and the tile texture are loaded.
+    bool lights_dirty_ = true;                 // Flag indicating whether the lights changed since the last upload.
+    size_t dropped_lights_ = 0;                // Tile slots missing in the last rebuild (tiles with more than TILE_SLOTS lights).
+    std::map<unsigned int, ShaderLocations> locations_; // Uniform locations by shader id.
+
+    /**
+     * @brief Adds a light and marks the buffer for upload.
+     */
+    int add_light(const Light &light);
+
+    /**
+     * @brief Rebuilds the content of the uniform buffer and uploads it.
+     */
+    void upload_lights();
+
+    /**
+     * @brief Rebuilds the light lists of the tiles and uploads them.
+     */
+    void build_tiles(const Matrix &view, const Matrix &projection, bool perspective);
+
+public:
+    /**
+     * @brief Loads the uniform buffer and the tile texture.
+     * @param width Width of the render target in pixels.
+     * @param height Height of the render target in pixels.
+     * @return False if uniform buffers are not available (only the main light is used).
+     */
+    bool load(int width, int height);
+
+    /**
+     * @brief Unloads the GPU resources (the lights are kept). Safe to call more than once.
+     */
+    void unload();
+
+    /**
+     * @brief Sets the main directional light (the one casting the shadows).
+     * @param direction Direction of the rays.
+     * @param color Color of the light.
+     */
+    void set_main_light(Vector3 direction, Color color);
+
+    /**
+     * @brief Adds a directional light.
+     * @return Handle of the light, or -1 if there are already MAX_LIGHTS lights.
+     */
+    int add_directional_light(Vector3 direction, Color color, float intensity);
+
+    /**
+     * @brief Adds a point light.
+     * @return Handle of the light, or -1 if there are already MAX_LIGHTS lights.
+     */
+    int add_point_light(Vector3 position, Color color, float intensity, float range);
+
+    /**
+     * @brief Adds a spot light.
+     * @param inner_angle Half angle of the cone of full intensity, in degrees.
+     * @param outer_angle Half angle of the cone of light, in degrees.
+     * @return Handle of the light, or -1 if there are already MAX_LIGHTS lights.
+     */
+    int add_spot_light(Vector3 position, Vector3 direction, Color color, float intensity, float range, float inner_angle, float outer_angle);
+
+    /**
+     * @brief Moves a light.
+     */
+    void set_light_pose(int handle, Vector3 position, Vector3 direction);
+
+    /**
+     * @brief Changes the color and intensity of a light.
+     */
+    void set_light_color(int handle, Color color, float intensity);
+
+    /**
+     * @brief Removes a light. Invalid handles are ignored.
+     */
+    void remove_light(int handle);
+
+    /**
+     * @brief Removes all the additional lights.
+     */
+    void clear();
+
+    /**
+     * @brief Gets the number of additional lights.
+     */
+    size_t size() const;
+
+    /**
+     * @brief Uploads the lights that changed and rebuilds the tile lists if the camera or the lights changed.
+     * @param camera Camera of the scene.
+     * @param width Width of the render target in pixels.
+     * @param height Height of the render target in pixels.
+     */
+    void update(const Camera &camera, int width, int height);
+
+    /**
+     * @brief Sets the light uniforms of a lighting shader and binds the buffer and the tile lists.
+     */
+    void apply(const Shader &shader);
+
+    /**
+     * @brief Unbinds the tile lists from their texture unit.
+     */
+    void unbind() const;
+
+    /**
+     * @brief Gets the number of tile slots that were missing in the last rebuild (lights skipped in crowded tiles).
+     */
+    size_t get_dropped_lights() const;
+};
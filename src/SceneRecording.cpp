@@ -0,0 +1,591 @@
+#include "SceneRecording.hpp"
+#include <algorithm>
+#include <cstring>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// File layout:
+//   header   "RVSCENE1", uint32 version, uint32 keyframe interval
+//   records  uint32 type, uint32 payload size, payload (keyframes and delta frames, then the index)
+//   footer   uint64 offset of the index record, "RVINDEX1" (missing if the recorder was not closed)
+namespace
+{
+    const char FILE_MAGIC[8] = {'R', 'V', 'S', 'C', 'E', 'N', 'E', '1'};
+    const char INDEX_MAGIC[8] = {'R', 'V', 'I', 'N', 'D', 'E', 'X', '1'};
+    constexpr uint32_t FILE_VERSION = 1;
+    constexpr size_t HEADER_SIZE = 16;
+    constexpr size_t RECORD_HEADER_SIZE = 8;
+    constexpr size_t FOOTER_SIZE = 16;
+
+    enum RecordType : uint32_t
+    {
+        RECORD_KEYFRAME = 1,
+        RECORD_DELTA = 2,
+        RECORD_INDEX = 3
+    };
+
+    template <typename T>
+    void append(std::vector<unsigned char> &buffer, const T &value)
+    {
+        const unsigned char *bytes = reinterpret_cast<const unsigned char *>(&value);
+        buffer.insert(buffer.end(), bytes, bytes + sizeof(T));
+    }
+
+    void append_object(std::vector<unsigned char> &buffer, const RecordedObject &object)
+    {
+        append(buffer, object.handle);
+        append(buffer, object.position);
+        append(buffer, object.orientation);
+        append(buffer, object.scale);
+        append(buffer, object.color);
+    }
+
+    bool same_object(const RecordedObject &a, const RecordedObject &b)
+    {
+        return memcmp(&a.position, &b.position, sizeof(Vector3)) == 0 &&
+               memcmp(&a.orientation, &b.orientation, sizeof(Quaternion)) == 0 &&
+               memcmp(&a.scale, &b.scale, sizeof(Vector3)) == 0 &&
+               memcmp(&a.color, &b.color, sizeof(Color)) == 0;
+    }
+
+    bool handle_less(const RecordedObject &object, int32_t handle)
+    {
+        return object.handle < handle;
+    }
+
+    /**
+     * @brief Bounds-checked reader over the mapped file (fields are not aligned).
+     */
+    struct Reader
+    {
+        const unsigned char *position;
+        const unsigned char *end;
+
+        template <typename T>
+        bool read(T &value)
+        {
+            if ((size_t)(this->end - this->position) < sizeof(T))
+            {
+                return false;
+            }
+            memcpy(&value, this->position, sizeof(T));
+            this->position += sizeof(T);
+            return true;
+        }
+
+        bool read_object(RecordedObject &object)
+        {
+            return this->read(object.handle) && this->read(object.position) && this->read(object.orientation) &&
+                   this->read(object.scale) && this->read(object.color);
+        }
+    };
+}
+
+void SceneFrame::clear()
+{
+    this->objects.clear();
+    this->lines.clear();
+    this->arrows.clear();
+    this->segments.clear();
+    this->labels.clear();
+}
+
+SceneRecorder::~SceneRecorder()
+{
+    this->close();
+}
+
+bool SceneRecorder::open(const std::string &path, int keyframe_interval)
+{
+    this->close();
+    this->failed_ = false;
+    this->file_ = fopen(path.c_str(), "wb");
+    if (this->file_ == nullptr)
+    {
+        TraceLog(LOG_WARNING, "RECORDER: Failed to create %s", path.c_str());
+        return false;
+    }
+
+    this->keyframe_interval_ = (uint32_t)std::max(keyframe_interval, 1);
+    this->offset_ = 0;
+    this->frame_count_ = 0;
+    this->keyframe_offsets_.clear();
+    this->previous_objects_.clear();
+
+    uint32_t version = FILE_VERSION;
+    this->write(FILE_MAGIC, sizeof(FILE_MAGIC));
+    this->write(&version, sizeof(version));
+    if (!this->write(&this->keyframe_interval_, sizeof(this->keyframe_interval_)))
+    {
+        this->close();
+        return false;
+    }
+    return true;
+}
+
+bool SceneRecorder::write(const void *data, size_t size)
+{
+    if (this->failed_)
+    {
+        return false;
+    }
+    // The offsets of the index must only point at data that is in the file
+    if (fwrite(data, 1, size, this->file_) != size)
+    {
+        TraceLog(LOG_WARNING, "RECORDER: Failed to write the recording, stopped after %llu frames", (unsigned long long)this->frame_count_);
+        this->failed_ = true;
+        return false;
+    }
+    this->offset_ += size;
+    return true;
+}
+
+void SceneRecorder::close()
+{
+    if (this->file_ == nullptr)
+    {
+        return;
+    }
+    if (this->failed_)
+    {
+        fclose(this->file_);
+        this->file_ = nullptr;
+        return;
+    }
+
+    uint64_t index_offset = this->offset_;
+    uint64_t keyframe_count = this->keyframe_offsets_.size();
+    uint32_t type = RECORD_INDEX;
+    uint32_t size = (uint32_t)(2 * sizeof(uint64_t) + keyframe_count * sizeof(uint64_t));
+    this->write(&type, sizeof(type));
+    this->write(&size, sizeof(size));
+    this->write(&this->frame_count_, sizeof(this->frame_count_));
+    this->write(&keyframe_count, sizeof(keyframe_count));
+    this->write(this->keyframe_offsets_.data(), keyframe_count * sizeof(uint64_t));
+    this->write(&index_offset, sizeof(index_offset));
+    this->write(INDEX_MAGIC, sizeof(INDEX_MAGIC));
+
+    // Buffered data that could not be flushed is only reported here
+    if (fclose(this->file_) != 0 && !this->failed_)
+    {
+        TraceLog(LOG_WARNING, "RECORDER: Failed to write the end of the recording");
+        this->failed_ = true;
+    }
+    this->file_ = nullptr;
+}
+
+bool SceneRecorder::is_open() const
+{
+    return this->file_ != nullptr && !this->failed_;
+}
+
+bool SceneRecorder::has_failed() const
+{
+    return this->failed_;
+}
+
+SceneFrame &SceneRecorder::begin_frame(double time)
+{
+    this->frame_.clear();
+    this->frame_.time = time;
+    return this->frame_;
+}
+
+void SceneRecorder::end_frame()
+{
+    if (!this->is_open())
+    {
+        return;
+    }
+
+    std::vector<RecordedObject> &objects = this->frame_.objects;
+    std::sort(objects.begin(), objects.end(), [](const RecordedObject &a, const RecordedObject &b)
+              { return a.handle < b.handle; });
+
+    // Delta frames only store the objects that differ from the previous frame
+    bool keyframe = this->frame_count_ % this->keyframe_interval_ == 0;
+    this->changed_objects_.clear();
+    this->removed_handles_.clear();
+    if (keyframe)
+    {
+        this->changed_objects_.assign(objects.begin(), objects.end());
+    }
+    else
+    {
+        size_t i = 0, j = 0;
+        while (i < objects.size() || j < this->previous_objects_.size())
+        {
+            if (j == this->previous_objects_.size() || (i < objects.size() && objects[i].handle < this->previous_objects_[j].handle))
+            {
+                this->changed_objects_.push_back(objects[i++]);
+            }
+            else if (i == objects.size() || this->previous_objects_[j].handle < objects[i].handle)
+            {
+                this->removed_handles_.push_back(this->previous_objects_[j++].handle);
+            }
+            else
+            {
+                if (!same_object(objects[i], this->previous_objects_[j]))
+                {
+                    this->changed_objects_.push_back(objects[i]);
+                }
+                i++;
+                j++;
+            }
+        }
+    }
+
+    std::vector<unsigned char> &buffer = this->buffer_;
+    buffer.clear();
+    append(buffer, (uint32_t)(keyframe ? RECORD_KEYFRAME : RECORD_DELTA));
+    append(buffer, (uint32_t)0); // Payload size, filled below
+    append(buffer, this->frame_.time);
+    append(buffer, (uint32_t)this->changed_objects_.size());
+    append(buffer, (uint32_t)this->removed_handles_.size());
+    append(buffer, (uint32_t)this->frame_.lines.size());
+    append(buffer, (uint32_t)this->frame_.arrows.size());
+    append(buffer, (uint32_t)this->frame_.segments.size());
+    append(buffer, (uint32_t)this->frame_.labels.size());
+    for (const RecordedObject &object : this->changed_objects_)
+    {
+        append_object(buffer, object);
+    }
+    for (int32_t handle : this->removed_handles_)
+    {
+        append(buffer, handle);
+    }
+    for (const RecordedLine &line : this->frame_.lines)
+    {
+        append(buffer, line.start_pos);
+        append(buffer, line.end_pos);
+        append(buffer, line.color);
+    }
+    for (const RecordedArrow &arrow : this->frame_.arrows)
+    {
+        append(buffer, arrow.origin);
+        append(buffer, arrow.vector);
+        append(buffer, arrow.radius);
+        append(buffer, arrow.color);
+    }
+    for (const RecordedSegment &segment : this->frame_.segments)
+    {
+        append(buffer, segment.start_pos);
+        append(buffer, segment.end_pos);
+        append(buffer, segment.scale);
+        append(buffer, segment.color);
+    }
+    for (const RecordedLabel &label : this->frame_.labels)
+    {
+        append(buffer, label.position);
+        append(buffer, label.font_size);
+        append(buffer, label.color);
+        append(buffer, (uint8_t)label.background);
+        append(buffer, label.background_color);
+        append(buffer, (uint32_t)label.text.size());
+        buffer.insert(buffer.end(), label.text.begin(), label.text.end());
+    }
+    uint32_t payload_size = (uint32_t)(buffer.size() - RECORD_HEADER_SIZE);
+    memcpy(&buffer[sizeof(uint32_t)], &payload_size, sizeof(payload_size));
+
+    uint64_t frame_offset = this->offset_;
+    if (!this->write(buffer.data(), buffer.size()))
+    {
+        return;
+    }
+    if (keyframe)
+    {
+        this->keyframe_offsets_.push_back(frame_offset);
+    }
+    this->frame_count_++;
+    this->previous_objects_.swap(objects);
+}
+
+size_t SceneRecorder::get_frame_count() const
+{
+    return this->frame_count_;
+}
+
+size_t SceneRecorder::get_size() const
+{
+    return this->offset_;
+}
+
+ScenePlayer::~ScenePlayer()
+{
+    this->close();
+}
+
+bool ScenePlayer::open(const std::string &path)
+{
+    this->close();
+
+#ifndef _WIN32
+    int descriptor = ::open(path.c_str(), O_RDONLY);
+    if (descriptor < 0)
+    {
+        TraceLog(LOG_WARNING, "PLAYER: Failed to open %s", path.c_str());
+        return false;
+    }
+    struct stat file_stat;
+    if (fstat(descriptor, &file_stat) == 0 && file_stat.st_size > 0)
+    {
+        void *data = mmap(nullptr, file_stat.st_size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+        if (data != MAP_FAILED)
+        {
+            this->data_ = (const unsigned char *)data;
+            this->size_ = file_stat.st_size;
+            this->mapped_ = true;
+        }
+    }
+    ::close(descriptor);
+#else
+    int size = 0;
+    unsigned char *data = LoadFileData(path.c_str(), &size);
+    if (data != nullptr)
+    {
+        this->buffer_.assign(data, data + size);
+        UnloadFileData(data);
+        this->data_ = this->buffer_.data();
+        this->size_ = this->buffer_.size();
+    }
+#endif
+
+    if (this->data_ == nullptr || this->size_ < HEADER_SIZE || memcmp(this->data_, FILE_MAGIC, sizeof(FILE_MAGIC)) != 0)
+    {
+        TraceLog(LOG_WARNING, "PLAYER: %s is not a scene recording", path.c_str());
+        this->close();
+        return false;
+    }
+    memcpy(&this->keyframe_interval_, this->data_ + 12, sizeof(uint32_t));
+    if (this->keyframe_interval_ == 0 || (!this->read_index() && !this->rebuild_index()))
+    {
+        this->close();
+        return false;
+    }
+    return true;
+}
+
+bool ScenePlayer::read_index()
+{
+    if (this->size_ < HEADER_SIZE + FOOTER_SIZE || memcmp(this->data_ + this->size_ - sizeof(INDEX_MAGIC), INDEX_MAGIC, sizeof(INDEX_MAGIC)) != 0)
+    {
+        return false;
+    }
+    uint64_t index_offset;
+    memcpy(&index_offset, this->data_ + this->size_ - FOOTER_SIZE, sizeof(index_offset));
+    if (index_offset < HEADER_SIZE || index_offset > this->size_ - FOOTER_SIZE)
+    {
+        return false;
+    }
+
+    Reader reader = {this->data_ + index_offset, this->data_ + this->size_ - FOOTER_SIZE};
+    uint32_t type, size;
+    uint64_t frame_count, keyframe_count;
+    if (!reader.read(type) || !reader.read(size) || type != RECORD_INDEX ||
+        !reader.read(frame_count) || !reader.read(keyframe_count) ||
+        keyframe_count > (size_t)(reader.end - reader.position) / sizeof(uint64_t))
+    {
+        return false;
+    }
+    this->keyframe_offsets_.resize(keyframe_count);
+    memcpy(this->keyframe_offsets_.data(), reader.position, keyframe_count * sizeof(uint64_t));
+    this->frame_count_ = frame_count;
+    return true;
+}
+
+bool ScenePlayer::rebuild_index()
+{
+    // The recording was not closed: walk the frame headers (a truncated last frame is ignored)
+    TraceLog(LOG_INFO, "PLAYER: Recording has no index, rebuilding it");
+    uint64_t offset = HEADER_SIZE;
+    while (offset + RECORD_HEADER_SIZE <= this->size_)
+    {
+        uint32_t type, size;
+        memcpy(&type, this->data_ + offset, sizeof(type));
+        memcpy(&size, this->data_ + offset + sizeof(type), sizeof(size));
+        if ((type != RECORD_KEYFRAME && type != RECORD_DELTA) || offset + RECORD_HEADER_SIZE + size > this->size_)
+        {
+            break;
+        }
+        if (type == RECORD_KEYFRAME)
+        {
+            this->keyframe_offsets_.push_back(offset);
+        }
+        this->frame_count_++;
+        offset += RECORD_HEADER_SIZE + size;
+    }
+    return true;
+}
+
+uint64_t ScenePlayer::decode_frame(uint64_t offset)
+{
+    if (offset + RECORD_HEADER_SIZE > this->size_)
+    {
+        return 0;
+    }
+    Reader reader = {this->data_ + offset, this->data_ + this->size_};
+    uint32_t type, size;
+    reader.read(type);
+    reader.read(size);
+    if ((type != RECORD_KEYFRAME && type != RECORD_DELTA) || size > (size_t)(reader.end - reader.position))
+    {
+        return 0;
+    }
+    reader.end = reader.position + size;
+
+    uint32_t object_count, removed_count, line_count, arrow_count, segment_count, label_count;
+    if (!reader.read(this->frame_.time) || !reader.read(object_count) || !reader.read(removed_count) ||
+        !reader.read(line_count) || !reader.read(arrow_count) || !reader.read(segment_count) || !reader.read(label_count))
+    {
+        return 0;
+    }
+
+    std::vector<RecordedObject> &objects = this->frame_.objects;
+    if (type == RECORD_KEYFRAME)
+    {
+        objects.clear();
+    }
+    for (uint32_t i = 0; i < object_count; i++)
+    {
+        RecordedObject object;
+        if (!reader.read_object(object))
+        {
+            return 0;
+        }
+        auto it = std::lower_bound(objects.begin(), objects.end(), object.handle, handle_less);
+        if (it != objects.end() && it->handle == object.handle)
+        {
+            *it = object;
+        }
+        else
+        {
+            objects.insert(it, object);
+        }
+    }
+    for (uint32_t i = 0; i < removed_count; i++)
+    {
+        int32_t handle;
+        if (!reader.read(handle))
+        {
+            return 0;
+        }
+        auto it = std::lower_bound(objects.begin(), objects.end(), handle, handle_less);
+        if (it != objects.end() && it->handle == handle)
+        {
+            objects.erase(it);
+        }
+    }
+
+    this->frame_.lines.resize(line_count);
+    for (RecordedLine &line : this->frame_.lines)
+    {
+        if (!reader.read(line.start_pos) || !reader.read(line.end_pos) || !reader.read(line.color))
+        {
+            return 0;
+        }
+    }
+    this->frame_.arrows.resize(arrow_count);
+    for (RecordedArrow &arrow : this->frame_.arrows)
+    {
+        if (!reader.read(arrow.origin) || !reader.read(arrow.vector) || !reader.read(arrow.radius) || !reader.read(arrow.color))
+        {
+            return 0;
+        }
+    }
+    this->frame_.segments.resize(segment_count);
+    for (RecordedSegment &segment : this->frame_.segments)
+    {
+        if (!reader.read(segment.start_pos) || !reader.read(segment.end_pos) || !reader.read(segment.scale) || !reader.read(segment.color))
+        {
+            return 0;
+        }
+    }
+    this->frame_.labels.resize(label_count);
+    for (RecordedLabel &label : this->frame_.labels)
+    {
+        uint8_t background;
+        uint32_t length;
+        if (!reader.read(label.position) || !reader.read(label.font_size) || !reader.read(label.color) ||
+            !reader.read(background) || !reader.read(label.background_color) || !reader.read(length) ||
+            length > (size_t)(reader.end - reader.position))
+        {
+            return 0;
+        }
+        label.background = background != 0;
+        label.text.assign((const char *)reader.position, length);
+        reader.position += length;
+    }
+    return offset + RECORD_HEADER_SIZE + size;
+}
+
+void ScenePlayer::close()
+{
+#ifndef _WIN32
+    if (this->mapped_)
+    {
+        munmap((void *)this->data_, this->size_);
+    }
+#endif
+    this->buffer_.clear();
+    this->data_ = nullptr;
+    this->size_ = 0;
+    this->mapped_ = false;
+    this->keyframe_interval_ = 0;
+    this->frame_count_ = 0;
+    this->keyframe_offsets_.clear();
+    this->frame_.clear();
+    this->has_frame_ = false;
+}
+
+bool ScenePlayer::is_open() const
+{
+    return this->data_ != nullptr;
+}
+
+size_t ScenePlayer::get_frame_count() const
+{
+    return this->frame_count_;
+}
+
+const SceneFrame *ScenePlayer::seek(size_t frame)
+{
+    if (this->frame_count_ == 0)
+    {
+        return nullptr;
+    }
+    frame = std::min(frame, this->frame_count_ - 1);
+    if (this->has_frame_ && frame == this->current_frame_)
+    {
+        return &this->frame_;
+    }
+
+    // Decode forward from the current frame if it is in the same keyframe interval, else from the keyframe
+    size_t keyframe = frame / this->keyframe_interval_;
+    if (!this->has_frame_ || frame < this->current_frame_ || this->current_frame_ / this->keyframe_interval_ != keyframe)
+    {
+        if (keyframe >= this->keyframe_offsets_.size())
+        {
+            return nullptr;
+        }
+        this->next_offset_ = this->decode_frame(this->keyframe_offsets_[keyframe]);
+        this->current_frame_ = keyframe * this->keyframe_interval_;
+        this->has_frame_ = this->next_offset_ != 0;
+    }
+    while (this->has_frame_ && this->current_frame_ < frame)
+    {
+        this->next_offset_ = this->decode_frame(this->next_offset_);
+        this->has_frame_ = this->next_offset_ != 0;
+        this->current_frame_++;
+    }
+    return this->has_frame_ ? &this->frame_ : nullptr;
+}
+
+size_t ScenePlayer::get_current_frame() const
+{
+    return this->current_frame_;
+}
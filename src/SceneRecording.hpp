@@ -0,0 +1,229 @@
+#pragma once
+#include <raylib.h>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+/**
+ * @brief State of a visual object stored in a scene recording.
+ */
+struct RecordedObject
+{
+    int32_t handle;         // Handle of the visual object.
+    Vector3 position;       // Position of the visual object.
+    Quaternion orientation; // Orientation of the visual object.
+    Vector3 scale;          // Scale of the visual object.
+    Color color;            // Color of the visual object.
+};
+
+/**
+ * @brief Line stored in a scene recording.
+ */
+struct RecordedLine
+{
+    Vector3 start_pos; // Start position of the line.
+    Vector3 end_pos;   // End position of the line.
+    Color color;       // Color of the line.
+};
+
+/**
+ * @brief Arrow stored in a scene recording.
+ */
+struct RecordedArrow
+{
+    Vector3 origin; // Origin of the arrow.
+    Vector3 vector; // Direction and length of the arrow.
+    float radius;   // Radius of the arrow.
+    Color color;    // Color of the arrow.
+};
+
+/**
+ * @brief Segment stored in a scene recording.
+ */
+struct RecordedSegment
+{
+    Vector3 start_pos; // Start position of the segment.
+    Vector3 end_pos;   // End position of the segment.
+    float scale;       // Thickness of the segment.
+    Color color;       // Color of the segment.
+};
+
+/**
+ * @brief Text label stored in a scene recording (the font is not recorded).
+ */
+struct RecordedLabel
+{
+    std::string text;          // Text content of the label.
+    Vector3 position;          // Position of the label.
+    float font_size;           // Font size of the label.
+    Color color;               // Color of the label.
+    bool background;           // Flag indicating whether the label has a background.
+    Color background_color;    // Background color.
+};
+
+/**
+ * @brief Scene state of one frame: the visual objects and the immediate-mode primitives drawn in it.
+ */
+struct SceneFrame
+{
+    double time = 0.0;                    // Time at which the frame was recorded, in seconds.
+    std::vector<RecordedObject> objects;  // Visual objects, sorted by handle.
+    std::vector<RecordedLine> lines;      // Lines drawn in the frame.
+    std::vector<RecordedArrow> arrows;    // Arrows drawn in the frame.
+    std::vector<RecordedSegment> segments; // Segments drawn in the frame.
+    std::vector<RecordedLabel> labels;    // Text labels drawn in the frame.
+
+    /**
+     * @brief Removes all the objects and primitives (keeps the allocated memory).
+     */
+    void clear();
+};
+
+/**
+ * @brief Appends scene frames to a binary log.
+ *
+ * Every keyframe_interval frames a keyframe holding every object is written, the frames in between only
+ * store the objects that changed or were removed (the primitives are stored in full, they only live one frame).
+ * The offsets of the keyframes are written as an index at the end of the file when the recorder is closed.
+ */
+class SceneRecorder
+{
+private:
+    FILE *file_ = nullptr;                        // Output file.
+    uint32_t keyframe_interval_ = 0;              // Frames between two keyframes.
+    uint64_t offset_ = 0;                         // Size of the file written so far.
+    uint64_t frame_count_ = 0;                    // Number of frames written.
+    bool failed_ = false;                         // Flag indicating whether a write failed (nothing is appended after it).
+    std::vector<uint64_t> keyframe_offsets_;      // File offset of every keyframe.
+    std::vector<RecordedObject> previous_objects_; // Objects of the last written frame, sorted by handle.
+    std::vector<RecordedObject> changed_objects_;  // Scratch list of the objects written in a delta frame.
+    std::vector<int32_t> removed_handles_;         // Scratch list of the objects removed since the last frame.
+    std::vector<unsigned char> buffer_;            // Encoded frame.
+    SceneFrame frame_;                             // Frame being filled.
+
+    /**
+     * @brief Appends data to the file, latching the failed state if it could not be written.
+     * @return True if the data was written.
+     */
+    bool write(const void *data, size_t size);
+
+public:
+    SceneRecorder() = default;
+    SceneRecorder(const SceneRecorder &) = delete;
+    SceneRecorder &operator=(const SceneRecorder &) = delete;
+    ~SceneRecorder();
+
+    /**
+     * @brief Creates a recording (overwrites the file if it exists).
+     * @param path Path of the recording.
+     * @param keyframe_interval Frames between two keyframes (bounds the frames decoded by a seek).
+     * @return True if the file could be created.
+     */
+    bool open(const std::string &path, int keyframe_interval = 120);
+
+    /**
+     * @brief Writes the keyframe index and closes the recording. The index is not written after a failed write,
+     * the player then indexes the frames that were fully written when the recording is opened.
+     */
+    void close();
+
+    /**
+     * @brief Returns true if a recording is open and no write failed.
+     */
+    bool is_open() const;
+
+    /**
+     * @brief Returns true if a write failed (e.g. on a full disk), the recording stopped at the last written frame.
+     * The state is kept until the next open.
+     */
+    bool has_failed() const;
+
+    /**
+     * @brief Starts a frame. Fill the returned frame (objects and primitives) and call end_frame.
+     * @param time Time of the frame, in seconds.
+     */
+    SceneFrame &begin_frame(double time);
+
+    /**
+     * @brief Encodes the frame started with begin_frame and appends it to the recording.
+     */
+    void end_frame();
+
+    /**
+     * @brief Gets the number of frames written.
+     */
+    size_t get_frame_count() const;
+
+    /**
+     * @brief Gets the size of the recording in bytes.
+     */
+    size_t get_size() const;
+};
+
+/**
+ * @brief Reads a scene recording with random access.
+ *
+ * The file is memory-mapped, a seek decodes the nearest keyframe before the frame (found through the
+ * keyframe index) and the delta frames up to it. Consecutive frames are decoded incrementally.
+ * Recordings that were not closed (no index) are indexed on open by walking the frame headers.
+ */
+class ScenePlayer
+{
+private:
+    const unsigned char *data_ = nullptr; // Contents of the recording.
+    size_t size_ = 0;                     // Size of the recording in bytes.
+    std::vector<unsigned char> buffer_;   // File contents when memory mapping is not available.
+    bool mapped_ = false;                 // Flag indicating whether data_ is a memory mapping.
+    uint32_t keyframe_interval_ = 0;      // Frames between two keyframes.
+    size_t frame_count_ = 0;              // Number of frames in the recording.
+    std::vector<uint64_t> keyframe_offsets_; // File offset of every keyframe.
+    SceneFrame frame_;                    // Last decoded frame.
+    size_t current_frame_ = 0;            // Index of the last decoded frame.
+    uint64_t next_offset_ = 0;            // File offset of the frame following the last decoded one.
+    bool has_frame_ = false;              // Flag indicating whether frame_ holds a decoded frame.
+
+    bool read_index();
+    bool rebuild_index();
+    uint64_t decode_frame(uint64_t offset);
+
+public:
+    ScenePlayer() = default;
+    ScenePlayer(const ScenePlayer &) = delete;
+    ScenePlayer &operator=(const ScenePlayer &) = delete;
+    ~ScenePlayer();
+
+    /**
+     * @brief Opens a recording.
+     * @return True if the file is a valid recording.
+     */
+    bool open(const std::string &path);
+
+    /**
+     * @brief Closes the recording.
+     */
+    void close();
+
+    /**
+     * @brief Returns true if a recording is open.
+     */
+    bool is_open() const;
+
+    /**
+     * @brief Gets the number of frames of the recording.
+     */
+    size_t get_frame_count() const;
+
+    /**
+     * @brief Decodes a frame (clamped to the last frame).
+     * @param frame Index of the frame.
+     * @return Scene state of the frame (valid until the next call), null if the recording is empty.
+     */
+    const SceneFrame *seek(size_t frame);
+
+    /**
+     * @brief Gets the index of the last decoded frame.
+     */
+    size_t get_current_frame() const;
+};
@@ -0,0 +1,258 @@
+#include "ShadowMap.hpp"
+#include <cmath>
+#include <string>
+#include "rlgl.h"
+
+namespace
+{
+    constexpr float DEPTH_RANGE_RATIO = 4.0f; // Distance from the region center to the light, relative to the region extent.
+    constexpr float BIAS_TEXELS = 1.5f;       // Depth bias of the lit surfaces facing the light, in texels.
+}
+
+RenderTexture2D ShadowMap::load_target() const
+{
+    RenderTexture2D target = {0};
+#if (RAYLIB_VERSION_MAJOR > 5) || (RAYLIB_VERSION_MAJOR == 5 && RAYLIB_VERSION_MINOR >= 5)
+    target.id = rlLoadFramebuffer();
+#else
+    target.id = rlLoadFramebuffer(this->resolution_, this->resolution_);
+#endif
+    if (target.id == 0)
+    {
+        return target;
+    }
+    rlEnableFramebuffer(target.id);
+    // Only a depth texture (sampled by the lighting shader), there is no color attachment
+    target.depth.id = rlLoadTextureDepth(this->resolution_, this->resolution_, false);
+    target.depth.width = this->resolution_;
+    target.depth.height = this->resolution_;
+    target.depth.mipmaps = 1;
+    rlFramebufferAttach(target.id, target.depth.id, RL_ATTACHMENT_DEPTH, RL_ATTACHMENT_TEXTURE2D, 0);
+    // BeginTextureMode takes the viewport size from the color texture
+    target.texture.width = this->resolution_;
+    target.texture.height = this->resolution_;
+    bool complete = rlFramebufferComplete(target.id);
+    rlDisableFramebuffer();
+    if (!complete)
+    {
+        rlUnloadTexture(target.depth.id);
+        rlUnloadFramebuffer(target.id);
+        return RenderTexture2D{0};
+    }
+    return target;
+}
+
+bool ShadowMap::load(int resolution)
+{
+    this->unload();
+    this->resolution_ = resolution;
+    this->static_target_ = this->load_target();
+    this->dynamic_target_ = this->load_target();
+    if (this->static_target_.id == 0 || this->dynamic_target_.id == 0)
+    {
+        TraceLog(LOG_WARNING, "ROBOVIS: Shadow map framebuffers not available, shadows are disabled");
+        this->unload();
+        return false;
+    }
+
+    // SHADER_BASE_PATH is defined in the CMAKE file
+    std::string vs_path = std::string(SHADER_BASE_PATH) + "/shadow_depth.vs";
+    std::string fs_path = std::string(SHADER_BASE_PATH) + "/shadow_depth.fs";
+    this->depth_shader_ = LoadShader(vs_path.c_str(), fs_path.c_str());
+    if (this->depth_shader_.id == rlGetShaderIdDefault())
+    {
+        // The default shader writes the same depth, it only does some useless color work
+        TraceLog(LOG_WARNING, "ROBOVIS: Shadow depth shader not available, using the default shader");
+    }
+
+    this->loaded_ = true;
+    this->static_dirty_ = true;
+    this->dynamic_empty_ = false;
+    this->update_matrices();
+    return true;
+}
+
+void ShadowMap::unload()
+{
+    for (RenderTexture2D *target : {&this->static_target_, &this->dynamic_target_})
+    {
+        if (target->id != 0)
+        {
+            rlUnloadTexture(target->depth.id);
+            rlUnloadFramebuffer(target->id);
+        }
+        *target = RenderTexture2D{0};
+    }
+    if (this->depth_shader_.id != 0 && this->depth_shader_.id != rlGetShaderIdDefault())
+    {
+        UnloadShader(this->depth_shader_);
+    }
+    this->depth_shader_ = {0};
+    this->locations_.clear();
+    this->loaded_ = false;
+    this->static_renders_ = 0;
+}
+
+bool ShadowMap::is_loaded() const
+{
+    return this->loaded_;
+}
+
+int ShadowMap::get_resolution() const
+{
+    return this->resolution_;
+}
+
+float ShadowMap::get_texel_size() const
+{
+    return 2.0f * this->extent_ / this->resolution_;
+}
+
+void ShadowMap::set_region(Vector3 center, float extent)
+{
+    if (Vector3Equals(center, this->center_) && extent == this->extent_)
+    {
+        return;
+    }
+    this->center_ = center;
+    this->extent_ = extent;
+    this->update_matrices();
+}
+
+void ShadowMap::set_light_direction(Vector3 direction)
+{
+    if (Vector3Length(direction) == 0.0f || Vector3Equals(Vector3Normalize(direction), this->direction_))
+    {
+        return;
+    }
+    this->direction_ = Vector3Normalize(direction);
+    this->update_matrices();
+}
+
+void ShadowMap::update_matrices()
+{
+    float range = DEPTH_RANGE_RATIO * this->extent_;
+    Vector3 eye = Vector3Subtract(this->center_, Vector3Scale(this->direction_, range));
+    // Any up vector works as long as it is not parallel to the light
+    Vector3 up = std::fabs(this->direction_.y) > 0.99f ? Vector3{0.0f, 0.0f, 1.0f} : Vector3{0.0f, 1.0f, 0.0f};
+    this->view_ = MatrixLookAt(eye, this->center_, up);
+    this->projection_ = MatrixOrtho(-this->extent_, this->extent_, -this->extent_, this->extent_, 0.0, 2.0 * range);
+    this->static_dirty_ = true;
+}
+
+void ShadowMap::invalidate_static()
+{
+    this->static_dirty_ = true;
+}
+
+bool ShadowMap::needs_static_update() const
+{
+    return this->loaded_ && this->static_dirty_;
+}
+
+du::Frustum ShadowMap::get_frustum() const
+{
+    return du::get_frustum(MatrixMultiply(this->view_, this->projection_));
+}
+
+const Shader &ShadowMap::get_depth_shader() const
+{
+    return this->depth_shader_;
+}
+
+void ShadowMap::begin_pass(const RenderTexture2D &target)
+{
+    BeginTextureMode(target);
+    ClearBackground(WHITE);
+    rlSetMatrixProjection(this->projection_);
+    rlSetMatrixModelview(this->view_);
+}
+
+void ShadowMap::begin_static()
+{
+    this->begin_pass(this->static_target_);
+    this->static_dirty_ = false;
+    this->static_renders_++;
+}
+
+bool ShadowMap::begin_dynamic(bool has_casters)
+{
+    // An empty map stays valid, it only has to be cleared once after the last dynamic caster left
+    if (!has_casters && this->dynamic_empty_)
+    {
+        return false;
+    }
+    this->begin_pass(this->dynamic_target_);
+    this->dynamic_empty_ = !has_casters;
+    return true;
+}
+
+void ShadowMap::end_pass()
+{
+    EndTextureMode();
+}
+
+void ShadowMap::draw_caster(const Model &model, const Matrix &transform) const
+{
+    for (int i = 0; i < model.meshCount; i++)
+    {
+        Material material = model.materials[model.meshMaterial[i]];
+        material.shader = this->depth_shader_;
+        DrawMesh(model.meshes[i], material, transform);
+    }
+}
+
+void ShadowMap::apply(const Shader &shader, bool enabled)
+{
+    auto found = this->locations_.find(shader.id);
+    if (found == this->locations_.end())
+    {
+        ShaderLocations locations = {
+            GetShaderLocation(shader, "shadowsEnabled"),
+            GetShaderLocation(shader, "lightViewProj"),
+            GetShaderLocation(shader, "shadowStatic"),
+            GetShaderLocation(shader, "shadowDynamic"),
+            GetShaderLocation(shader, "shadowBias"),
+            GetShaderLocation(shader, "shadowTexelSize")};
+        found = this->locations_.insert({shader.id, locations}).first;
+    }
+    const ShaderLocations &locations = found->second;
+
+    int shadows_enabled = enabled && this->loaded_ ? 1 : 0;
+    SetShaderValue(shader, locations.enabled, &shadows_enabled, SHADER_UNIFORM_INT);
+    if (!shadows_enabled)
+    {
+        return;
+    }
+    int static_unit = STATIC_TEXTURE_UNIT;
+    int dynamic_unit = DYNAMIC_TEXTURE_UNIT;
+    // A texel covers 2 * extent / resolution world units and the depth range of the light is 2 * DEPTH_RANGE_RATIO * extent
+    float texel_size = 1.0f / this->resolution_;
+    float bias = BIAS_TEXELS * texel_size / DEPTH_RANGE_RATIO;
+    SetShaderValueMatrix(shader, locations.light_matrix, MatrixMultiply(this->view_, this->projection_));
+    SetShaderValue(shader, locations.static_map, &static_unit, SHADER_UNIFORM_INT);
+    SetShaderValue(shader, locations.dynamic_map, &dynamic_unit, SHADER_UNIFORM_INT);
+    SetShaderValue(shader, locations.bias, &bias, SHADER_UNIFORM_FLOAT);
+    SetShaderValue(shader, locations.texel_size, &texel_size, SHADER_UNIFORM_FLOAT);
+
+    // The units are above the ones used by the materials and the render batch, so the maps stay bound for the whole pass
+    rlActiveTextureSlot(STATIC_TEXTURE_UNIT);
+    rlEnableTexture(this->static_target_.depth.id);
+    rlActiveTextureSlot(DYNAMIC_TEXTURE_UNIT);
+    rlEnableTexture(this->dynamic_target_.depth.id);
+    rlActiveTextureSlot(0);
+}
+
+void ShadowMap::unbind() const
+{
+    rlActiveTextureSlot(STATIC_TEXTURE_UNIT);
+    rlDisableTexture();
+    rlActiveTextureSlot(DYNAMIC_TEXTURE_UNIT);
+    rlDisableTexture();
+    rlActiveTextureSlot(0);
+}
+
+size_t ShadowMap::get_static_renders() const
+{
+    return this->static_renders_;
+}
@@ -0,0 +1,168 @@
+#pragma once
+#include <raylib.h>
+#include <raymath.h>
+#include <cstddef>
+#include <map>
+
+#include "DrawingUtils.hpp"
+
+/**
+ * @brief Shadow map of a directional light, split into a cached map of the static casters and a map of the dynamic casters.
+ *
+ * Both maps cover the same square region seen from the light. The region does not follow the camera, so the static
+ * map stays valid until a static caster moves, the light direction changes or the region changes, and only the
+ * dynamic casters are drawn every frame. The lighting shader takes the nearest depth of the two maps, which
+ * composites them without copying the cached map.
+ */
+class ShadowMap
+{
+public:
+    static constexpr int STATIC_TEXTURE_UNIT = 14;  // Texture unit of the static map while the scene is drawn.
+    static constexpr int DYNAMIC_TEXTURE_UNIT = 15; // Texture unit of the dynamic map while the scene is drawn.
+
+private:
+    /**
+     * @brief Uniform locations of the shadow inputs of a lighting shader.
+     */
+    struct ShaderLocations
+    {
+        int enabled;          // shadowsEnabled
+        int light_matrix;     // lightViewProj
+        int static_map;       // shadowStatic
+        int dynamic_map;      // shadowDynamic
+        int bias;             // shadowBias
+        int texel_size;       // shadowTexelSize
+    };
+
+    RenderTexture2D static_target_ = {0};  // Depth of the static casters (only redrawn when invalidated).
+    RenderTexture2D dynamic_target_ = {0}; // Depth of the dynamic casters (redrawn every frame).
+    Shader depth_shader_ = {0};            // Shader writing only the depth of the casters.
+    int resolution_ = 2048;                // Width and height of the maps in texels.
+    Vector3 center_ = {0.0f, 0.0f, 0.0f};  // Center of the shadowed region.
+    float extent_ = 25.0f;                 // Half size of the shadowed region.
+    Vector3 direction_ = {0.0f, -1.0f, 0.0f}; // Direction of the light rays.
+    Matrix view_ = MatrixIdentity();       // View matrix of the light.
+    Matrix projection_ = MatrixIdentity(); // Orthographic projection of the light.
+    bool loaded_ = false;                  // Flag indicating whether the maps are loaded.
+    bool static_dirty_ = true;             // Flag indicating whether the static map has to be redrawn.
+    bool dynamic_empty_ = true;            // Flag indicating whether the dynamic map holds no caster (cleared).
+    size_t static_renders_ = 0;            // Number of times the static map was drawn.
+    std::map<unsigned int, ShaderLocations> locations_; // Uniform locations by shader id.
+
+    /**
+     * @brief Creates a framebuffer with a depth texture attachment of the map resolution.
+     */
+    RenderTexture2D load_target() const;
+
+    /**
+     * @brief Recomputes the light matrices from the region and the light direction.
+     */
+    void update_matrices();
+
+    /**
+     * @brief Starts drawing the casters into a map (clears it and sets the light matrices).
+     */
+    void begin_pass(const RenderTexture2D &target);
+
+public:
+    /**
+     * @brief Loads the maps and the depth shader.
+     * @param resolution Width and height of the maps in texels.
+     * @return False if the depth framebuffers could not be created.
+     */
+    bool load(int resolution);
+
+    /**
+     * @brief Unloads the maps and the depth shader. Safe to call more than once.
+     */
+    void unload();
+
+    /**
+     * @brief Checks whether the maps are loaded.
+     */
+    bool is_loaded() const;
+
+    /**
+     * @brief Gets the resolution of the maps.
+     */
+    int get_resolution() const;
+
+    /**
+     * @brief Gets the size of a texel of the maps in world units (across the light rays).
+     */
+    float get_texel_size() const;
+
+    /**
+     * @brief Sets the region covered by the maps (invalidates the static map if it changed).
+     * @param center Center of the region.
+     * @param extent Half size of the region, across the light rays.
+     */
+    void set_region(Vector3 center, float extent);
+
+    /**
+     * @brief Sets the direction of the light rays (invalidates the static map if it changed).
+     */
+    void set_light_direction(Vector3 direction);
+
+    /**
+     * @brief Marks the static map to be redrawn (a static caster was added, moved or removed).
+     */
+    void invalidate_static();
+
+    /**
+     * @brief Checks whether the static map has to be redrawn this frame.
+     */
+    bool needs_static_update() const;
+
+    /**
+     * @brief Gets the frustum of the light, used to cull the casters.
+     */
+    du::Frustum get_frustum() const;
+
+    /**
+     * @brief Gets the shader to draw the casters with.
+     */
+    const Shader &get_depth_shader() const;
+
+    /**
+     * @brief Starts drawing the static casters. Must be followed by end_pass.
+     */
+    void begin_static();
+
+    /**
+     * @brief Starts drawing the dynamic casters. Must be followed by end_pass when it returns true.
+     * @param has_casters Flag indicating whether there are dynamic casters in the region.
+     * @return False if the map is already empty and there is nothing to draw.
+     */
+    bool begin_dynamic(bool has_casters);
+
+    /**
+     * @brief Finishes drawing a map.
+     */
+    void end_pass();
+
+    /**
+     * @brief Draws the depth of a model (between begin and end).
+     * @param model Model of the caster.
+     * @param transform Transform from mesh space to world space, which already includes the model transform
+     * (VisualObject::world_transform). The model transform is not applied again.
+     */
+    void draw_caster(const Model &model, const Matrix &transform) const;
+
+    /**
+     * @brief Sets the shadow uniforms of a lighting shader and binds the maps to their texture units.
+     * @param shader Lighting shader.
+     * @param enabled False to draw the scene without shadows.
+     */
+    void apply(const Shader &shader, bool enabled);
+
+    /**
+     * @brief Unbinds the maps from their texture units.
+     */
+    void unbind() const;
+
+    /**
+     * @brief Gets the number of times the static map was drawn since it was loaded.
+     */
+    size_t get_static_renders() const;
+};
@@ -0,0 +1,326 @@
+#include "SharedSceneFeed.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace scene_feed
+{
+    namespace
+    {
+        constexpr float COMPONENT_RANGE = 0.70710678f; // The three smallest components of a unit quaternion are within +-1/sqrt(2)
+        constexpr uint32_t COMPONENT_MAX = 1023;        // 10 bits per component
+
+        SharedFeed *map_feed(int descriptor)
+        {
+            void *data = mmap(nullptr, sizeof(SharedFeed), PROT_READ | PROT_WRITE, MAP_SHARED, descriptor, 0);
+            return data == MAP_FAILED ? nullptr : (SharedFeed *)data;
+        }
+    }
+
+    uint32_t pack_quaternion(const float q[4])
+    {
+        float length = std::sqrt(q[0] * q[0] + q[1] * q[1] + q[2] * q[2] + q[3] * q[3]);
+        float inv_length = length > 0.0f ? 1.0f / length : 0.0f;
+
+        int largest = 0;
+        for (int i = 1; i < 4; i++)
+        {
+            if (std::fabs(q[i]) > std::fabs(q[largest]))
+            {
+                largest = i;
+            }
+        }
+        // q and -q are the same rotation, make the dropped component positive
+        float sign = q[largest] < 0.0f ? -inv_length : inv_length;
+
+        uint32_t packed = (uint32_t)largest << 30;
+        int shift = 20;
+        for (int i = 0; i < 4; i++)
+        {
+            if (i == largest)
+            {
+                continue;
+            }
+            float normalized = std::clamp((q[i] * sign / COMPONENT_RANGE + 1.0f) * 0.5f, 0.0f, 1.0f);
+            packed |= (uint32_t)std::lround(normalized * COMPONENT_MAX) << shift;
+            shift -= 10;
+        }
+        return packed;
+    }
+
+    void unpack_quaternion(uint32_t packed, float q[4])
+    {
+        int largest = packed >> 30;
+        int shift = 20;
+        float sum = 0.0f;
+        for (int i = 0; i < 4; i++)
+        {
+            if (i == largest)
+            {
+                continue;
+            }
+            float normalized = ((packed >> shift) & COMPONENT_MAX) / (float)COMPONENT_MAX;
+            q[i] = (normalized * 2.0f - 1.0f) * COMPONENT_RANGE;
+            sum += q[i] * q[i];
+            shift -= 10;
+        }
+        q[largest] = std::sqrt(std::max(1.0f - sum, 0.0f));
+    }
+
+    FeedProducer::~FeedProducer()
+    {
+        this->close();
+    }
+
+    bool FeedProducer::create(const std::string &name)
+    {
+        this->close();
+
+        // Start from a fresh object, a viewer still mapping an old one keeps its own copy
+        shm_unlink(name.c_str());
+        int descriptor = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+        if (descriptor < 0)
+        {
+            return false;
+        }
+        if (ftruncate(descriptor, sizeof(SharedFeed)) != 0)
+        {
+            ::close(descriptor);
+            shm_unlink(name.c_str());
+            return false;
+        }
+        this->feed_ = map_feed(descriptor);
+        ::close(descriptor);
+        if (this->feed_ == nullptr)
+        {
+            shm_unlink(name.c_str());
+            return false;
+        }
+
+        // The object is zero filled, only the header needs to be set. The magic is written last so a
+        // viewer never sees a partially initialized feed
+        this->name_ = name;
+        this->feed_->version = FEED_VERSION;
+        this->feed_->magic.store(FEED_MAGIC, std::memory_order_release);
+        return true;
+    }
+
+    void FeedProducer::close()
+    {
+        if (this->feed_ == nullptr)
+        {
+            return;
+        }
+        // A viewer keeps its mapping of the removed object, the cleared magic tells it to reopen the feed
+        this->feed_->magic.store(0, std::memory_order_release);
+        munmap(this->feed_, sizeof(SharedFeed));
+        shm_unlink(this->name_.c_str());
+        this->feed_ = nullptr;
+        this->frame_ = nullptr;
+    }
+
+    bool FeedProducer::push_command(const Command &command)
+    {
+        if (this->feed_ == nullptr)
+        {
+            return false;
+        }
+        uint32_t head = this->feed_->command_head.load(std::memory_order_relaxed);
+        uint32_t tail = this->feed_->command_tail.load(std::memory_order_acquire);
+        if (head - tail >= COMMAND_SLOTS)
+        {
+            return false;
+        }
+        this->feed_->commands[head % COMMAND_SLOTS] = command;
+        this->feed_->command_head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool FeedProducer::spawn(uint32_t object_id, ShapeType shape, const float position[3], const float orientation[4],
+                             const float size[3], const uint8_t color[4], int32_t group_id)
+    {
+        Command command;
+        command.type = CommandType::SPAWN;
+        command.object_id = object_id;
+        command.shape = shape;
+        memcpy(command.position, position, sizeof(command.position));
+        memcpy(command.orientation, orientation, sizeof(command.orientation));
+        memcpy(command.size, size, sizeof(command.size));
+        memcpy(command.color, color, sizeof(command.color));
+        command.group_id = group_id;
+        return this->push_command(command);
+    }
+
+    bool FeedProducer::spawn_mesh(uint32_t object_id, const char *path, const float position[3], const float orientation[4],
+                                  const float scale[3], const uint8_t color[4], int32_t group_id)
+    {
+        Command command;
+        command.type = CommandType::SPAWN;
+        command.object_id = object_id;
+        command.shape = ShapeType::MESH;
+        memcpy(command.position, position, sizeof(command.position));
+        memcpy(command.orientation, orientation, sizeof(command.orientation));
+        memcpy(command.size, scale, sizeof(command.size));
+        memcpy(command.color, color, sizeof(command.color));
+        command.group_id = group_id;
+        strncpy(command.mesh_path, path, MAX_PATH_LENGTH - 1);
+        return this->push_command(command);
+    }
+
+    bool FeedProducer::remove(uint32_t object_id)
+    {
+        Command command;
+        command.type = CommandType::REMOVE;
+        command.object_id = object_id;
+        return this->push_command(command);
+    }
+
+    void FeedProducer::begin_frame(double time)
+    {
+        if (this->feed_ == nullptr)
+        {
+            return;
+        }
+        uint64_t published = this->feed_->published_frames.load(std::memory_order_relaxed);
+        this->frame_ = &this->feed_->frames[published % FRAME_SLOTS];
+
+        // Odd sequence: readers copying this slot will discard their copy
+        uint64_t sequence = this->frame_->sequence.load(std::memory_order_relaxed);
+        this->frame_->sequence.store(sequence + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        this->frame_->time = time;
+        this->frame_->count = 0;
+    }
+
+    void FeedProducer::add_pose(uint32_t object_id, const float position[3], const float orientation[4])
+    {
+        if (this->frame_ == nullptr || this->frame_->count >= MAX_OBJECTS)
+        {
+            return;
+        }
+        PackedPose &pose = this->frame_->poses[this->frame_->count++];
+        pose.object_id = object_id;
+        memcpy(pose.position, position, sizeof(pose.position));
+        pose.orientation = pack_quaternion(orientation);
+    }
+
+    void FeedProducer::publish()
+    {
+        if (this->frame_ == nullptr)
+        {
+            return;
+        }
+        uint64_t sequence = this->frame_->sequence.load(std::memory_order_relaxed);
+        this->frame_->sequence.store(sequence + 1, std::memory_order_release);
+        this->feed_->published_frames.fetch_add(1, std::memory_order_release);
+        this->frame_ = nullptr;
+    }
+
+    FeedConsumer::~FeedConsumer()
+    {
+        this->close();
+    }
+
+    bool FeedConsumer::open(const std::string &name)
+    {
+        this->close();
+        int descriptor = shm_open(name.c_str(), O_RDWR, 0600);
+        if (descriptor < 0)
+        {
+            return false;
+        }
+        struct stat file_stat;
+        if (fstat(descriptor, &file_stat) != 0 || (size_t)file_stat.st_size < sizeof(SharedFeed))
+        {
+            ::close(descriptor);
+            return false;
+        }
+        this->feed_ = map_feed(descriptor);
+        ::close(descriptor);
+        if (this->feed_ == nullptr)
+        {
+            return false;
+        }
+        if (this->feed_->magic.load(std::memory_order_acquire) != FEED_MAGIC || this->feed_->version != FEED_VERSION)
+        {
+            this->close();
+            return false;
+        }
+        this->last_frame_ = 0;
+        return true;
+    }
+
+    void FeedConsumer::close()
+    {
+        if (this->feed_ != nullptr)
+        {
+            munmap(this->feed_, sizeof(SharedFeed));
+            this->feed_ = nullptr;
+        }
+    }
+
+    bool FeedConsumer::is_open() const
+    {
+        return this->feed_ != nullptr;
+    }
+
+    bool FeedConsumer::is_closed_by_producer() const
+    {
+        return this->feed_ != nullptr && this->feed_->magic.load(std::memory_order_acquire) != FEED_MAGIC;
+    }
+
+    bool FeedConsumer::pop_command(Command &command)
+    {
+        if (this->feed_ == nullptr)
+        {
+            return false;
+        }
+        uint32_t tail = this->feed_->command_tail.load(std::memory_order_relaxed);
+        uint32_t head = this->feed_->command_head.load(std::memory_order_acquire);
+        if (tail == head)
+        {
+            return false;
+        }
+        command = this->feed_->commands[tail % COMMAND_SLOTS];
+        command.mesh_path[MAX_PATH_LENGTH - 1] = '\0';
+        this->feed_->command_tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool FeedConsumer::read_latest_frame(std::vector<PackedPose> &poses, double &time)
+    {
+        if (this->feed_ == nullptr)
+        {
+            return false;
+        }
+        uint64_t published = this->feed_->published_frames.load(std::memory_order_acquire);
+        if (published == 0 || published == this->last_frame_)
+        {
+            return false;
+        }
+
+        const FrameSlot &slot = this->feed_->frames[(published - 1) % FRAME_SLOTS];
+        uint64_t sequence = slot.sequence.load(std::memory_order_acquire);
+        if (sequence & 1)
+        {
+            return false;
+        }
+        uint32_t count = std::min(slot.count, MAX_OBJECTS);
+        poses.resize(count);
+        memcpy(poses.data(), slot.poses, count * sizeof(PackedPose));
+        time = slot.time;
+
+        // The producer lapped the ring while the slot was copied
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.sequence.load(std::memory_order_relaxed) != sequence)
+        {
+            return false;
+        }
+        this->last_frame_ = published;
+        return true;
+    }
+}
@@ -0,0 +1,237 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Shared-memory transport letting an external process (e.g. a simulator) drive a viewer.
+ *
+ * The producer creates a POSIX shared memory object holding a ring of pose frames and a command queue,
+ * the viewer maps it and applies the commands and the latest frame on every update. Neither side ever
+ * waits for the other: frames are published through per-slot sequence counters (a frame overwritten while
+ * it is read is detected and skipped), and the command queue is a single-producer single-consumer ring.
+ *
+ * This header does not depend on raylib, so producers only need to compile SharedSceneFeed.cpp.
+ */
+namespace scene_feed
+{
+    constexpr uint32_t FEED_MAGIC = 0x46535652; // "RVSF"
+    constexpr uint32_t FEED_VERSION = 1;
+    constexpr uint32_t MAX_OBJECTS = 4096;      // Poses per frame.
+    constexpr uint32_t FRAME_SLOTS = 4;         // Frames in the ring (the reader copies the latest one).
+    constexpr uint32_t COMMAND_SLOTS = 256;     // Commands waiting for the viewer before push_command fails.
+    constexpr size_t MAX_PATH_LENGTH = 256;     // Maximum length of a mesh path, including the terminating null.
+
+    /**
+     * @brief Shapes that can be spawned through the command channel.
+     */
+    enum class ShapeType : uint32_t
+    {
+        BOX,      // size = width, height, length
+        SPHERE,   // size[0] = radius
+        CYLINDER, // size[0] = radius, size[1] = height
+        CAPSULE,  // size[0] = radius, size[1] = height
+        CONE,     // size[0] = radius, size[1] = height
+        PLANE,    // size[0] = width, size[1] = length
+        MESH      // mesh_path, size = scale along each axis
+    };
+
+    /**
+     * @brief Kinds of commands of the control channel.
+     */
+    enum class CommandType : uint32_t
+    {
+        SPAWN,  // Creates the object object_id.
+        REMOVE, // Removes the object object_id.
+        CLEAR   // Removes every object.
+    };
+
+    /**
+     * @brief Command sent from the producer to the viewer.
+     */
+    struct Command
+    {
+        CommandType type = CommandType::SPAWN;
+        uint32_t object_id = 0;                  // Id chosen by the producer for the object.
+        ShapeType shape = ShapeType::BOX;        // Shape of the spawned object.
+        float position[3] = {0.0f, 0.0f, 0.0f};  // Initial position.
+        float orientation[4] = {0.0f, 0.0f, 0.0f, 1.0f}; // Initial orientation (x, y, z, w).
+        float size[3] = {1.0f, 1.0f, 1.0f};      // Dimensions, see ShapeType.
+        uint8_t color[4] = {255, 255, 255, 255}; // Color (r, g, b, a).
+        int32_t group_id = 0;                    // Group of the object in the viewer.
+        char mesh_path[MAX_PATH_LENGTH] = {0};   // Mesh file for ShapeType::MESH.
+    };
+
+    /**
+     * @brief Pose of an object in a frame (20 bytes, the orientation is quantized with pack_quaternion).
+     */
+    struct PackedPose
+    {
+        uint32_t object_id; // Id of the object.
+        float position[3];  // Position.
+        uint32_t orientation; // Quantized orientation.
+    };
+
+    /**
+     * @brief Frame of the ring. sequence is odd while the producer writes the slot.
+     */
+    struct FrameSlot
+    {
+        std::atomic<uint64_t> sequence;
+        double time;
+        uint32_t count;
+        PackedPose poses[MAX_OBJECTS];
+    };
+
+    /**
+     * @brief Layout of the shared memory object.
+     */
+    struct SharedFeed
+    {
+        std::atomic<uint32_t> magic;              // FEED_MAGIC once the producer finished initializing the feed, 0 after it closed it.
+        uint32_t version;                         // FEED_VERSION.
+        std::atomic<uint64_t> published_frames;   // Frames published so far (the latest is in slot (published_frames - 1) % FRAME_SLOTS).
+        FrameSlot frames[FRAME_SLOTS];
+        alignas(64) std::atomic<uint32_t> command_head; // Commands pushed (written by the producer).
+        alignas(64) std::atomic<uint32_t> command_tail; // Commands popped (written by the viewer).
+        Command commands[COMMAND_SLOTS];
+    };
+
+    static_assert(std::atomic<uint64_t>::is_always_lock_free, "The feed needs lock-free 64-bit atomics");
+
+    /**
+     * @brief Quantizes a unit quaternion to 32 bits ("smallest three": index of the largest component
+     * in 2 bits and the three others in 10 bits each, maximum error around 1e-3).
+     * @param q Quaternion (x, y, z, w).
+     */
+    uint32_t pack_quaternion(const float q[4]);
+
+    /**
+     * @brief Restores a quaternion quantized with pack_quaternion.
+     * @param packed Quantized quaternion.
+     * @param q Output quaternion (x, y, z, w).
+     */
+    void unpack_quaternion(uint32_t packed, float q[4]);
+
+    /**
+     * @brief Writing side of the feed, used by the simulator process.
+     */
+    class FeedProducer
+    {
+    private:
+        SharedFeed *feed_ = nullptr; // Mapped feed.
+        std::string name_;           // Name of the shared memory object.
+        FrameSlot *frame_ = nullptr; // Slot being written (between begin_frame and publish).
+
+    public:
+        FeedProducer() = default;
+        FeedProducer(const FeedProducer &) = delete;
+        FeedProducer &operator=(const FeedProducer &) = delete;
+        ~FeedProducer();
+
+        /**
+         * @brief Creates the shared memory object (replaces an existing one with the same name).
+         * @param name Name of the feed (e.g. "/robovis").
+         * @return True if the feed was created.
+         */
+        bool create(const std::string &name);
+
+        /**
+         * @brief Marks the feed closed, then unmaps and removes the shared memory object.
+         */
+        void close();
+
+        /**
+         * @brief Queues a command for the viewer.
+         * @return False if the viewer has not consumed the previous COMMAND_SLOTS commands (the command is not sent).
+         */
+        bool push_command(const Command &command);
+
+        /**
+         * @brief Queues the creation of a primitive (see ShapeType for the meaning of size).
+         */
+        bool spawn(uint32_t object_id, ShapeType shape, const float position[3], const float orientation[4],
+                   const float size[3], const uint8_t color[4], int32_t group_id = 0);
+
+        /**
+         * @brief Queues the creation of an object from a mesh file.
+         */
+        bool spawn_mesh(uint32_t object_id, const char *path, const float position[3], const float orientation[4],
+                        const float scale[3], const uint8_t color[4], int32_t group_id = 0);
+
+        /**
+         * @brief Queues the removal of an object.
+         */
+        bool remove(uint32_t object_id);
+
+        /**
+         * @brief Starts a pose frame.
+         * @param time Simulation time of the frame.
+         */
+        void begin_frame(double time);
+
+        /**
+         * @brief Adds a pose to the frame started with begin_frame (ignored past MAX_OBJECTS poses).
+         */
+        void add_pose(uint32_t object_id, const float position[3], const float orientation[4]);
+
+        /**
+         * @brief Publishes the frame, making it the latest frame seen by the viewer.
+         */
+        void publish();
+    };
+
+    /**
+     * @brief Reading side of the feed, used by the viewer.
+     */
+    class FeedConsumer
+    {
+    private:
+        SharedFeed *feed_ = nullptr; // Mapped feed.
+        uint64_t last_frame_ = 0;    // Number of published frames when the last frame was read.
+
+    public:
+        FeedConsumer() = default;
+        FeedConsumer(const FeedConsumer &) = delete;
+        FeedConsumer &operator=(const FeedConsumer &) = delete;
+        ~FeedConsumer();
+
+        /**
+         * @brief Maps the feed created by a producer.
+         * @return True if the feed exists and has the expected version.
+         */
+        bool open(const std::string &name);
+
+        /**
+         * @brief Unmaps the feed.
+         */
+        void close();
+
+        /**
+         * @brief Returns true if a feed is mapped.
+         */
+        bool is_open() const;
+
+        /**
+         * @brief Returns true if the producer closed the mapped feed (e.g. to restart). The viewer keeps
+         * the old mapping until it calls close, then open maps the feed created by the new producer.
+         */
+        bool is_closed_by_producer() const;
+
+        /**
+         * @brief Pops the oldest pending command.
+         * @return False if there are no pending commands.
+         */
+        bool pop_command(Command &command);
+
+        /**
+         * @brief Copies the latest published frame if it is newer than the last one read.
+         * @param poses Output poses (resized to the frame size).
+         * @param time Output simulation time of the frame.
+         * @return False if there is no new frame, or if it was overwritten while being copied (try again next update).
+         */
+        bool read_latest_frame(std::vector<PackedPose> &poses, double &time);
+    };
+}
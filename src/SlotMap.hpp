@@ -0,0 +1,190 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief Container that hands out stable generational handles with O(1) insertion, removal and lookup.
+ *
+ * Values are stored densely (removal moves the last value into the hole), so iterating over them is a
+ * linear walk over a vector. A handle packs a slot index and the generation of the slot: when a value is
+ * removed the generation of its slot is increased, so old handles to that slot stop resolving instead of
+ * silently pointing at a newer value. Handles are non negative ints, and -1 is never a valid handle.
+ * The generation has 11 bits and wraps after a slot is reused 2048 times, so a handle held across that
+ * many removals of the same slot can resolve to a newer value again.
+ */
+template <typename T>
+class SlotMap
+{
+public:
+    static constexpr int INVALID_HANDLE = -1;        // Handle that never resolves to a value.
+    static constexpr int INDEX_BITS = 20;            // Bits of the handle used for the slot index (up to ~1M live values).
+    static constexpr uint32_t INDEX_MASK = (1u << INDEX_BITS) - 1;
+    static constexpr uint32_t GENERATION_MASK = 0x7FF; // Remaining bits (but the sign bit) hold the generation.
+
+private:
+    static constexpr uint32_t FREE_SLOT = UINT32_MAX; // Dense index of a slot that holds no value.
+
+    /**
+     * @brief Indirection entry between a handle and the dense storage.
+     */
+    struct Slot
+    {
+        uint32_t dense_index = FREE_SLOT; // Position of the value in the dense storage.
+        uint32_t generation = 0;          // Generation of the slot, increased every time its value is removed.
+    };
+
+    std::vector<Slot> slots_;              // Slots referenced by the handles.
+    std::vector<uint32_t> free_slots_;     // Slots that can be reused.
+    std::vector<T> values_;                // Dense storage of the values.
+    std::vector<uint32_t> dense_to_slot_;  // Slot of each value in the dense storage.
+
+    static int make_handle(uint32_t slot, uint32_t generation)
+    {
+        return (int)(((generation & GENERATION_MASK) << INDEX_BITS) | slot);
+    }
+
+    const Slot *find_slot(int handle) const
+    {
+        if (handle < 0)
+        {
+            return nullptr;
+        }
+        uint32_t slot_index = (uint32_t)handle & INDEX_MASK;
+        uint32_t generation = (uint32_t)handle >> INDEX_BITS;
+        if (slot_index >= this->slots_.size())
+        {
+            return nullptr;
+        }
+        const Slot &slot = this->slots_[slot_index];
+        if (slot.dense_index == FREE_SLOT || (slot.generation & GENERATION_MASK) != generation)
+        {
+            return nullptr;
+        }
+        return &slot;
+    }
+
+public:
+    /**
+     * @brief Inserts a value.
+     * @return Handle of the value, or INVALID_HANDLE (without taking the value) if every slot index is in use.
+     */
+    int insert(T value)
+    {
+        uint32_t slot_index;
+        if (!this->free_slots_.empty())
+        {
+            slot_index = this->free_slots_.back();
+            this->free_slots_.pop_back();
+        }
+        else
+        {
+            slot_index = this->slots_.size();
+            if (slot_index > INDEX_MASK)
+            {
+                return INVALID_HANDLE;
+            }
+            this->slots_.push_back(Slot());
+        }
+
+        Slot &slot = this->slots_[slot_index];
+        slot.dense_index = this->values_.size();
+        this->values_.push_back(std::move(value));
+        this->dense_to_slot_.push_back(slot_index);
+
+        return make_handle(slot_index, slot.generation);
+    }
+
+    /**
+     * @brief Removes the value referenced by a handle.
+     * @return True if the handle was valid.
+     */
+    bool erase(int handle)
+    {
+        const Slot *found = this->find_slot(handle);
+        if (found == nullptr)
+        {
+            return false;
+        }
+        uint32_t slot_index = (uint32_t)handle & INDEX_MASK;
+        uint32_t dense_index = found->dense_index;
+        uint32_t last_index = this->values_.size() - 1;
+
+        // Move the last value into the hole to keep the storage dense
+        if (dense_index != last_index)
+        {
+            this->values_[dense_index] = std::move(this->values_[last_index]);
+            this->dense_to_slot_[dense_index] = this->dense_to_slot_[last_index];
+            this->slots_[this->dense_to_slot_[dense_index]].dense_index = dense_index;
+        }
+        this->values_.pop_back();
+        this->dense_to_slot_.pop_back();
+
+        Slot &slot = this->slots_[slot_index];
+        slot.dense_index = FREE_SLOT;
+        slot.generation++;
+        this->free_slots_.push_back(slot_index);
+        return true;
+    }
+
+    /**
+     * @brief Gets the value referenced by a handle.
+     * @return Pointer to the value, or nullptr if the handle is not valid (anymore).
+     */
+    T *get(int handle)
+    {
+        const Slot *slot = this->find_slot(handle);
+        return slot != nullptr ? &this->values_[slot->dense_index] : nullptr;
+    }
+
+    const T *get(int handle) const
+    {
+        const Slot *slot = this->find_slot(handle);
+        return slot != nullptr ? &this->values_[slot->dense_index] : nullptr;
+    }
+
+    /**
+     * @brief Returns true if the handle references a value.
+     */
+    bool contains(int handle) const
+    {
+        return this->find_slot(handle) != nullptr;
+    }
+
+    /**
+     * @brief Gets the handle of the value stored at a position of the dense storage.
+     */
+    int handle_at(size_t dense_index) const
+    {
+        uint32_t slot_index = this->dense_to_slot_[dense_index];
+        return make_handle(slot_index, this->slots_[slot_index].generation);
+    }
+
+    /**
+     * @brief Removes all the values. Handles given before the call stop resolving.
+     */
+    void clear()
+    {
+        for (uint32_t slot_index : this->dense_to_slot_)
+        {
+            Slot &slot = this->slots_[slot_index];
+            slot.dense_index = FREE_SLOT;
+            slot.generation++;
+            this->free_slots_.push_back(slot_index);
+        }
+        this->values_.clear();
+        this->dense_to_slot_.clear();
+    }
+
+    size_t size() const { return this->values_.size(); }
+    bool empty() const { return this->values_.empty(); }
+
+    // Iteration over the dense storage (the order changes when values are removed)
+    T &value_at(size_t dense_index) { return this->values_[dense_index]; }
+    const T &value_at(size_t dense_index) const { return this->values_[dense_index]; }
+    typename std::vector<T>::iterator begin() { return this->values_.begin(); }
+    typename std::vector<T>::iterator end() { return this->values_.end(); }
+    typename std::vector<T>::const_iterator begin() const { return this->values_.begin(); }
+    typename std::vector<T>::const_iterator end() const { return this->values_.end(); }
+};
@@ -0,0 +1,382 @@
+#include "Terrain.hpp"
+#include <algorithm>
+#include <cstring>
+#include "rlgl.h"
+
+namespace
+{
+    /**
+     * @brief Gets the vertex offsets kept by a level of detail along a side of cells (the last one is always kept).
+     */
+    void get_lod_samples(size_t cells, size_t step, std::vector<size_t> &samples)
+    {
+        samples.clear();
+        for (size_t i = 0; i < cells; i += step)
+        {
+            samples.push_back(i);
+        }
+        samples.push_back(cells);
+    }
+}
+
+Terrain::Terrain(size_t width, size_t depth, const float *heights, float cell_size_x, float cell_size_z, float height_scale, size_t tile_cells)
+    : width_(std::max(width, (size_t)2)),
+      depth_(std::max(depth, (size_t)2)),
+      cell_size_x_(cell_size_x),
+      cell_size_z_(cell_size_z),
+      height_scale_(height_scale),
+      tile_cells_(std::clamp(tile_cells, (size_t)2, (size_t)250)) // Level 0 of a tile must fit 16 bit indices
+{
+    this->heights_.assign(this->width_ * this->depth_, 0.0f);
+    if (heights != nullptr && width >= 2 && depth >= 2)
+    {
+        std::copy(heights, heights + width * depth, this->heights_.begin());
+    }
+
+    this->lod_levels_ = 1;
+    while (this->lod_levels_ < MAX_LOD_LEVELS && ((size_t)1 << this->lod_levels_) < this->tile_cells_)
+    {
+        this->lod_levels_++;
+    }
+
+    size_t cells_x = this->width_ - 1;
+    size_t cells_z = this->depth_ - 1;
+    this->tiles_x_ = (cells_x + this->tile_cells_ - 1) / this->tile_cells_;
+    size_t tiles_z = (cells_z + this->tile_cells_ - 1) / this->tile_cells_;
+    this->tiles_.resize(this->tiles_x_ * tiles_z);
+    for (size_t j = 0; j < tiles_z; j++)
+    {
+        for (size_t i = 0; i < this->tiles_x_; i++)
+        {
+            Tile &tile = this->tiles_[j * this->tiles_x_ + i];
+            tile.x = i * this->tile_cells_;
+            tile.z = j * this->tile_cells_;
+            tile.cells_x = std::min(this->tile_cells_, cells_x - tile.x);
+            tile.cells_z = std::min(this->tile_cells_, cells_z - tile.z);
+            tile.stale_levels = (1u << this->lod_levels_) - 1;
+        }
+    }
+}
+
+float Terrain::get_height_at(size_t x, size_t z) const
+{
+    return this->heights_[z * this->width_ + x];
+}
+
+float Terrain::get_height(size_t x, size_t z) const
+{
+    if (x >= this->width_ || z >= this->depth_)
+    {
+        return 0.0f;
+    }
+    return this->get_height_at(x, z);
+}
+
+void Terrain::get_vertex(size_t x, size_t z, Vector3 &position, Vector3 &normal) const
+{
+    // The terrain is centered on its origin
+    position = {x * this->cell_size_x_ - 0.5f * (this->width_ - 1) * this->cell_size_x_,
+                this->get_height_at(x, z) * this->height_scale_,
+                z * this->cell_size_z_ - 0.5f * (this->depth_ - 1) * this->cell_size_z_};
+
+    // Central differences (one sided on the borders)
+    size_t x_0 = x > 0 ? x - 1 : x;
+    size_t x_1 = x + 1 < this->width_ ? x + 1 : x;
+    size_t z_0 = z > 0 ? z - 1 : z;
+    size_t z_1 = z + 1 < this->depth_ ? z + 1 : z;
+    float slope_x = (this->get_height_at(x_1, z) - this->get_height_at(x_0, z)) * this->height_scale_ / ((x_1 - x_0) * this->cell_size_x_);
+    float slope_z = (this->get_height_at(x, z_1) - this->get_height_at(x, z_0)) * this->height_scale_ / ((z_1 - z_0) * this->cell_size_z_);
+    normal = Vector3Normalize({-slope_x, 1.0f, -slope_z});
+}
+
+void Terrain::update_tile_bounds(Tile &tile)
+{
+    float min_height = this->get_height_at(tile.x, tile.z);
+    float max_height = min_height;
+    for (size_t z = tile.z; z <= tile.z + tile.cells_z; z++)
+    {
+        const float *row = &this->heights_[z * this->width_];
+        auto [row_min, row_max] = std::minmax_element(row + tile.x, row + tile.x + tile.cells_x + 1);
+        min_height = std::min(min_height, *row_min);
+        max_height = std::max(max_height, *row_max);
+    }
+    Vector3 normal;
+    get_vertex(tile.x, tile.z, tile.bounds.min, normal);
+    get_vertex(tile.x + tile.cells_x, tile.z + tile.cells_z, tile.bounds.max, normal);
+    tile.bounds.min.y = std::min(min_height * this->height_scale_, max_height * this->height_scale_);
+    tile.bounds.max.y = std::max(min_height * this->height_scale_, max_height * this->height_scale_);
+    tile.bounds_dirty = false;
+}
+
+void Terrain::build_tile_mesh(Tile &tile, int level)
+{
+    std::vector<size_t> columns;
+    std::vector<size_t> rows;
+    get_lod_samples(tile.cells_x, (size_t)1 << level, columns);
+    get_lod_samples(tile.cells_z, (size_t)1 << level, rows);
+    size_t n_x = columns.size();
+    size_t n_z = rows.size();
+    size_t grid_vertices = n_x * n_z;
+    // Skirts: a copy of the border vertices, lowered below the lowest point of the tile
+    int vertex_count = grid_vertices + 2 * (n_x + n_z);
+
+    if (tile.bounds_dirty)
+    {
+        this->update_tile_bounds(tile);
+    }
+    float skirt_bottom = tile.bounds.min.y - std::max(tile.bounds.max.y - tile.bounds.min.y, std::max(this->cell_size_x_, this->cell_size_z_));
+
+    Mesh &mesh = tile.meshes[level];
+    bool created = mesh.vertexCount == 0;
+    if (created)
+    {
+        mesh.vertexCount = vertex_count;
+        mesh.triangleCount = 2 * (n_x - 1) * (n_z - 1) + 8 * ((n_x - 1) + (n_z - 1));
+        mesh.vertices = (float *)MemAlloc(vertex_count * 3 * sizeof(float));
+        mesh.normals = (float *)MemAlloc(vertex_count * 3 * sizeof(float));
+        mesh.texcoords = (float *)MemAlloc(vertex_count * 2 * sizeof(float));
+        mesh.indices = (unsigned short *)MemAlloc(mesh.triangleCount * 3 * sizeof(unsigned short));
+    }
+
+    // Grid vertices
+    Vector3 *positions = (Vector3 *)mesh.vertices;
+    Vector3 *normals = (Vector3 *)mesh.normals;
+    for (size_t j = 0; j < n_z; j++)
+    {
+        for (size_t i = 0; i < n_x; i++)
+        {
+            size_t x = tile.x + columns[i];
+            size_t z = tile.z + rows[j];
+            this->get_vertex(x, z, positions[j * n_x + i], normals[j * n_x + i]);
+            if (created)
+            {
+                mesh.texcoords[2 * (j * n_x + i)] = (float)x / (this->width_ - 1);
+                mesh.texcoords[2 * (j * n_x + i) + 1] = (float)z / (this->depth_ - 1);
+            }
+        }
+    }
+
+    // Skirt vertices, in the order of the borders: first row, last row, first column, last column
+    size_t borders[4][2] = {{0, n_x}, {(n_z - 1) * n_x, n_x}, {0, n_z}, {n_x - 1, n_z}};
+    size_t strides[4] = {1, 1, n_x, n_x};
+    size_t skirt = grid_vertices;
+    for (int b = 0; b < 4; b++)
+    {
+        for (size_t k = 0; k < borders[b][1]; k++)
+        {
+            size_t source = borders[b][0] + k * strides[b];
+            positions[skirt] = {positions[source].x, skirt_bottom, positions[source].z};
+            normals[skirt] = normals[source];
+            if (created)
+            {
+                mesh.texcoords[2 * skirt] = mesh.texcoords[2 * source];
+                mesh.texcoords[2 * skirt + 1] = mesh.texcoords[2 * source + 1];
+            }
+            skirt++;
+        }
+    }
+
+    if (created)
+    {
+        // The topology only depends on the tile size and the level, it is written once
+        unsigned short *index = mesh.indices;
+        for (size_t j = 0; j + 1 < n_z; j++)
+        {
+            for (size_t i = 0; i + 1 < n_x; i++)
+            {
+                unsigned short a = j * n_x + i;
+                unsigned short b = a + 1;
+                unsigned short c = a + n_x;
+                unsigned short d = c + 1;
+                *index++ = a, *index++ = c, *index++ = b;
+                *index++ = b, *index++ = c, *index++ = d;
+            }
+        }
+        // Skirt quads are written with both windings, so they are visible from either side
+        skirt = grid_vertices;
+        for (int b = 0; b < 4; b++)
+        {
+            for (size_t k = 0; k + 1 < borders[b][1]; k++)
+            {
+                unsigned short a = borders[b][0] + k * strides[b];
+                unsigned short c = a + strides[b];
+                unsigned short b_low = skirt + k;
+                unsigned short d_low = b_low + 1;
+                *index++ = a, *index++ = b_low, *index++ = c;
+                *index++ = c, *index++ = b_low, *index++ = d_low;
+                *index++ = a, *index++ = c, *index++ = b_low;
+                *index++ = c, *index++ = d_low, *index++ = b_low;
+            }
+            skirt += borders[b][1];
+        }
+        UploadMesh(&mesh, true);
+    }
+    else
+    {
+        // Only the positions and normals of this tile are uploaded again
+        UpdateMeshBuffer(mesh, 0, mesh.vertices, vertex_count * 3 * sizeof(float), 0);
+        UpdateMeshBuffer(mesh, 2, mesh.normals, vertex_count * 3 * sizeof(float), 0);
+    }
+    tile.stale_levels &= ~(1u << level);
+}
+
+void Terrain::set_heights(size_t x, size_t z, size_t width, size_t depth, const float *heights)
+{
+    if (x >= this->width_ || z >= this->depth_ || width == 0 || depth == 0)
+    {
+        return;
+    }
+    size_t copy_width = std::min(width, this->width_ - x);
+    size_t copy_depth = std::min(depth, this->depth_ - z);
+    for (size_t j = 0; j < copy_depth; j++)
+    {
+        std::memcpy(&this->heights_[(z + j) * this->width_ + x], heights + j * width, copy_width * sizeof(float));
+    }
+
+    // The normals of the vertices around the rectangle change too
+    size_t x_0 = x > 0 ? x - 1 : 0;
+    size_t z_0 = z > 0 ? z - 1 : 0;
+    size_t x_1 = std::min(x + copy_width, this->width_ - 1);
+    size_t z_1 = std::min(z + copy_depth, this->depth_ - 1);
+
+    // A vertex on the border between two tiles belongs to both
+    size_t tiles_z = this->tiles_.size() / this->tiles_x_;
+    size_t tile_x_0 = x_0 > 0 ? (x_0 - 1) / this->tile_cells_ : 0;
+    size_t tile_z_0 = z_0 > 0 ? (z_0 - 1) / this->tile_cells_ : 0;
+    size_t tile_x_1 = std::min(x_1 / this->tile_cells_, this->tiles_x_ - 1);
+    size_t tile_z_1 = std::min(z_1 / this->tile_cells_, tiles_z - 1);
+    for (size_t j = tile_z_0; j <= tile_z_1; j++)
+    {
+        for (size_t i = tile_x_0; i <= tile_x_1; i++)
+        {
+            Tile &tile = this->tiles_[j * this->tiles_x_ + i];
+            tile.stale_levels = (1u << this->lod_levels_) - 1;
+            tile.bounds_dirty = true;
+        }
+    }
+}
+
+void Terrain::set_pose(Vector3 position, Quaternion orientation)
+{
+    this->transform_ = du::get_transform(position, orientation);
+}
+
+void Terrain::set_color(Color color)
+{
+    this->color_ = color;
+}
+
+void Terrain::set_lod_distance(float distance)
+{
+    this->lod_distance_ = std::max(distance, 0.0f);
+}
+
+void Terrain::draw(const Shader &shader, const du::Frustum &frustum, Vector3 camera_position)
+{
+    this->draw_tiles(shader, frustum, camera_position, -1);
+}
+
+void Terrain::draw_level(const Shader &shader, const du::Frustum &frustum, int level)
+{
+    this->draw_tiles(shader, frustum, Vector3{0.0f, 0.0f, 0.0f}, std::clamp(level, 0, this->lod_levels_ - 1));
+}
+
+int Terrain::get_level_for_spacing(float spacing) const
+{
+    float cell_size = std::min(this->cell_size_x_, this->cell_size_z_);
+    int level = 0;
+    while (level + 1 < this->lod_levels_ && cell_size * (float)(2 << level) <= spacing)
+    {
+        level++;
+    }
+    return level;
+}
+
+void Terrain::draw_tiles(const Shader &shader, const du::Frustum &frustum, Vector3 camera_position, int fixed_level)
+{
+    if (!this->material_loaded_)
+    {
+        this->material_ = LoadMaterialDefault();
+        this->material_loaded_ = true;
+    }
+    this->material_.shader = shader;
+    this->material_.maps[MATERIAL_MAP_DIFFUSE].color = this->color_;
+
+    int builds = 0;
+    this->drawn_tiles_ = 0;
+    this->deferred_builds_ = 0;
+    for (Tile &tile : this->tiles_)
+    {
+        if (tile.bounds_dirty)
+        {
+            this->update_tile_bounds(tile);
+        }
+        BoundingBox world_bounds = du::transform_bounding_box(tile.bounds, this->transform_);
+        if (du::test_frustum_box(frustum, world_bounds) == du::FrustumTest::OUTSIDE)
+        {
+            continue;
+        }
+
+        // One level less every time the distance doubles past the full detail distance
+        int level = fixed_level;
+        if (level < 0)
+        {
+            Vector3 center = Vector3Scale(Vector3Add(world_bounds.min, world_bounds.max), 0.5f);
+            float distance = Vector3Distance(camera_position, center);
+            level = 0;
+            while (level + 1 < this->lod_levels_ && distance > this->lod_distance_ * (float)(1 << level))
+            {
+                level++;
+            }
+        }
+
+        bool never_built = tile.meshes[level].vertexCount == 0;
+        if ((tile.stale_levels & (1u << level)) && (never_built || fixed_level >= 0 || builds < MAX_TILE_BUILDS_PER_FRAME))
+        {
+            // Levels that were never built have to be, the others can show the previous heights for a frame
+            // (except in a fixed level draw, which is cached by the caller)
+            this->build_tile_mesh(tile, level);
+            builds++;
+        }
+        else if (tile.stale_levels & (1u << level))
+        {
+            this->deferred_builds_++;
+        }
+        DrawMesh(tile.meshes[level], this->material_, this->transform_);
+        this->drawn_tiles_++;
+    }
+}
+
+size_t Terrain::get_drawn_tiles() const
+{
+    return this->drawn_tiles_;
+}
+
+size_t Terrain::get_deferred_builds() const
+{
+    return this->deferred_builds_;
+}
+
+void Terrain::unload()
+{
+    for (Tile &tile : this->tiles_)
+    {
+        for (Mesh &mesh : tile.meshes)
+        {
+            if (mesh.vertexCount != 0)
+            {
+                UnloadMesh(mesh);
+            }
+            mesh = Mesh{};
+        }
+        tile.stale_levels = (1u << this->lod_levels_) - 1;
+    }
+    if (this->material_loaded_)
+    {
+        // The shader belongs to the visualizer
+        this->material_.shader = {rlGetShaderIdDefault(), rlGetShaderLocsDefault()};
+        UnloadMaterial(this->material_);
+        this->material_ = {0};
+        this->material_loaded_ = false;
+    }
+}
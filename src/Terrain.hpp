@@ -0,0 +1,166 @@
+#pragma once
+#include <raylib.h>
+#include <raymath.h>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "DrawingUtils.hpp"
+
+/**
+ * @brief Heightmap terrain split into square tiles, each with its own meshes.
+ *
+ * Changing a rectangle of heights only rebuilds the tiles it touches, and the tile meshes are rebuilt
+ * lazily, the first time they are drawn after the change. Every tile picks a level of detail from its
+ * distance to the camera (level l keeps one vertex every 2^l cells), and has skirts hanging from its
+ * borders to hide the cracks between neighbours drawn with different levels. Tiles outside the camera
+ * frustum are skipped.
+ */
+class Terrain
+{
+public:
+    static constexpr int MAX_LOD_LEVELS = 6;             // Levels of detail (steps of 1 to 32 cells).
+    static constexpr int MAX_TILE_BUILDS_PER_FRAME = 64; // Tile meshes rebuilt per draw, the others show their previous mesh until a later draw.
+
+private:
+    /**
+     * @brief Square block of cells with one mesh per level of detail.
+     */
+    struct Tile
+    {
+        size_t x = 0;                        // First column of vertices of the tile.
+        size_t z = 0;                        // First row of vertices of the tile.
+        size_t cells_x = 0;                  // Number of cells along x.
+        size_t cells_z = 0;                  // Number of cells along z.
+        Mesh meshes[MAX_LOD_LEVELS] = {};    // Meshes of the levels of detail (built on first use).
+        uint32_t stale_levels = 0;           // Bit l is set when the mesh of level l does not match the heights.
+        bool bounds_dirty = true;            // Flag indicating whether the bounds must be recomputed.
+        BoundingBox bounds = {};             // Bounds of the tile in the frame of the terrain.
+    };
+
+    size_t width_ = 0;                 // Number of vertices along x.
+    size_t depth_ = 0;                 // Number of vertices along z.
+    std::vector<float> heights_;       // Heights, row major (one row of width_ heights per z).
+    float cell_size_x_ = 1.0f;         // Distance between the vertices along x.
+    float cell_size_z_ = 1.0f;         // Distance between the vertices along z.
+    float height_scale_ = 1.0f;        // Factor applied to the heights.
+    size_t tile_cells_ = 64;           // Cells along each side of a tile.
+    size_t tiles_x_ = 0;               // Number of tiles along x.
+    std::vector<Tile> tiles_;          // Tiles, row major.
+    int lod_levels_ = 1;               // Levels of detail used (limited by the tile size).
+    float lod_distance_ = 50.0f;       // Distance up to which the tiles are drawn with full detail.
+    Matrix transform_ = MatrixIdentity(); // Pose of the terrain.
+    Color color_ = WHITE;              // Color of the terrain.
+    Material material_ = {0};          // Material used to draw the tiles (the shader is set on every draw).
+    bool material_loaded_ = false;     // Flag indicating whether the material is loaded.
+    size_t drawn_tiles_ = 0;           // Tiles drawn by the last draw.
+    size_t deferred_builds_ = 0;       // Stale tiles drawn with their previous mesh by the last draw.
+
+    float get_height_at(size_t x, size_t z) const;
+
+    /**
+     * @brief Draws the tiles inside the frustum, with the level of detail selected from the camera distance or fixed.
+     */
+    void draw_tiles(const Shader &shader, const du::Frustum &frustum, Vector3 camera_position, int fixed_level);
+
+    /**
+     * @brief Computes the position and normal of a vertex in the frame of the terrain.
+     */
+    void get_vertex(size_t x, size_t z, Vector3 &position, Vector3 &normal) const;
+
+    /**
+     * @brief Builds (or updates in place) the mesh of a level of detail of a tile.
+     */
+    void build_tile_mesh(Tile &tile, int level);
+
+    /**
+     * @brief Recomputes the bounds of a tile.
+     */
+    void update_tile_bounds(Tile &tile);
+
+public:
+    /**
+     * @brief Creates a terrain. No GPU resources are allocated until it is drawn.
+     * @param width Number of vertices along x.
+     * @param depth Number of vertices along z.
+     * @param heights Heights of the vertices, row major (width * depth values, or nullptr for a flat terrain).
+     * @param cell_size_x Distance between the vertices along x.
+     * @param cell_size_z Distance between the vertices along z.
+     * @param height_scale Factor applied to the heights.
+     * @param tile_cells Cells along each side of a tile.
+     */
+    Terrain(size_t width, size_t depth, const float *heights, float cell_size_x, float cell_size_z, float height_scale, size_t tile_cells = 64);
+    Terrain(const Terrain &) = delete;
+    Terrain &operator=(const Terrain &) = delete;
+
+    /**
+     * @brief Replaces the heights of a rectangle of vertices (clipped to the terrain).
+     * Only the tiles touching the rectangle (or its neighbours, whose normals change) are rebuilt.
+     * @param x First column of the rectangle.
+     * @param z First row of the rectangle.
+     * @param width Number of columns of the rectangle.
+     * @param depth Number of rows of the rectangle.
+     * @param heights New heights, row major (width * depth values).
+     */
+    void set_heights(size_t x, size_t z, size_t width, size_t depth, const float *heights);
+
+    /**
+     * @brief Gets the height of a vertex (before scaling).
+     */
+    float get_height(size_t x, size_t z) const;
+
+    /**
+     * @brief Sets the pose of the terrain. The terrain is centered on its position.
+     */
+    void set_pose(Vector3 position, Quaternion orientation);
+
+    /**
+     * @brief Sets the color of the terrain.
+     */
+    void set_color(Color color);
+
+    /**
+     * @brief Sets the distance up to which the tiles are drawn with full detail.
+     * The level of detail decreases by one every time the distance doubles.
+     */
+    void set_lod_distance(float distance);
+
+    /**
+     * @brief Draws the tiles inside the frustum. Must be called between BeginMode3D and EndMode3D.
+     * @param shader Shader used to draw the tiles.
+     * @param frustum Frustum of the camera (world space).
+     * @param camera_position Position of the camera (selects the levels of detail).
+     */
+    void draw(const Shader &shader, const du::Frustum &frustum, Vector3 camera_position);
+
+    /**
+     * @brief Draws the tiles inside the frustum with the same level of detail for every tile, independent of the
+     * camera (e.g. into a cached shadow map). All the stale tile meshes of that level are rebuilt.
+     * @param shader Shader used to draw the tiles.
+     * @param frustum Frustum used to cull the tiles (world space).
+     * @param level Level of detail (clamped to the levels of the terrain).
+     */
+    void draw_level(const Shader &shader, const du::Frustum &frustum, int level);
+
+    /**
+     * @brief Gets the coarsest level of detail whose cells are not larger than a distance.
+     * @param spacing Distance in world units (e.g. the size of a shadow map texel).
+     */
+    int get_level_for_spacing(float spacing) const;
+
+    /**
+     * @brief Gets the number of tiles drawn by the last draw.
+     */
+    size_t get_drawn_tiles() const;
+
+    /**
+     * @brief Gets the number of stale tiles the last draw showed with their previous mesh (over the rebuild budget).
+     * The terrain has to be drawn again until it is 0.
+     */
+    size_t get_deferred_builds() const;
+
+    /**
+     * @brief Releases the GPU resources (the heights are kept). Safe to call more than once.
+     */
+    void unload();
+};
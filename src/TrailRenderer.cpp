@@ -0,0 +1,327 @@
+#include "TrailRenderer.hpp"
+#include <algorithm>
+#include <cstddef>
+#include <string>
+#include <raymath.h>
+#include "rlgl.h"
+
+#include "DrawingUtils.hpp"
+#include "GlLoader.hpp"
+
+void TrailRenderer::load()
+{
+    if (this->ready_)
+    {
+        return;
+    }
+
+    // SHADER_BASE_PATH is defined in the CMAKE file
+    std::string vs_path = std::string(SHADER_BASE_PATH) + "/trail.vs";
+    std::string fs_path = std::string(SHADER_BASE_PATH) + "/trail.fs";
+    this->shader_ = LoadShader(vs_path.c_str(), fs_path.c_str());
+
+    // raylib falls back to the default shader if the trail shader fails to compile
+    if (this->shader_.id == 0 || this->shader_.id == rlGetShaderIdDefault())
+    {
+        TraceLog(LOG_WARNING, "ROBOVIS: Trail shader not available, using immediate mode trails");
+        return;
+    }
+    this->time_loc_ = GetShaderLocation(this->shader_, "currentTime");
+    this->timing_attrib_loc_ = GetShaderLocationAttrib(this->shader_, "vertexTiming");
+    this->ready_ = true;
+}
+
+void TrailRenderer::unload()
+{
+    if (this->vbo_ != 0)
+    {
+        rlUnloadVertexBuffer(this->vbo_);
+    }
+    if (this->vao_ != 0)
+    {
+        rlUnloadVertexArray(this->vao_);
+    }
+    this->vbo_ = 0;
+    this->vao_ = 0;
+    this->gpu_capacity_ = 0;
+    if (this->ready_)
+    {
+        UnloadShader(this->shader_);
+    }
+    this->shader_ = {0};
+    this->ready_ = false;
+}
+
+size_t TrailRenderer::allocate_slice(size_t size)
+{
+    for (size_t i = 0; i < this->free_slices_.size(); i++)
+    {
+        auto &[first, free_size] = this->free_slices_[i];
+        if (free_size < size)
+        {
+            continue;
+        }
+        size_t slice = first;
+        first += size;
+        free_size -= size;
+        if (free_size == 0)
+        {
+            this->free_slices_[i] = this->free_slices_.back();
+            this->free_slices_.pop_back();
+        }
+        return slice;
+    }
+    size_t slice = this->vertices_.size();
+    this->vertices_.resize(slice + size);
+    this->vertex_dirty_.resize(slice + size, false);
+    return slice;
+}
+
+void TrailRenderer::write_vertex(size_t index, const TrailVertex &vertex)
+{
+    this->vertices_[index] = vertex;
+    if (this->upload_all_ || this->vertex_dirty_[index])
+    {
+        return;
+    }
+    // Past a quarter of the buffer a single upload of everything is cheaper than one call per vertex
+    if (this->dirty_vertices_.size() >= this->vertices_.size() / 4)
+    {
+        this->reset_dirty_vertices();
+        this->upload_all_ = true;
+        return;
+    }
+    this->vertex_dirty_[index] = true;
+    this->dirty_vertices_.push_back(index);
+}
+
+void TrailRenderer::reset_dirty_vertices()
+{
+    for (size_t index : this->dirty_vertices_)
+    {
+        this->vertex_dirty_[index] = false;
+    }
+    this->dirty_vertices_.clear();
+}
+
+int TrailRenderer::add_trail(size_t capacity, float duration, Color color, float min_spacing)
+{
+    Trail trail;
+    trail.capacity = std::max(capacity, (size_t)2);
+    trail.first = this->allocate_slice(trail.capacity + 1);
+    trail.color = color;
+    trail.duration = std::max(duration, 0.0f);
+    trail.min_spacing = std::max(min_spacing, 0.0f);
+    return this->trails_.insert(trail);
+}
+
+void TrailRenderer::remove_trail(int handle)
+{
+    const Trail *trail = this->trails_.get(handle);
+    if (trail == nullptr)
+    {
+        return;
+    }
+    this->free_slices_.push_back({trail->first, trail->capacity + 1});
+    this->trails_.erase(handle);
+}
+
+void TrailRenderer::clear_trail(int handle)
+{
+    Trail *trail = this->trails_.get(handle);
+    if (trail == nullptr)
+    {
+        return;
+    }
+    trail->head = 0;
+    trail->count = 0;
+}
+
+void TrailRenderer::clear()
+{
+    this->trails_.clear();
+    this->vertices_.clear();
+    this->free_slices_.clear();
+    this->dirty_vertices_.clear();
+    this->vertex_dirty_.clear();
+    this->upload_all_ = false;
+}
+
+bool TrailRenderer::contains(int handle) const
+{
+    return this->trails_.contains(handle);
+}
+
+bool TrailRenderer::is_fading(float time) const
+{
+    for (const Trail &trail : this->trails_)
+    {
+        if (trail.duration <= 0.0f || trail.count < 2)
+        {
+            continue;
+        }
+        // The newest sample is refreshed while the point rests, the trail looks the same once the sample before it faded out
+        size_t previous = (trail.head + 2 * trail.capacity - 2) % trail.capacity;
+        if (this->vertices_[trail.first + previous].time + trail.duration > time)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+void TrailRenderer::add_sample(int handle, Vector3 position, float time)
+{
+    Trail *trail = this->trails_.get(handle);
+    if (trail == nullptr)
+    {
+        return;
+    }
+
+    // A point that did not move refreshes the newest sample, so a resting object keeps a visible trail end
+    size_t slot = trail->head;
+    if (trail->count > 0)
+    {
+        size_t last = (trail->head + trail->capacity - 1) % trail->capacity;
+        if (Vector3Distance(this->vertices_[trail->first + last].position, position) <= trail->min_spacing)
+        {
+            slot = last;
+        }
+    }
+
+    TrailVertex vertex = {position, trail->color, time, trail->duration};
+    this->write_vertex(trail->first + slot, vertex);
+    if (slot == 0)
+    {
+        this->write_vertex(trail->first + trail->capacity, vertex);
+    }
+    if (slot == trail->head)
+    {
+        trail->head = (trail->head + 1) % trail->capacity;
+        trail->count = std::min(trail->count + 1, trail->capacity);
+    }
+}
+
+void TrailRenderer::add_strips(const Trail &trail)
+{
+    if (trail.count < 2)
+    {
+        return;
+    }
+    if (trail.count < trail.capacity || trail.head == 0)
+    {
+        // The samples are in order from the start of the slice
+        this->strip_firsts_.push_back(trail.first);
+        this->strip_counts_.push_back(trail.count);
+        return;
+    }
+    // Oldest samples first, ending on the copy of sample 0, then the newest samples
+    this->strip_firsts_.push_back(trail.first + trail.head);
+    this->strip_counts_.push_back(trail.capacity - trail.head + 1);
+    if (trail.head >= 2)
+    {
+        this->strip_firsts_.push_back(trail.first);
+        this->strip_counts_.push_back(trail.head);
+    }
+}
+
+void TrailRenderer::upload()
+{
+    if (this->vao_ == 0)
+    {
+        this->vao_ = rlLoadVertexArray();
+    }
+
+    if (this->vertices_.size() > this->gpu_capacity_)
+    {
+        rlEnableVertexArray(this->vao_);
+        if (this->vbo_ != 0)
+        {
+            rlUnloadVertexBuffer(this->vbo_);
+        }
+        this->gpu_capacity_ = std::max(this->vertices_.size(), std::max(this->gpu_capacity_ * 2, (size_t)4096));
+        this->vbo_ = rlLoadVertexBuffer(nullptr, this->gpu_capacity_ * sizeof(TrailVertex), true);
+        rlEnableVertexBuffer(this->vbo_);
+        rlUpdateVertexBuffer(this->vbo_, this->vertices_.data(), this->vertices_.size() * sizeof(TrailVertex), 0);
+        du::set_vertex_attribute(RL_DEFAULT_SHADER_ATTRIB_LOCATION_POSITION, 3, RL_FLOAT, false, sizeof(TrailVertex), offsetof(TrailVertex, position));
+        rlEnableVertexAttribute(RL_DEFAULT_SHADER_ATTRIB_LOCATION_POSITION);
+        du::set_vertex_attribute(RL_DEFAULT_SHADER_ATTRIB_LOCATION_COLOR, 4, RL_UNSIGNED_BYTE, true, sizeof(TrailVertex), offsetof(TrailVertex, color));
+        rlEnableVertexAttribute(RL_DEFAULT_SHADER_ATTRIB_LOCATION_COLOR);
+        if (this->timing_attrib_loc_ >= 0)
+        {
+            du::set_vertex_attribute(this->timing_attrib_loc_, 2, RL_FLOAT, false, sizeof(TrailVertex), offsetof(TrailVertex, time));
+            rlEnableVertexAttribute(this->timing_attrib_loc_);
+        }
+        rlDisableVertexBuffer();
+        rlDisableVertexArray();
+    }
+    else if (this->upload_all_)
+    {
+        rlUpdateVertexBuffer(this->vbo_, this->vertices_.data(), this->vertices_.size() * sizeof(TrailVertex), 0);
+    }
+    else
+    {
+        // One vertex per new sample, independent of the length of the trails
+        for (size_t index : this->dirty_vertices_)
+        {
+            rlUpdateVertexBuffer(this->vbo_, &this->vertices_[index], sizeof(TrailVertex), index * sizeof(TrailVertex));
+        }
+    }
+    this->reset_dirty_vertices();
+    this->upload_all_ = false;
+}
+
+void TrailRenderer::draw(float time)
+{
+    this->strip_firsts_.clear();
+    this->strip_counts_.clear();
+    for (const Trail &trail : this->trails_)
+    {
+        this->add_strips(trail);
+    }
+    if (this->strip_firsts_.empty())
+    {
+        // The written vertices are sent with the whole buffer once a trail can be drawn
+        if (!this->dirty_vertices_.empty())
+        {
+            this->reset_dirty_vertices();
+            this->upload_all_ = true;
+        }
+        return;
+    }
+    rlDrawRenderBatchActive();
+
+    const gl_loader::Functions &gl = gl_loader::get_functions();
+    if (!this->ready_ || gl.glMultiDrawArrays == nullptr)
+    {
+        rlBegin(RL_LINES);
+        for (size_t i = 0; i < this->strip_firsts_.size(); i++)
+        {
+            for (int j = 0; j < this->strip_counts_[i]; j++)
+            {
+                const TrailVertex &vertex = this->vertices_[this->strip_firsts_[i] + j];
+                float fade = vertex.duration > 0.0f ? Clamp(1.0f - (time - vertex.time) / vertex.duration, 0.0f, 1.0f) : 1.0f;
+                rlColor4ub(vertex.color.r, vertex.color.g, vertex.color.b, (unsigned char)(vertex.color.a * fade));
+                rlVertex3f(vertex.position.x, vertex.position.y, vertex.position.z);
+                // Inner vertices end a line and start the next one
+                if (j > 0 && j + 1 < this->strip_counts_[i])
+                {
+                    rlVertex3f(vertex.position.x, vertex.position.y, vertex.position.z);
+                }
+            }
+        }
+        rlEnd();
+        this->reset_dirty_vertices();
+        this->upload_all_ = false;
+        return;
+    }
+
+    this->upload();
+    rlEnableShader(this->shader_.id);
+    rlSetUniformMatrix(this->shader_.locs[SHADER_LOC_MATRIX_MVP], MatrixMultiply(rlGetMatrixModelview(), rlGetMatrixProjection()));
+    rlSetUniform(this->time_loc_, &time, RL_SHADER_UNIFORM_FLOAT, 1);
+    rlEnableVertexArray(this->vao_);
+    gl.glMultiDrawArrays(gl_loader::GL_LINE_STRIP, this->strip_firsts_.data(), this->strip_counts_.data(), this->strip_firsts_.size());
+    rlDisableVertexArray();
+    rlDisableShader();
+}
@@ -0,0 +1,148 @@
+#pragma once
+#include <raylib.h>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+#include "SlotMap.hpp"
+
+/**
+ * @brief Draws trajectory trails (the recent path of moving points) stored in fixed-capacity ring buffers.
+ *
+ * All the trails share one GPU vertex buffer in which every trail owns a slice used as a ring: adding a
+ * sample writes a single vertex, and all the trails are drawn with one glMultiDrawArrays call (one or two
+ * line strips per trail, depending on whether the ring wrapped). Samples fade out with their age in the
+ * vertex shader, so the per-frame cost does not depend on the length of the trails.
+ * If the trail shader or the multi-draw entry point is not available, the trails are drawn in immediate mode.
+ */
+class TrailRenderer
+{
+private:
+    /**
+     * @brief Vertex of the shared buffer.
+     */
+    struct TrailVertex
+    {
+        Vector3 position; // Position of the sample.
+        Color color;      // Color of the trail.
+        float time;       // Time at which the sample was taken.
+        float duration;   // Fade duration of the trail.
+    };
+
+    /**
+     * @brief Ring of samples of a trail. The slice holds capacity + 1 vertices: the last one repeats the
+     * first sample so the strip going through the end of the ring continues to its start.
+     */
+    struct Trail
+    {
+        size_t first = 0;    // First vertex of the slice in the shared buffer.
+        size_t capacity = 0; // Number of samples of the ring.
+        size_t head = 0;     // Slot written by the next sample.
+        size_t count = 0;    // Number of samples stored (up to capacity).
+        Color color;         // Color of the trail.
+        float duration;      // Fade duration in seconds (0 to disable the fade).
+        float min_spacing;   // Samples closer than this to the previous one refresh it instead of being added.
+    };
+
+    SlotMap<Trail> trails_;                                  // Trails referenced by generational handles.
+    std::vector<TrailVertex> vertices_;                      // CPU copy of the shared buffer.
+    std::vector<std::pair<size_t, size_t>> free_slices_;     // Slices (first vertex, size) released by removed trails.
+    std::vector<size_t> dirty_vertices_;                     // Vertices written since the last upload (each listed once).
+    std::vector<bool> vertex_dirty_;                         // Flag of every vertex indicating whether it is in dirty_vertices_.
+    bool upload_all_ = false;                                // Flag indicating whether the next upload sends the whole buffer.
+    std::vector<int> strip_firsts_;                          // First vertex of every line strip drawn (reused every frame).
+    std::vector<int> strip_counts_;                          // Vertex count of every line strip drawn (reused every frame).
+    Shader shader_ = {0};                                    // Trail shader (fades the samples with their age).
+    int time_loc_ = -1;                                      // Location of the current time uniform.
+    int timing_attrib_loc_ = -1;                             // Location of the sample time and duration attribute.
+    unsigned int vao_ = 0;                                   // Vertex array of the shared buffer.
+    unsigned int vbo_ = 0;                                   // Shared GPU vertex buffer.
+    size_t gpu_capacity_ = 0;                                // Number of vertices the GPU buffer can hold.
+    bool ready_ = false;                                     // Flag indicating whether the GPU path is available.
+
+    /**
+     * @brief Reserves a slice of the shared buffer (reusing a released one if possible).
+     */
+    size_t allocate_slice(size_t size);
+
+    /**
+     * @brief Writes a vertex of the shared buffer.
+     */
+    void write_vertex(size_t index, const TrailVertex &vertex);
+
+    /**
+     * @brief Empties the list of written vertices (without uploading them).
+     */
+    void reset_dirty_vertices();
+
+    /**
+     * @brief Uploads the written vertices, recreating the GPU buffer if the shared buffer grew.
+     */
+    void upload();
+
+    /**
+     * @brief Appends the line strips of a trail (in sample order) to strip_firsts_ and strip_counts_.
+     */
+    void add_strips(const Trail &trail);
+
+public:
+    /**
+     * @brief Loads the trail shader. Requires an active OpenGL context.
+     */
+    void load();
+
+    /**
+     * @brief Unloads all the GPU resources (the trails are kept). Safe to call more than once.
+     */
+    void unload();
+
+    /**
+     * @brief Adds an empty trail.
+     * @param capacity Maximum number of samples, the oldest samples are overwritten once it is reached.
+     * @param duration Age in seconds at which the samples are fully faded out (0 to disable the fade).
+     * @param color Color of the trail.
+     * @param min_spacing Samples closer than this distance to the previous one refresh its time instead of being added.
+     * @return Handle of the trail.
+     */
+    int add_trail(size_t capacity, float duration, Color color, float min_spacing = 0.0f);
+
+    /**
+     * @brief Removes a trail and releases its slice of the shared buffer.
+     */
+    void remove_trail(int handle);
+
+    /**
+     * @brief Removes the samples of a trail.
+     */
+    void clear_trail(int handle);
+
+    /**
+     * @brief Removes all the trails.
+     */
+    void clear();
+
+    /**
+     * @brief Returns true if the handle refers to an existing trail.
+     */
+    bool contains(int handle) const;
+
+    /**
+     * @brief Checks whether some trails are still fading out, i.e. whether drawing them at a later time gives a different image.
+     * @param time Current time, on the same clock as the samples.
+     */
+    bool is_fading(float time) const;
+
+    /**
+     * @brief Adds a sample to a trail (O(1), a single vertex is uploaded).
+     * @param handle Handle of the trail.
+     * @param position Position of the sample.
+     * @param time Time of the sample in seconds, on the same clock as the time passed to draw.
+     */
+    void add_sample(int handle, Vector3 position, float time);
+
+    /**
+     * @brief Draws all the trails. Must be called between BeginMode3D and EndMode3D.
+     * @param time Current time, used to fade the samples with their age.
+     */
+    void draw(float time);
+};
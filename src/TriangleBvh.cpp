@@ -0,0 +1,213 @@
+#include "TriangleBvh.hpp"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+namespace
+{
+    float get_component(const Vector3 &v, int axis)
+    {
+        return axis == 0 ? v.x : (axis == 1 ? v.y : v.z);
+    }
+
+    // Slab test, returns the distance at which the ray enters the box (or FLT_MAX if it misses it)
+    float intersect_box(const BoundingBox &box, const Vector3 &origin, const Vector3 &inv_direction, float max_distance)
+    {
+        float t_x1 = (box.min.x - origin.x) * inv_direction.x;
+        float t_x2 = (box.max.x - origin.x) * inv_direction.x;
+        float t_y1 = (box.min.y - origin.y) * inv_direction.y;
+        float t_y2 = (box.max.y - origin.y) * inv_direction.y;
+        float t_z1 = (box.min.z - origin.z) * inv_direction.z;
+        float t_z2 = (box.max.z - origin.z) * inv_direction.z;
+
+        float t_near = std::max(std::max(std::min(t_x1, t_x2), std::min(t_y1, t_y2)), std::min(t_z1, t_z2));
+        float t_far = std::min(std::min(std::max(t_x1, t_x2), std::max(t_y1, t_y2)), std::max(t_z1, t_z2));
+
+        if (t_far < std::max(t_near, 0.0f) || t_near > max_distance)
+        {
+            return FLT_MAX;
+        }
+        return t_near;
+    }
+}
+
+TriangleBvh::TriangleBvh(const Mesh &mesh)
+{
+    if (mesh.vertices == nullptr || mesh.triangleCount == 0)
+    {
+        return;
+    }
+
+    // Gather the triangles (meshes can be indexed or not)
+    std::vector<Vector3> vertices(mesh.triangleCount * 3);
+    for (int i = 0; i < mesh.triangleCount * 3; i++)
+    {
+        int vertex = mesh.indices != nullptr ? mesh.indices[i] : i;
+        vertices[i] = Vector3{mesh.vertices[vertex * 3], mesh.vertices[vertex * 3 + 1], mesh.vertices[vertex * 3 + 2]};
+    }
+
+    std::vector<int> triangle_ids(mesh.triangleCount);
+    std::vector<Vector3> centroids(mesh.triangleCount);
+    for (int i = 0; i < mesh.triangleCount; i++)
+    {
+        triangle_ids[i] = i;
+        centroids[i] = Vector3Scale(Vector3Add(Vector3Add(vertices[i * 3], vertices[i * 3 + 1]), vertices[i * 3 + 2]), 1.0f / 3.0f);
+    }
+
+    this->nodes_.reserve(2 * mesh.triangleCount / MAX_LEAF_TRIANGLES + 1);
+    this->build_node(triangle_ids, centroids, vertices, 0, mesh.triangleCount);
+
+    // Store the triangles in leaf order, so the leaves read contiguous memory
+    this->triangles_.resize(vertices.size());
+    for (int i = 0; i < mesh.triangleCount; i++)
+    {
+        for (int j = 0; j < 3; j++)
+        {
+            this->triangles_[i * 3 + j] = vertices[triangle_ids[i] * 3 + j];
+        }
+    }
+}
+
+int TriangleBvh::build_node(std::vector<int> &triangle_ids, std::vector<Vector3> &centroids, const std::vector<Vector3> &vertices, int begin, int end)
+{
+    int index = this->nodes_.size();
+    this->nodes_.push_back(Node());
+
+    BoundingBox box = {{FLT_MAX, FLT_MAX, FLT_MAX}, {-FLT_MAX, -FLT_MAX, -FLT_MAX}};
+    BoundingBox centroid_box = box;
+    for (int i = begin; i < end; i++)
+    {
+        int triangle = triangle_ids[i];
+        for (int j = 0; j < 3; j++)
+        {
+            box.min = Vector3Min(box.min, vertices[triangle * 3 + j]);
+            box.max = Vector3Max(box.max, vertices[triangle * 3 + j]);
+        }
+        centroid_box.min = Vector3Min(centroid_box.min, centroids[triangle]);
+        centroid_box.max = Vector3Max(centroid_box.max, centroids[triangle]);
+    }
+    this->nodes_[index].box = box;
+
+    // Split along the longest axis of the centroids
+    Vector3 extent = Vector3Subtract(centroid_box.max, centroid_box.min);
+    int axis = extent.x > extent.y ? (extent.x > extent.z ? 0 : 2) : (extent.y > extent.z ? 1 : 2);
+
+    if (end - begin <= MAX_LEAF_TRIANGLES || get_component(extent, axis) <= 0.0f)
+    {
+        this->nodes_[index].first = begin;
+        this->nodes_[index].count = end - begin;
+        return index;
+    }
+
+    int middle = (begin + end) / 2;
+    std::nth_element(triangle_ids.begin() + begin, triangle_ids.begin() + middle, triangle_ids.begin() + end,
+                     [&centroids, axis](int a, int b)
+                     { return get_component(centroids[a], axis) < get_component(centroids[b], axis); });
+
+    this->build_node(triangle_ids, centroids, vertices, begin, middle);
+    int second_child = this->build_node(triangle_ids, centroids, vertices, middle, end);
+    this->nodes_[index].first = second_child;
+    this->nodes_[index].count = 0;
+    return index;
+}
+
+std::vector<TriangleBvh> TriangleBvh::build_model(const Model &model)
+{
+    std::vector<TriangleBvh> bvhs;
+    bvhs.reserve(model.meshCount);
+    for (int i = 0; i < model.meshCount; i++)
+    {
+        bvhs.emplace_back(model.meshes[i]);
+    }
+    return bvhs;
+}
+
+RayCollision TriangleBvh::raycast(const Ray &ray, float max_distance) const
+{
+    RayCollision collision = {0};
+    collision.distance = max_distance;
+    if (this->nodes_.empty())
+    {
+        return collision;
+    }
+
+    Vector3 inv_direction = {1.0f / ray.direction.x, 1.0f / ray.direction.y, 1.0f / ray.direction.z};
+
+    int stack[64];
+    int stack_size = 0;
+    stack[stack_size++] = 0;
+    while (stack_size > 0)
+    {
+        int index = stack[--stack_size];
+        const Node &node = this->nodes_[index];
+        if (intersect_box(node.box, ray.position, inv_direction, collision.distance) == FLT_MAX)
+        {
+            continue;
+        }
+
+        if (node.count > 0)
+        {
+            // Moller-Trumbore intersection with the triangles of the leaf
+            for (int i = node.first; i < node.first + node.count; i++)
+            {
+                const Vector3 &p_1 = this->triangles_[i * 3];
+                Vector3 edge_1 = Vector3Subtract(this->triangles_[i * 3 + 1], p_1);
+                Vector3 edge_2 = Vector3Subtract(this->triangles_[i * 3 + 2], p_1);
+                Vector3 p = Vector3CrossProduct(ray.direction, edge_2);
+                float det = Vector3DotProduct(edge_1, p);
+                if (std::fabs(det) < 1e-12f)
+                {
+                    continue;
+                }
+                float inv_det = 1.0f / det;
+                Vector3 t_vec = Vector3Subtract(ray.position, p_1);
+                float u = Vector3DotProduct(t_vec, p) * inv_det;
+                if (u < 0.0f || u > 1.0f)
+                {
+                    continue;
+                }
+                Vector3 q = Vector3CrossProduct(t_vec, edge_1);
+                float v = Vector3DotProduct(ray.direction, q) * inv_det;
+                if (v < 0.0f || u + v > 1.0f)
+                {
+                    continue;
+                }
+                float t = Vector3DotProduct(edge_2, q) * inv_det;
+                if (t > 0.0f && t < collision.distance)
+                {
+                    collision.hit = true;
+                    collision.distance = t;
+                    collision.point = Vector3Add(ray.position, Vector3Scale(ray.direction, t));
+                    collision.normal = Vector3Normalize(Vector3CrossProduct(edge_1, edge_2));
+                }
+            }
+        }
+        else if (stack_size + 2 <= 64)
+        {
+            // Visit the nearest child first, so farther boxes can be skipped with the updated distance
+            int child_1 = index + 1;
+            int child_2 = node.first;
+            float distance_1 = intersect_box(this->nodes_[child_1].box, ray.position, inv_direction, collision.distance);
+            float distance_2 = intersect_box(this->nodes_[child_2].box, ray.position, inv_direction, collision.distance);
+            if (distance_1 > distance_2)
+            {
+                std::swap(child_1, child_2);
+                std::swap(distance_1, distance_2);
+            }
+            if (distance_2 != FLT_MAX)
+            {
+                stack[stack_size++] = child_2;
+            }
+            if (distance_1 != FLT_MAX)
+            {
+                stack[stack_size++] = child_1;
+            }
+        }
+    }
+    return collision;
+}
+
+size_t TriangleBvh::get_triangle_count() const
+{
+    return this->triangles_.size() / 3;
+}
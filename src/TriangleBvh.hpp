@@ -0,0 +1,56 @@
+#pragma once
+#include <raylib.h>
+#include <raymath.h>
+#include <vector>
+
+/**
+ * @brief Static bounding volume hierarchy over the triangles of a mesh, used to cast rays against it.
+ *
+ * The hierarchy is built once from the CPU copy of the mesh vertices and stores its own copy of the
+ * triangles (ordered like the leaves), so a raycast only visits the triangles whose boxes the ray crosses
+ * instead of testing every triangle of the mesh.
+ */
+class TriangleBvh
+{
+private:
+    static constexpr int MAX_LEAF_TRIANGLES = 4; // Maximum number of triangles stored in a leaf.
+
+    /**
+     * @brief Node of the hierarchy. Children of internal nodes are stored at index + 1 and at first.
+     */
+    struct Node
+    {
+        BoundingBox box; // Bounds of the triangles under the node.
+        int first = 0;   // First triangle of a leaf, or second child of an internal node.
+        int count = 0;   // Number of triangles of a leaf (0 for internal nodes).
+    };
+
+    std::vector<Node> nodes_;        // Nodes in depth first order (the root is the first node).
+    std::vector<Vector3> triangles_; // Three vertices per triangle, in leaf order.
+
+    int build_node(std::vector<int> &triangle_ids, std::vector<Vector3> &centroids, const std::vector<Vector3> &vertices, int begin, int end);
+
+public:
+    /**
+     * @brief Builds the hierarchy of a mesh. Meshes without a CPU copy of their vertices give an empty hierarchy.
+     */
+    explicit TriangleBvh(const Mesh &mesh);
+
+    /**
+     * @brief Builds the hierarchies of all the meshes of a model.
+     */
+    static std::vector<TriangleBvh> build_model(const Model &model);
+
+    /**
+     * @brief Casts a ray against the triangles of the mesh.
+     * @param ray Ray in mesh space. The direction does not need to be normalized, distances are measured in units of the direction.
+     * @param max_distance Hits farther than this distance are ignored.
+     * @return Nearest hit (position and normal in mesh space).
+     */
+    RayCollision raycast(const Ray &ray, float max_distance) const;
+
+    /**
+     * @brief Returns the number of triangles of the mesh.
+     */
+    size_t get_triangle_count() const;
+};
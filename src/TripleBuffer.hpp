@@ -0,0 +1,64 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+
+/**
+ * @brief Lock-free triple buffer for handing the latest value from one producer thread to one consumer thread.
+ *
+ * The producer writes into back() and calls publish(), the consumer calls update() and reads front().
+ * Each side owns one of the three slots and the third one is swapped atomically, so neither side ever
+ * waits for the other. Values published faster than they are consumed are overwritten (only the latest is kept).
+ */
+template <typename T>
+class TripleBuffer
+{
+private:
+    static constexpr uint8_t INDEX_MASK = 0x3; // Bits holding the slot index.
+    static constexpr uint8_t FRESH_BIT = 0x4;  // Bit set when the shared slot holds a value not yet consumed.
+
+    T buffers_[3];                       // Storage for the three slots.
+    std::atomic<uint8_t> middle_{1};     // Index of the shared slot (and fresh flag).
+    uint8_t back_ = 0;                   // Index of the slot owned by the producer.
+    uint8_t front_ = 2;                  // Index of the slot owned by the consumer.
+
+public:
+    /**
+     * @brief Slot the producer writes into. Only to be used by the producer thread.
+     */
+    T &back()
+    {
+        return this->buffers_[this->back_];
+    }
+
+    /**
+     * @brief Makes the back slot available to the consumer. Only to be called by the producer thread.
+     */
+    void publish()
+    {
+        uint8_t previous = this->middle_.exchange(this->back_ | FRESH_BIT, std::memory_order_acq_rel);
+        this->back_ = previous & INDEX_MASK;
+    }
+
+    /**
+     * @brief Swaps the latest published slot into the front slot. Only to be called by the consumer thread.
+     * @return True if a new value was published since the last call.
+     */
+    bool update()
+    {
+        if (!(this->middle_.load(std::memory_order_relaxed) & FRESH_BIT))
+        {
+            return false;
+        }
+        uint8_t previous = this->middle_.exchange(this->front_, std::memory_order_acq_rel);
+        this->front_ = previous & INDEX_MASK;
+        return true;
+    }
+
+    /**
+     * @brief Latest value received by the consumer. Only to be used by the consumer thread.
+     */
+    const T &front() const
+    {
+        return this->buffers_[this->front_];
+    }
+};
@@ -1,18 +1,80 @@
 #include "Visualizer.hpp"
+#include <cstring>
 
-Visualizer::Visualizer(int screen_width, int screen_height, const char *title) : screen_width_(screen_width),
-                                                                                 screen_height_(screen_height),
-                                                                                 title_(title),
-                                                                                 wireframe_mode_(false),
-                                                                                 focused_object_index_(0)
+// GLFW is linked in by desktop raylib, the weak declaration resolves to null when it is not
+#if defined(__GNUC__) || defined(__clang__)
+extern "C" void glfwInitHint(int hint, int value) __attribute__((weak));
+#define VISUALIZER_HAS_GLFW_HINTS 1
+#else
+#define VISUALIZER_HAS_GLFW_HINTS 0
+#endif
+
+namespace
+{
+    constexpr int GLFW_PLATFORM = 0x00050003;
+    constexpr int GLFW_ANY_PLATFORM = 0x00060000;
+    constexpr int GLFW_PLATFORM_NULL = 0x00060005;
+
+    /**
+     * @brief Selects the GLFW platform used by the next InitWindow call (GLFW 3.4 or newer).
+     * @return False if the hint can not be set.
+     */
+    bool set_glfw_platform(int platform)
+    {
+#if VISUALIZER_HAS_GLFW_HINTS
+        if (glfwInitHint != nullptr)
+        {
+            glfwInitHint(GLFW_PLATFORM, platform);
+            return true;
+        }
+#endif
+        (void)platform;
+        return false;
+    }
+}
+
+Visualizer::Visualizer(int screen_width, int screen_height, const char *title, bool headless) : screen_width_(screen_width),
+                                                                                                screen_height_(screen_height),
+                                                                                                title_(title),
+                                                                                                headless_(headless),
+                                                                                                wireframe_mode_(false),
+                                                                                                focused_object_index_(0)
 {
-    SetConfigFlags(FLAG_WINDOW_RESIZABLE);
-    InitWindow(screen_width_, screen_height_, title_);
+    if (this->headless_)
+    {
+        // The null platform of GLFW creates an OSMesa (software) context without any display server.
+        // If it is not available, fall back to a hidden window (which needs a display, e.g. Xvfb).
+        SetConfigFlags(FLAG_WINDOW_HIDDEN);
+        bool null_platform = set_glfw_platform(GLFW_PLATFORM_NULL);
+        InitWindow(screen_width_, screen_height_, title_);
+        if (!IsWindowReady() && null_platform)
+        {
+            TraceLog(LOG_WARNING, "VISUALIZER: Headless context not available, trying a hidden window");
+            set_glfw_platform(GLFW_ANY_PLATFORM);
+            InitWindow(screen_width_, screen_height_, title_);
+        }
+    }
+    else
+    {
+        SetConfigFlags(FLAG_WINDOW_RESIZABLE);
+        InitWindow(screen_width_, screen_height_, title_);
 
-    SetTargetFPS(60);
-    rlImGuiSetup(true); // Setup ImGui
+        SetTargetFPS(60);
+        rlImGuiSetup(true); // Setup ImGui
+    }
     this->set_up_camera();
     this->shader_target_ = LoadRenderTexture(screen_width_, screen_height_);
+    this->instanced_renderer_.load();
+    this->trail_renderer_.load();
+
+    // Shader used to draw the objects and their triangle edges in a single pass
+    std::string edges_vs_path = std::string(SHADER_BASE_PATH) + "/edges.vs";
+    std::string edges_fs_path = std::string(SHADER_BASE_PATH) + "/edges.fs";
+    this->shaders_.insert({"edges", LoadShader(edges_vs_path.c_str(), edges_fs_path.c_str())});
+
+    std::string point_cloud_vs_path = std::string(SHADER_BASE_PATH) + "/point_cloud.vs";
+    std::string point_cloud_fs_path = std::string(SHADER_BASE_PATH) + "/point_cloud.fs";
+    this->shaders_.insert({"point_cloud", LoadShader(point_cloud_vs_path.c_str(), point_cloud_fs_path.c_str())});
 }
 
 Visualizer::~Visualizer()
@@ -28,21 +90,15 @@ void Visualizer::set_up_camera()
         .up = {0.0f, 1.0f, 0.0f},
         .fovy = 45.0f,
         .projection = CAMERA_PERSPECTIVE};
-
-    this->shadow_map_camera = Camera3D{
-        .position = {0.0f, 10.0f, 0.0f},
-        .target = {.0f, .0f, .0f},
-        .up = {0.0f, 1.0f, 0.0f},
-        .fovy = 20.0f,
-        .projection = CAMERA_PERSPECTIVE};
 }
 
 void Visualizer::set_camera_focus()
 {
     this->focus_mode_ = (this->previously_focused_object_index_ != this->focused_object_index_ || this->focus_mode_);
-    if (this->focus_mode_)
+    VisualObject *focused_object = this->find_visual_object(this->focused_object_index_);
+    if (this->focus_mode_ && focused_object != nullptr)
     {
-        this->camera_.target = this->visual_objects_[this->focused_object_index_]->position;
+        this->camera_.target = focused_object->position;
         this->previously_focused_object_index_ = this->focused_object_index_;
         this->focus_mode_ = true;
     }
@@ -82,19 +138,49 @@ void Visualizer::draw_gui()
     ImGui::Text("Wireframe mode");
     ImGui::Checkbox("Wireframe mode", &this->wireframe_mode_);
     ImGui::Checkbox("Show Frames", &this->show_bodies_coordinate_frame_);
+    ImGui::Checkbox("Frustum culling", &this->frustum_culling_);
+    ImGui::Checkbox("Primitive level of detail", &this->primitive_lod_);
+    ImGui::Checkbox("Render on demand", &this->render_on_demand_);
+    if (this->shader_loaded_)
+    {
+        ImGui::Checkbox("Shadows", &this->shadows_enabled_);
+        ImGui::Text("Static shadow map renders: %zu", this->shadow_map_.get_static_renders());
+        ImGui::Text("Additional lights: %zu, dropped tile slots: %zu", this->scene_lights_.size(), this->scene_lights_.get_dropped_lights());
+    }
+    ImGui::Text("Drawn objects: %zu, culled objects: %zu", this->render_stats_.drawn_objects, this->render_stats_.culled_objects);
+    ImGui::Text("Skipped frames: %zu", this->render_stats_.skipped_frames);
+    bool profiling = this->profiler_.is_enabled();
+    if (ImGui::Checkbox("Profiler", &profiling))
+    {
+        this->profiler_.set_enabled(profiling);
+    }
+    if (this->recorder_.is_open())
+    {
+        ImGui::Text("Recording scene: %zu frames, %.1f MB", this->recorder_.get_frame_count(), this->recorder_.get_size() / (1024.0f * 1024.0f));
+    }
+    else if (this->recorder_.has_failed())
+    {
+        ImGui::Text("Recording failed: write error after %zu frames", this->recorder_.get_frame_count());
+    }
+    if (this->capture_.is_capturing())
+    {
+        CaptureStats capture_stats = this->capture_.get_stats();
+        ImGui::Text("Capturing: %zu written, %zu dropped, queue %zu", capture_stats.written_frames, capture_stats.dropped_frames, capture_stats.queue_depth);
+    }
     ImGui::Separator();
     ImGui::Text("Focused object");
     //ImGui::InputInt("Focused object index", &this->focused_object_index_);
     // Create a drop down menu for the focused object
     if (ImGui::BeginCombo("Focused object", TextFormat("Object %d", this->focused_object_index_)))
     {
-        for (int n = 0; n < this->visual_objects_.size(); n++)
+        for (size_t n = 0; n < this->visual_objects_.size(); n++)
         {
-            bool is_selected = (this->focused_object_index_ == n);
+            int handle = this->visual_objects_.handle_at(n);
+            bool is_selected = (this->focused_object_index_ == handle);
 
-            if (ImGui::Selectable(TextFormat("Object %d", n), is_selected))
+            if (ImGui::Selectable(TextFormat("Object %d", handle), is_selected))
             {
-                this->focused_object_index_ = n;
+                this->focused_object_index_ = handle;
             }
             if (is_selected)
             {
@@ -105,6 +191,21 @@ void Visualizer::draw_gui()
     }
     // End the GUI
     ImGui::End();
+    if (this->profiler_.is_enabled())
+    {
+        this->profiler_.draw_panel();
+    }
+    if (this->player_.is_open())
+    {
+        this->draw_playback_timeline();
+    }
+    // A widget changes the scene while it is held and when it is released, the change is drawn on the next frame
+    bool gui_active = ImGui::IsAnyItemActive();
+    if (gui_active || this->gui_active_)
+    {
+        this->scene_dirty_ = true;
+    }
+    this->gui_active_ = gui_active;
     rlImGuiEnd();
 }
 
@@ -170,144 +271,371 @@ void Visualizer::update_camera()
 
 void Visualizer::update()
 {
-    // Update the camera
-    this->update_camera();
+    this->profiler_.begin_frame();
 
-    // Update Camera Looking Vector. Vector length determines FOV.
-    this->shadow_map_camera.position = this->camera_.position;
-
-    // TODO : FIX THIS
-    if (this->shader_loaded_)
+    // Apply the poses published by the simulation thread
     {
-        float cameraPos[3] = {this->camera_.position.x, this->camera_.position.y, this->camera_.position.z};
-        SetShaderValue(this->shaders_["light"], this->shaders_["light"].locs[SHADER_LOC_VECTOR_VIEW], cameraPos, SHADER_UNIFORM_VEC3);
-        UpdateLightValues(this->shaders_["light"], this->light_);
+        FrameProfiler::Scope scope(this->profiler_, ProfilerStage::POSES);
+        if (this->player_.is_open())
+        {
+            this->apply_playback_frame();
+        }
+        else
+        {
+            this->apply_published_poses();
+        }
+        this->begin_recorded_frame();
+        this->sample_trails();
     }
 
-    this->set_camera_focus();
-    this->select_visual_object();
+    {
+        FrameProfiler::Scope scope(this->profiler_, ProfilerStage::CAMERA);
+        // Update the camera (there is no input to poll in headless mode)
+        if (!this->headless_)
+        {
+            this->update_camera();
+        }
 
-    // Draw
-    BeginTextureMode(this->shader_target_);
-    // Clear the background
-    ClearBackground({30, 30, 30, 255});
-    // Draw the axis
-    BeginMode3D(this->camera_);
-    DrawGrid(100, 1.0f);
-    EndMode3D();
+        // TODO : FIX THIS
+        if (this->shader_loaded_)
+        {
+            float cameraPos[3] = {this->camera_.position.x, this->camera_.position.y, this->camera_.position.z};
+            SetShaderValue(this->shaders_["light"], this->shaders_["light"].locs[SHADER_LOC_VECTOR_VIEW], cameraPos, SHADER_UNIFORM_VEC3);
+            SetShaderValue(this->shaders_["light_edges"], this->shaders_["light_edges"].locs[SHADER_LOC_VECTOR_VIEW], cameraPos, SHADER_UNIFORM_VEC3);
+        }
 
-    BeginMode3D(this->camera_);
-    for (auto &vis_object : this->visual_objects_)
+        this->set_camera_focus();
+    }
+
+    if (!this->headless_)
     {
-        bool disabled = disabled_groups[vis_object->group_id];
-        if (!disabled)
+        FrameProfiler::Scope scope(this->profiler_, ProfilerStage::PICKING);
+        this->select_visual_object();
+    }
+
+    // Unchanged frames keep the scene of the last rendered frame, only the GUI is drawn again
+    this->render_stats_.scene_rendered = this->needs_scene_render();
+    if (this->render_stats_.scene_rendered)
+    {
+        if (this->player_.is_open())
         {
-            this->render_visual_object(vis_object);
+            this->queue_playback_primitives();
         }
+        this->render_scene();
     }
-
-    // Draw The lines
-    while (!this->lines_.empty())
+    else
     {
-        Line line = this->lines_.front();
-        DrawLine3D(line.start_pos, line.end_pos, line.color);
-        this->lines_.pop();
+        this->render_stats_.skipped_frames++;
     }
-    // Draw The spheres
-    while (!this->spheres_.empty())
+
+    // In headless mode the frame stays in the render texture (read it with get_frame_image)
+    if (this->headless_)
     {
-        VisSphere sphere = this->spheres_.front();
-        DrawSphere(sphere.position, sphere.radius, sphere.color);
-        this->spheres_.pop();
+        return;
     }
 
-    // Draw The segments
-    while (!this->segments_.empty())
+    BeginDrawing();
     {
-        Segment segment = this->segments_.front();
-        du::draw_segment(segment.start_pos, segment.end_pos,  segment.color, segment.scale);
-        this->segments_.pop();
+        FrameProfiler::Scope scope(this->profiler_, ProfilerStage::BLIT);
+        // Draw the texture
+        this->draw_shader();
     }
+    {
+        FrameProfiler::Scope scope(this->profiler_, ProfilerStage::GUI);
+        this->profiler_.begin_gpu(ProfilerStage::GPU_GUI);
+        // Draw the GUI
+        this->draw_gui();
+        this->profiler_.end_gpu(ProfilerStage::GPU_GUI);
+    }
+    {
+        FrameProfiler::Scope scope(this->profiler_, ProfilerStage::PRESENT);
+        EndDrawing();
+    }
+}
 
-    
-    // Draw Arrows
-    while (!this->arrows_.empty())
+bool Visualizer::needs_scene_render()
+{
+    // The recorded and captured frames must all be rendered
+    if (!this->render_on_demand_ || this->recorder_.is_open() || this->capture_.is_capturing())
     {
-        Arrow arrow = this->arrows_.front();
-        du::draw_arrow(arrow.origin, Vector3Add(arrow.origin, arrow.vector), arrow.color, arrow.radius);
-        this->arrows_.pop();
+        return true;
     }
-    // Draw AABB
-    while (!this->aabb_buffer_.empty())
+    // Refitting the objects that moved marks the scene dirty
+    this->refit_visual_object_bounds();
+
+    // The primitives of a frame have to be drawn, and erased on the next frame
+    bool frame_primitives = !this->lines_.empty() || this->frame_lines_.get_line_count() > 0 || !this->spheres_.empty() ||
+                            !this->segments_.empty() || !this->arrows_.empty() || !this->aabb_buffer_.empty() ||
+                            !this->discs_.empty() || !this->ring_sections_.empty() || !this->text_labels_buffer_.empty();
+    // The line sets and point clouds are modified through their own pointers (the point clouds from any thread)
+    uint64_t retained_changes = 0;
+    for (const std::unique_ptr<LineSet> &line_set : this->line_sets_)
     {
-        AxisAlignedBoundingBox aabb = this->aabb_buffer_.front();
-        DrawBoundingBox(aabb.bounding_box, aabb.color);
-        this->aabb_buffer_.pop();
+        retained_changes += line_set->get_change_count();
+    }
+    for (const std::shared_ptr<PointCloud> &point_cloud : this->point_clouds_)
+    {
+        retained_changes += point_cloud->get_change_count();
+    }
+    // Terrain tiles over the rebuild budget keep their previous heights until the terrain is drawn again
+    bool terrain_builds = false;
+    for (const std::unique_ptr<Terrain> &terrain : this->terrains_)
+    {
+        terrain_builds = terrain_builds || terrain->get_deferred_builds() > 0;
     }
 
-    // Draw The discs
-    while (!this->discs_.empty())
+    if (frame_primitives || this->rendered_frame_primitives_ || retained_changes != this->rendered_retained_changes_ || terrain_builds ||
+        std::memcmp(&this->camera_, &this->rendered_camera_, sizeof(Camera)) != 0 || this->trail_renderer_.is_fading(GetTime()) ||
+        (!this->headless_ && IsWindowResized()))
+    {
+        this->scene_dirty_ = true;
+    }
+    if (this->scene_dirty_)
     {
-        Disc disc = this->discs_.front();
-        disc.draw();
-        this->discs_.pop();
+        this->rendered_frame_primitives_ = frame_primitives;
+        this->rendered_retained_changes_ = retained_changes;
     }
+    return this->scene_dirty_;
+}
 
-    // Draw the rings:
-    while(!this->ring_sections_.empty()){
-        RingSection ring = this->ring_sections_.front();
-        ring.draw();
-        this->ring_sections_.pop();
+void Visualizer::render_scene()
+{
+    if (this->shadows_enabled_ && this->shader_loaded_)
+    {
+        FrameProfiler::Scope scope(this->profiler_, ProfilerStage::SHADOWS);
+        this->render_shadow_maps();
     }
 
+    // Draw
+    BeginTextureMode(this->shader_target_);
+    this->profiler_.begin_gpu(ProfilerStage::GPU_SCENE);
+    // Clear the background
+    ClearBackground({30, 30, 30, 255});
+    // Draw the axis
+    BeginMode3D(this->camera_);
+    DrawGrid(100, 1.0f);
     EndMode3D();
 
+    BeginMode3D(this->camera_);
+    {
+        FrameProfiler::Scope scope(this->profiler_, ProfilerStage::OBJECTS);
+        bool shadows = this->shadows_enabled_ && this->shader_loaded_;
+        if (this->shader_loaded_)
+        {
+            this->scene_lights_.update(this->camera_, this->screen_width_, this->screen_height_);
+            for (const char *shader_name : {"light", "light_edges"})
+            {
+                this->shadow_map_.apply(this->shaders_[shader_name], shadows);
+                this->scene_lights_.apply(this->shaders_[shader_name]);
+            }
+        }
+        // Only the objects whose bounds intersect the camera frustum are drawn
+        this->refit_visual_object_bounds();
+        this->visible_objects_.clear();
+        if (this->frustum_culling_)
+        {
+            du::Frustum frustum = du::get_frustum(MatrixMultiply(rlGetMatrixModelview(), rlGetMatrixProjection()));
+            this->object_bvh_.query_frustum(frustum, this->visible_objects_);
+        }
+        else
+        {
+            for (size_t i = 0; i < this->visual_objects_.size(); i++)
+            {
+                this->visible_objects_.push_back(this->visual_objects_.handle_at(i));
+            }
+        }
+        this->render_stats_.drawn_objects = 0;
+        // Pixels covered by one world unit at a distance of one unit, used for the primitive levels of detail
+        bool perspective = this->camera_.projection == CAMERA_PERSPECTIVE;
+        float pixels_per_unit = perspective ? this->screen_height_ / (2.0f * tanf(0.5f * this->camera_.fovy * DEG2RAD))
+                                            : this->screen_height_ / this->camera_.fovy;
+        for (int handle : this->visible_objects_)
+        {
+            std::shared_ptr<VisualObject> *vis_object = this->visual_objects_.get(handle);
+            bool disabled = disabled_groups[(*vis_object)->group_id];
+            if (!disabled)
+            {
+                if ((*vis_object)->lod_level >= 0)
+                {
+                    this->select_primitive_lod(**vis_object, pixels_per_unit, perspective);
+                }
+                this->render_visual_object(*vis_object);
+                this->render_stats_.drawn_objects++;
+            }
+        }
+        this->render_stats_.culled_objects = this->visual_objects_.size() - this->visible_objects_.size();
+
+        if (!this->terrains_.empty())
+        {
+            du::Frustum frustum = du::get_frustum(MatrixMultiply(rlGetMatrixModelview(), rlGetMatrixProjection()));
+            Shader terrain_shader = this->shader_loaded_ ? this->shaders_["light"] : Shader{rlGetShaderIdDefault(), rlGetShaderLocsDefault()};
+            for (const std::unique_ptr<Terrain> &terrain : this->terrains_)
+            {
+                terrain->draw(terrain_shader, frustum, this->camera_.position);
+            }
+        }
+        for (const std::shared_ptr<PointCloud> &point_cloud : this->point_clouds_)
+        {
+            point_cloud->draw(this->shaders_["point_cloud"], this->camera_.position, this->screen_height_);
+        }
+        if (shadows)
+        {
+            this->shadow_map_.unbind();
+        }
+        if (this->shader_loaded_)
+        {
+            this->scene_lights_.unbind();
+        }
+    }
 
-    // Draw the text on the normal labels
-    for (const auto &[_, label] : this->text_labels_)
     {
-        this->draw_text_label(label);
+        FrameProfiler::Scope scope(this->profiler_, ProfilerStage::PRIMITIVES);
+        // Draw The lines
+        while (!this->lines_.empty())
+        {
+            const Line &line = this->lines_.front();
+            this->frame_lines_.add_line(line.start_pos, line.end_pos, line.color);
+            this->lines_.pop();
+        }
+        if (this->recorded_frame_ != nullptr)
+        {
+            const std::vector<Vector3> &vertices = this->frame_lines_.get_vertices();
+            const std::vector<unsigned int> &indices = this->frame_lines_.get_indices();
+            for (size_t i = 0; i + 1 < indices.size(); i += 2)
+            {
+                this->recorded_frame_->lines.push_back(RecordedLine{vertices[indices[i]], vertices[indices[i + 1]], this->frame_lines_.get_colors()[indices[i]]});
+            }
+        }
+        this->frame_lines_.draw();
+        this->frame_lines_.clear();
+        for (const std::unique_ptr<LineSet> &line_set : this->line_sets_)
+        {
+            line_set->draw();
+        }
+        this->trail_renderer_.draw(GetTime());
+        // Draw The spheres
+        while (!this->spheres_.empty())
+        {
+            const VisSphere &sphere = this->spheres_.front();
+            this->instanced_renderer_.add_sphere(sphere.position, sphere.radius, sphere.color);
+            this->spheres_.pop();
+        }
+
+        // Draw The segments
+        while (!this->segments_.empty())
+        {
+            const Segment &segment = this->segments_.front();
+            this->instanced_renderer_.add_segment(segment.start_pos, segment.end_pos, segment.scale, segment.color);
+            if (this->recorded_frame_ != nullptr)
+            {
+                this->recorded_frame_->segments.push_back(RecordedSegment{segment.start_pos, segment.end_pos, segment.scale, segment.color});
+            }
+            this->segments_.pop();
+        }
+
+        // Draw Arrows
+        while (!this->arrows_.empty())
+        {
+            const Arrow &arrow = this->arrows_.front();
+            this->instanced_renderer_.add_arrow(arrow.origin, Vector3Add(arrow.origin, arrow.vector), arrow.radius, arrow.color);
+            if (this->recorded_frame_ != nullptr)
+            {
+                this->recorded_frame_->arrows.push_back(RecordedArrow{arrow.origin, arrow.vector, arrow.radius, arrow.color});
+            }
+            this->arrows_.pop();
+        }
+        // Draw AABB
+        while (!this->aabb_buffer_.empty())
+        {
+            AxisAlignedBoundingBox aabb = this->aabb_buffer_.front();
+            DrawBoundingBox(aabb.bounding_box, aabb.color);
+            this->aabb_buffer_.pop();
+        }
+
+        // Draw The discs
+        while (!this->discs_.empty())
+        {
+            const Disc &disc = this->discs_.front();
+            this->instanced_renderer_.add_disc(disc.center, disc.axis, disc.radius, disc.color);
+            this->discs_.pop();
+        }
+
+        // Draw the rings:
+        while (!this->ring_sections_.empty())
+        {
+            const RingSection &ring = this->ring_sections_.front();
+            this->instanced_renderer_.add_ring_section(ring.center, ring.axis, ring.outer_radius, ring.inner_radius, ring.angle_f, ring.angle_o, ring.color);
+            this->ring_sections_.pop();
+        }
+
+        // Draw all the batched primitives (including the body frames) with one call per primitive kind
+        this->instanced_renderer_.draw();
     }
-    // Draw the text from the buffer
-    while (!this->text_labels_buffer_.empty())
+
+    EndMode3D();
+
     {
-        TextLabel label = this->text_labels_buffer_.front();
-        this->draw_text_label(label);
-        this->text_labels_buffer_.pop();
+        FrameProfiler::Scope scope(this->profiler_, ProfilerStage::TEXT_LABELS);
+        // Labels that cannot be seen are rejected before their layout, the others are drawn in a few batches
+        this->label_renderer_.begin(this->camera_, this->screen_width_, this->screen_height_);
+        // Draw the text on the normal labels (a playback brings its own labels)
+        if (!this->player_.is_open())
+        {
+            for (const auto &[_, label] : this->text_labels_)
+            {
+                if (!label.enabled)
+                {
+                    continue;
+                }
+                this->label_renderer_.add(label.text, label.font, label.position, label.fontSize, label.color, label.background, label.backgroundColor);
+                if (this->recorded_frame_ != nullptr)
+                {
+                    this->recorded_frame_->labels.push_back(RecordedLabel{label.text, label.position, label.fontSize, label.color, label.background, label.backgroundColor});
+                }
+            }
+        }
+        // Draw the text from the buffer
+        while (!this->text_labels_buffer_.empty())
+        {
+            const TextLabel &label = this->text_labels_buffer_.front();
+            this->label_renderer_.add(label.text, label.font, label.position, label.fontSize, label.color, label.background, label.backgroundColor);
+            if (this->recorded_frame_ != nullptr)
+            {
+                this->recorded_frame_->labels.push_back(RecordedLabel{label.text, label.position, label.fontSize, label.color, label.background, label.backgroundColor});
+            }
+            this->text_labels_buffer_.pop();
+        }
+        this->label_renderer_.draw();
     }
+    this->profiler_.end_gpu(ProfilerStage::GPU_SCENE);
     EndTextureMode();
-    BeginDrawing();
-    // Draw the texture
-    this->draw_shader();
-    // Draw the GUI
-    this->draw_gui();
-    EndDrawing();
+    this->capture_.capture(this->shader_target_);
+    if (this->recorded_frame_ != nullptr)
+    {
+        this->recorder_.end_frame();
+        this->recorded_frame_ = nullptr;
+    }
+    this->rendered_camera_ = this->camera_;
+    this->scene_dirty_ = false;
 }
 
-void Visualizer::draw_text_label(TextLabel label)
+void Visualizer::draw_text_label(const TextLabel &label)
 {
-    float distance = Vector3Distance(label.position, this->camera_.position);
-    Vector2 screenPosition = GetWorldToScreen(label.position, this->camera_);
-
-    // Adjust text size based on the distance
-    float text_size = (label.fontSize / distance);
-
-    Vector2 text_dim = MeasureTextEx(label.font, label.text.c_str(), text_size, text_size * 0.3);
-
-    Vector2 background_pos = screenPosition;
-    background_pos.x = screenPosition.x - text_dim.x * 0.05;
-    background_pos.y = screenPosition.y - text_dim.y * 0.05;
-    text_dim.x = text_dim.x * 1.10;
-    text_dim.y = text_dim.y * 1.10;
+    this->label_renderer_.begin(this->camera_, this->screen_width_, this->screen_height_);
+    this->label_renderer_.add(label.text, label.font, label.position, label.fontSize, label.color, label.background, label.backgroundColor);
+    this->label_renderer_.draw();
+}
 
-    DrawRectangleV(background_pos, text_dim, BLACK);
-    DrawTextEx(label.font, label.text.c_str(), screenPosition, text_size, text_size * 0.3, WHITE);
+bool Visualizer::load_label_sdf_font(const char *path, int base_size)
+{
+    this->scene_dirty_ = true;
+    return this->label_renderer_.load_sdf_font(path, base_size);
 }
 
 void Visualizer::draw_text(std::string text, Vector3 position, float font_size, bool background, Color color, Font font, Color background_color)
 {
     TextLabel label = {
-        text,
+        std::move(text),
         position,
         font_size,
         color,
@@ -316,7 +644,7 @@ void Visualizer::draw_text(std::string text, Vector3 position, float font_size,
         background_color,
         true};
 
-    this->text_labels_buffer_.push(label);
+    this->text_labels_buffer_.push(std::move(label));
 }
 
 int Visualizer::add_text_label(std::string text, Vector3 position, float font_size, bool background, Color color, Font font, Color background_color)
@@ -331,19 +659,32 @@ int Visualizer::add_text_label(std::string text, Vector3 position, float font_si
         background_color,
         true};
 
-    this->text_labels_.insert({this->text_labels_.size() - 1, label});
+    // Indices are never reused, so they stay valid
+    int index = this->text_labels_.empty() ? 0 : this->text_labels_.rbegin()->first + 1;
+    this->text_labels_.insert({index, std::move(label)});
+    this->scene_dirty_ = true;
 
-    return this->text_labels_.size() - 1;
+    return index;
 }
 
 void Visualizer::modify_text_label(int index, std::string text)
 {
-    this->text_labels_[index].text = text;
+    auto label = this->text_labels_.find(index);
+    if (label != this->text_labels_.end())
+    {
+        label->second.text = std::move(text);
+        this->scene_dirty_ = true;
+    }
 }
 
 void Visualizer::modify_text_position(int index, Vector3 position)
 {
-    this->text_labels_[index].position = position;
+    auto label = this->text_labels_.find(index);
+    if (label != this->text_labels_.end())
+    {
+        label->second.position = position;
+        this->scene_dirty_ = true;
+    }
 }
 
 
@@ -400,6 +741,35 @@ void Visualizer::draw_ring_section(Vector3 position,
 
 }
 
+void Visualizer::draw_polyline(const Vector3 *points, size_t count, Color color, bool closed)
+{
+    this->frame_lines_.add_polyline(points, count, color, closed);
+}
+
+int Visualizer::add_line_set()
+{
+    this->scene_dirty_ = true;
+    return this->line_sets_.insert(std::make_unique<LineSet>());
+}
+
+LineSet *Visualizer::get_line_set(int handle)
+{
+    std::unique_ptr<LineSet> *line_set = this->line_sets_.get(handle);
+    return line_set != nullptr ? line_set->get() : nullptr;
+}
+
+void Visualizer::remove_line_set(int handle)
+{
+    std::unique_ptr<LineSet> *line_set = this->line_sets_.get(handle);
+    if (line_set == nullptr)
+    {
+        return;
+    }
+    (*line_set)->unload();
+    this->line_sets_.erase(handle);
+    this->scene_dirty_ = true;
+}
+
 void Visualizer::draw_sphere(Vector3 position, float radius, Color color)
 {
 
@@ -435,14 +805,17 @@ void Visualizer::draw_aabb(Vector3 min, Vector3 max, Color color)
 
 void Visualizer::set_up_lighting()
 {
-    this->light_ = CreateLight(LIGHT_DIRECTIONAL, (Vector3){0.0f, 100.0f, 0.0f}, Vector3Zero(), WHITE, this->shaders_["light"]);
-
-    this->shaders_["light"].locs[SHADER_LOC_VECTOR_VIEW] = GetShaderLocation(this->shaders_["light"], "viewPos");
+    // The light uniforms of both lighting shaders are set every frame (see SceneLights::apply)
+    this->scene_lights_.set_main_light(this->light_direction_, WHITE);
+    this->scene_lights_.load(this->screen_width_, this->screen_height_);
 
     // Ambient light level (some basic lighting)
-    int ambientLoc = GetShaderLocation(this->shaders_["light"], "ambient");
     Vector4 ambient = {1.2f, 1.2f, 1.2f, .9f}; // Use Vector4 for ambient light
-    SetShaderValue(this->shaders_["light"], ambientLoc, &ambient, SHADER_UNIFORM_VEC4);
+    for (const char *shader_name : {"light", "light_edges"})
+    {
+        int ambientLoc = GetShaderLocation(this->shaders_[shader_name], "ambient");
+        SetShaderValue(this->shaders_[shader_name], ambientLoc, &ambient, SHADER_UNIFORM_VEC4);
+    }
 
     this->assing_lighting_to_models();
 }
@@ -475,19 +848,63 @@ void Visualizer::load_shader(const char *filename_vs, const char *filename_fs, i
     this->shaders_["light"].locs[RL_SHADER_LOC_MATRIX_MODEL] = GetShaderLocation(this->shaders_["light"], "matModel");
     this->shaders_["light"].locs[RL_SHADER_LOC_VECTOR_VIEW] = GetShaderLocation(this->shaders_["light"], "viewPos");
 
+    // Variant of the lighting shader that also draws the triangle edges
+    this->shaders_.insert({"light_edges", du::load_shader_with_defines(vs_path.c_str(), fs_path.c_str(), "#define EDGE_OVERLAY\n")});
+    this->shaders_["light_edges"].locs[RL_SHADER_LOC_MATRIX_MODEL] = GetShaderLocation(this->shaders_["light_edges"], "matModel");
+    this->shaders_["light_edges"].locs[RL_SHADER_LOC_VECTOR_VIEW] = GetShaderLocation(this->shaders_["light_edges"], "viewPos");
+
     this->shader_loaded_ = true;
+    this->scene_dirty_ = true;
 
     this->set_up_lighting();
 }
 
 void Visualizer::close()
 {
+    this->capture_.stop();
+    this->recorder_.close();
+    this->player_.close();
     // Unload all the models
     for (auto &vis_object : this->visual_objects_)
     {
-        UnloadModel(vis_object->model);
+        this->release_visual_object_model(*vis_object);
+    }
+    this->visual_objects_.clear();
+    this->object_bvh_.clear();
+    this->model_cache_.unload();
+    this->instanced_renderer_.unload();
+    this->frame_lines_.unload();
+    for (const std::unique_ptr<LineSet> &line_set : this->line_sets_)
+    {
+        line_set->unload();
+    }
+    this->line_sets_.clear();
+    for (const std::unique_ptr<Terrain> &terrain : this->terrains_)
+    {
+        terrain->unload();
+    }
+    this->terrains_.clear();
+    for (const std::shared_ptr<PointCloud> &point_cloud : this->point_clouds_)
+    {
+        point_cloud->unload();
+    }
+    this->point_clouds_.clear();
+    this->trail_renderer_.unload();
+    this->label_renderer_.unload();
+    this->shadow_map_.unload();
+    this->scene_lights_.unload();
+    this->trail_renderer_.clear();
+    this->trail_sources_.clear();
+    this->profiler_.unload();
+    for (auto &[_, shader] : this->shaders_)
+    {
+        UnloadShader(shader);
+    }
+    this->shaders_.clear();
+    if (!this->headless_)
+    {
+        rlImGuiShutdown();
     }
-    rlImGuiShutdown();
     UnloadRenderTexture(this->shader_target_);
     CloseWindow();
 }
@@ -497,10 +914,13 @@ void Visualizer::unload_models(void)
     // Unload all the models
     for (auto &vis_object : this->visual_objects_)
     {
-        UnloadModel(vis_object->model);
+        this->release_visual_object_model(*vis_object);
     }
 
-    this->visual_objects_ = {};
+    this->visual_objects_.clear();
+    this->object_bvh_.clear();
+    this->shadow_map_.invalidate_static();
+    this->scene_dirty_ = true;
 }
 
 void Visualizer::set_imgui_interfaces(std::function<void(void)> func)
@@ -515,8 +935,6 @@ int Visualizer::select_visual_object()
     static bool double_click = true;
     static float double_click_time = 0.0f;
 
-    float nearest_collision_distance = FLT_MAX;
-
     // Apply the function if there is a double click
     if (IsMouseButtonPressed(MOUSE_LEFT_BUTTON) && double_click)
     {
@@ -524,19 +942,10 @@ int Visualizer::select_visual_object()
         double_click = false;
         Ray ray = GetMouseRay(GetMousePosition(), this->camera_);
         DrawRay(ray, GREEN);
-        int i = 0;
-        for (const auto &obj : this->visual_objects_)
+        int handle = this->raycast_visual_objects(ray);
+        if (handle != -1)
         {
-            // Note that this works because we use single mesh models.
-            RayCollision collision = GetRayCollisionMesh(ray, obj->model.meshes[0], du::get_transform(obj->position, obj->orientation));
-
-            if (collision.hit && collision.distance < nearest_collision_distance)
-            {
-                // Update the nearest object information
-                nearest_collision_distance = collision.distance;
-                this->focused_object_index_ = i;
-            }
-            i++;
+            this->focused_object_index_ = handle;
         }
     }
     // If there is a single click start the double click timer
@@ -554,30 +963,131 @@ int Visualizer::select_visual_object()
     return this->focused_object_index_;
 }
 
-void Visualizer::render_visual_object(std::shared_ptr<VisualObject> vis_object)
+int Visualizer::raycast_visual_objects(const Ray &ray, RayCollision *collision)
 {
-    // Get the rotation axis and angle from the quaternion
-    Vector3 axis;
-    float angle;
-    QuaternionToAxisAngle(vis_object->orientation, &axis, &angle);
-    angle = angle * 180 / 3.1415926535;
+    // Make sure the bounds in the hierarchy match the current poses
+    this->refit_visual_object_bounds();
+
+    RayCollision nearest = {0};
+    nearest.distance = FLT_MAX;
+    int nearest_handle = -1;
+
+    this->object_bvh_.query(
+        [&ray, &nearest](const BoundingBox &box)
+        {
+            RayCollision box_collision = GetRayCollisionBox(ray, box);
+            return box_collision.hit && box_collision.distance < nearest.distance;
+        },
+        [this, &ray, &nearest, &nearest_handle](int handle)
+        {
+            VisualObject *vis_object = this->find_visual_object(handle);
+            if (vis_object->mesh_bvhs == nullptr)
+            {
+                vis_object->mesh_bvhs = vis_object->model_key.empty()
+                                            ? std::make_shared<const std::vector<TriangleBvh>>(TriangleBvh::build_model(vis_object->model))
+                                            : this->model_cache_.get_mesh_bvhs(vis_object->model_key);
+            }
+
+            // Cast the ray in mesh space, the direction keeps the world scale so the distances stay in world units
+            Matrix inverse = MatrixInvert(vis_object->world_transform);
+            Ray local_ray = {
+                .position = Vector3Transform(ray.position, inverse),
+                .direction = Vector3Subtract(Vector3Transform(ray.direction, inverse), Vector3Transform(Vector3Zero(), inverse))};
+
+            for (const TriangleBvh &mesh_bvh : *vis_object->mesh_bvhs)
+            {
+                RayCollision mesh_collision = mesh_bvh.raycast(local_ray, nearest.distance);
+                if (mesh_collision.hit)
+                {
+                    nearest.hit = true;
+                    nearest.distance = mesh_collision.distance;
+                    nearest.point = Vector3Add(ray.position, Vector3Scale(ray.direction, mesh_collision.distance));
+                    // Normals are transformed by the inverse transpose
+                    nearest.normal = Vector3Normalize(Vector3Transform(mesh_collision.normal, MatrixTranspose(inverse)));
+                    nearest_handle = handle;
+                }
+            }
+        });
+
+    if (collision != nullptr)
+    {
+        *collision = nearest;
+    }
+    return nearest_handle;
+}
+
+void Visualizer::select_primitive_lod(VisualObject &vis_object, float pixels_per_unit, bool perspective)
+{
+    // Projected radius (pixels) above which a level is replaced by the next finer one
+    static constexpr float LOD_THRESHOLDS[ModelCache::PRIMITIVE_LOD_LEVELS - 1] = {4.0f, 12.0f, 40.0f, 120.0f};
+    static constexpr float LOD_HYSTERESIS = 0.2f; // Relative band around every threshold in which the level is kept.
+
+    int level = ModelCache::PRIMITIVE_DEFAULT_LOD;
+    if (this->primitive_lod_)
+    {
+        float distance = perspective ? std::max(Vector3Distance(this->camera_.position, vis_object.position), 1e-3f) : 1.0f;
+        float radius = vis_object.bounding_radius * pixels_per_unit / distance;
+        level = vis_object.lod_level;
+        while (level < ModelCache::PRIMITIVE_LOD_LEVELS - 1 && radius > LOD_THRESHOLDS[level] * (1.0f + LOD_HYSTERESIS))
+        {
+            level++;
+        }
+        while (level > 0 && radius < LOD_THRESHOLDS[level - 1] * (1.0f - LOD_HYSTERESIS))
+        {
+            level--;
+        }
+    }
+    if (level == vis_object.lod_level)
+    {
+        return;
+    }
+    // The edge meshes and triangle hierarchies are looked up through the key of the level
+    vis_object.lod_level = level;
+    vis_object.model.meshes = vis_object.lod_meshes[level];
+    vis_object.model_key = vis_object.lod_keys[level];
+    vis_object.mesh_bvhs = nullptr;
+}
+
+void Visualizer::render_visual_object(const std::shared_ptr<VisualObject> &vis_object)
+{
+    // The world transform is cached and only recomputed when the pose or scale changes
+    const Matrix &transform = vis_object->world_transform;
+    // Groups outside the tracked range can not be disabled, so their objects keep their own setting
+    int group_id = vis_object->group_id;
+    bool group_disabled = group_id >= 0 && group_id < (int)this->edge_overlay_disabled_groups_.size() &&
+                          this->edge_overlay_disabled_groups_[group_id];
+    bool edge_overlay = vis_object->edge_overlay && !group_disabled;
     if (this->wireframe_mode_)
     {
-        DrawModelWiresEx(vis_object->model, vis_object->position, axis, angle, {1.0f, 1.0f, 1.0f}, vis_object->color);
+        du::draw_model_wires(vis_object->model, transform, vis_object->color);
+    }
+    else if (!edge_overlay)
+    {
+        du::draw_model(vis_object->model, transform, vis_object->color);
     }
     else
     {
-        DrawModelEx(vis_object->model, vis_object->position, axis, angle, {1.0f, 1.0f, 1.0f}, vis_object->color);
-        // Draw wireframe with a small offset in the color (make it darker)
-        Color wireColor = {(unsigned char)(vis_object->color.r * 0.7f),
-                           (unsigned char)(vis_object->color.g * 0.7f),
-                           (unsigned char)(vis_object->color.b * 0.7f), 255};
-        DrawModelWiresEx(vis_object->model, vis_object->position, axis, angle, {1.0f, 1.0f, 1.0f}, wireColor);
+        const Shader &edge_shader = this->shader_loaded_ ? this->shaders_["light_edges"] : this->shaders_["edges"];
+        const Mesh *edge_meshes = vis_object->model_key.empty() ? nullptr : this->model_cache_.get_edge_meshes(vis_object->model_key);
+        if (edge_meshes != nullptr && edge_shader.id != rlGetShaderIdDefault())
+        {
+            // Solid model and edges in one pass
+            du::draw_model_edges(vis_object->model, edge_meshes, transform, vis_object->color, edge_shader);
+        }
+        else
+        {
+            // Models not managed by the cache draw the edges with a second wireframe pass
+            du::draw_model(vis_object->model, transform, vis_object->color);
+            Color wireColor = {(unsigned char)(vis_object->color.r * 0.7f),
+                               (unsigned char)(vis_object->color.g * 0.7f),
+                               (unsigned char)(vis_object->color.b * 0.7f), 255};
+            du::draw_model_wires(vis_object->model, transform, wireColor);
+        }
     }
 
     if (this->show_bodies_coordinate_frame_)
     {
-        du::draw_axes(vis_object->position, vis_object->orientation, this->axes_size);
+        this->instanced_renderer_.add_axes(vis_object->position, vis_object->orientation, this->axes_size);
     }
 }
 
@@ -586,6 +1096,8 @@ void Visualizer::disable_visual_object_group_rendering(int group_id)
     if (group_id < 255)
     {
         this->disabled_groups[group_id] = true;
+        this->shadow_map_.invalidate_static();
+        this->scene_dirty_ = true;
     }
 }
 
@@ -594,5 +1106,401 @@ void Visualizer::enable_visual_object_group_rendering(int group_id)
     if (group_id < 255)
     {
         this->disabled_groups[group_id] = false;
+        this->shadow_map_.invalidate_static();
+        this->scene_dirty_ = true;
+    }
+}
+
+void Visualizer::set_group_edge_overlay(int group_id, bool enabled)
+{
+    if (group_id >= 0 && group_id < (int)this->edge_overlay_disabled_groups_.size())
+    {
+        this->edge_overlay_disabled_groups_[group_id] = !enabled;
+        this->scene_dirty_ = true;
+    }
+}
+
+void Visualizer::set_frustum_culling(bool enabled)
+{
+    this->frustum_culling_ = enabled;
+}
+
+void Visualizer::set_primitive_lod(bool enabled)
+{
+    this->primitive_lod_ = enabled;
+    this->scene_dirty_ = true;
+}
+
+void Visualizer::set_render_on_demand(bool enabled)
+{
+    this->render_on_demand_ = enabled;
+    this->scene_dirty_ = true;
+}
+
+void Visualizer::request_redraw()
+{
+    this->scene_dirty_ = true;
+}
+
+void Visualizer::enable_shadows(int resolution, float extent, Vector3 center)
+{
+    if (this->shadow_map_.is_loaded() && this->shadow_map_.get_resolution() != resolution)
+    {
+        this->shadow_map_.unload();
+    }
+    this->shadow_resolution_ = resolution;
+    this->shadow_map_.set_region(center, extent);
+    this->shadows_enabled_ = true;
+    this->scene_dirty_ = true;
+}
+
+void Visualizer::disable_shadows()
+{
+    this->shadows_enabled_ = false;
+    this->scene_dirty_ = true;
+}
+
+void Visualizer::set_light_direction(Vector3 direction)
+{
+    if (Vector3Length(direction) == 0.0f)
+    {
+        return;
+    }
+    this->light_direction_ = Vector3Normalize(direction);
+    this->shadow_map_.set_light_direction(this->light_direction_);
+    this->scene_lights_.set_main_light(this->light_direction_, WHITE);
+    this->scene_dirty_ = true;
+}
+
+int Visualizer::add_directional_light(Vector3 direction, Color color, float intensity)
+{
+    this->scene_dirty_ = true;
+    return this->scene_lights_.add_directional_light(direction, color, intensity);
+}
+
+int Visualizer::add_point_light(Vector3 position, Color color, float intensity, float range)
+{
+    this->scene_dirty_ = true;
+    return this->scene_lights_.add_point_light(position, color, intensity, range);
+}
+
+int Visualizer::add_spot_light(Vector3 position, Vector3 direction, Color color, float intensity, float range, float inner_angle, float outer_angle)
+{
+    this->scene_dirty_ = true;
+    return this->scene_lights_.add_spot_light(position, direction, color, intensity, range, inner_angle, outer_angle);
+}
+
+void Visualizer::update_light_pose(int handle, Vector3 position, Vector3 direction)
+{
+    this->scene_lights_.set_light_pose(handle, position, direction);
+    this->scene_dirty_ = true;
+}
+
+void Visualizer::update_light_color(int handle, Color color, float intensity)
+{
+    this->scene_lights_.set_light_color(handle, color, intensity);
+    this->scene_dirty_ = true;
+}
+
+void Visualizer::remove_light(int handle)
+{
+    this->scene_lights_.remove_light(handle);
+    this->scene_dirty_ = true;
+}
+
+void Visualizer::render_shadow_maps()
+{
+    if (!this->shadow_map_.is_loaded())
+    {
+        if (!this->shadow_map_.load(this->shadow_resolution_))
+        {
+            this->shadows_enabled_ = false;
+            return;
+        }
+        this->shadow_map_.set_light_direction(this->light_direction_);
+    }
+
+    // The casters are culled against the light frustum with the same hierarchy as the camera
+    this->refit_visual_object_bounds();
+    du::Frustum frustum = this->shadow_map_.get_frustum();
+    this->shadow_casters_.clear();
+    this->object_bvh_.query_frustum(frustum, this->shadow_casters_);
+
+    // Static objects and terrains are only drawn when one of them changed or the light moved
+    if (this->shadow_map_.needs_static_update())
+    {
+        this->shadow_map_.begin_static();
+        for (int handle : this->shadow_casters_)
+        {
+            const VisualObject &vis_object = **this->visual_objects_.get(handle);
+            if (vis_object.static_caster && !this->disabled_groups[vis_object.group_id])
+            {
+                this->shadow_map_.draw_caster(vis_object.model, vis_object.world_transform);
+            }
+        }
+        // The map is cached, so the terrains get a level of detail that does not depend on the camera: details
+        // smaller than a texel of the map do not change the shadow
+        for (const std::unique_ptr<Terrain> &terrain : this->terrains_)
+        {
+            int level = terrain->get_level_for_spacing(this->shadow_map_.get_texel_size());
+            terrain->draw_level(this->shadow_map_.get_depth_shader(), frustum, level);
+        }
+        this->shadow_map_.end_pass();
+    }
+
+    bool dynamic_casters = false;
+    for (int handle : this->shadow_casters_)
+    {
+        const VisualObject &vis_object = **this->visual_objects_.get(handle);
+        dynamic_casters = dynamic_casters || (!vis_object.static_caster && !this->disabled_groups[vis_object.group_id]);
+    }
+    if (this->shadow_map_.begin_dynamic(dynamic_casters))
+    {
+        for (int handle : this->shadow_casters_)
+        {
+            const VisualObject &vis_object = **this->visual_objects_.get(handle);
+            if (!vis_object.static_caster && !this->disabled_groups[vis_object.group_id])
+            {
+                this->shadow_map_.draw_caster(vis_object.model, vis_object.world_transform);
+            }
+        }
+        this->shadow_map_.end_pass();
+    }
+}
+
+void Visualizer::set_circle_segments(int segments)
+{
+    this->instanced_renderer_.set_circle_segments(segments);
+    this->scene_dirty_ = true;
+}
+
+bool Visualizer::is_headless() const
+{
+    return this->headless_;
+}
+
+void Visualizer::step_frames(int frames)
+{
+    for (int i = 0; i < frames; i++)
+    {
+        this->update();
     }
 }
+
+Image Visualizer::get_frame_image()
+{
+    // Render textures are stored upside down
+    Image image = LoadImageFromTexture(this->shader_target_.texture);
+    ImageFlipVertical(&image);
+    return image;
+}
+
+void Visualizer::set_camera(Vector3 position, Vector3 target, float fovy)
+{
+    this->camera_.position = position;
+    this->camera_.target = target;
+    this->camera_.fovy = fovy;
+    // Mark the focused object as already focused, otherwise set_camera_focus turns the focus mode back on
+    this->focus_mode_ = false;
+    this->previously_focused_object_index_ = this->focused_object_index_;
+}
+
+const Camera &Visualizer::get_camera() const
+{
+    return this->camera_;
+}
+
+FrameProfiler &Visualizer::get_profiler()
+{
+    return this->profiler_;
+}
+
+RenderStats Visualizer::get_render_stats() const
+{
+    return this->render_stats_;
+}
+
+bool Visualizer::start_capture(const std::string &path, CaptureFormat format, int fps)
+{
+    return this->capture_.start(path, format, this->shader_target_.texture.width, this->shader_target_.texture.height, fps);
+}
+
+void Visualizer::stop_capture()
+{
+    this->capture_.stop();
+}
+
+bool Visualizer::is_capturing() const
+{
+    return this->capture_.is_capturing();
+}
+
+CaptureStats Visualizer::get_capture_stats() const
+{
+    return this->capture_.get_stats();
+}
+
+void Visualizer::begin_recorded_frame()
+{
+    if (!this->recorder_.is_open())
+    {
+        return;
+    }
+    this->recorded_frame_ = &this->recorder_.begin_frame(GetTime());
+    this->recorded_frame_->objects.reserve(this->visual_objects_.size());
+    for (size_t i = 0; i < this->visual_objects_.size(); i++)
+    {
+        const VisualObject &vis_object = *this->visual_objects_.value_at(i);
+        this->recorded_frame_->objects.push_back(RecordedObject{this->visual_objects_.handle_at(i), vis_object.position,
+                                                                vis_object.orientation, vis_object.scale, vis_object.color});
+    }
+}
+
+void Visualizer::apply_playback_frame()
+{
+    size_t shown_frame = this->playback_frame_;
+    const SceneFrame *frame = this->player_.seek(shown_frame);
+    if (!this->playback_paused_ && this->playback_frame_ + 1 < this->player_.get_frame_count())
+    {
+        this->playback_frame_++;
+    }
+    if (frame == nullptr)
+    {
+        return;
+    }
+
+    // A paused playback shows the same frame, which is already applied
+    if (shown_frame == this->applied_playback_frame_)
+    {
+        return;
+    }
+    this->applied_playback_frame_ = shown_frame;
+    this->scene_dirty_ = true;
+
+    for (const RecordedObject &object : frame->objects)
+    {
+        VisualObject *vis_object = this->find_visual_object(object.handle);
+        if (vis_object == nullptr)
+        {
+            continue;
+        }
+        vis_object->set_pose(object.position, object.orientation, object.scale);
+        vis_object->color = object.color;
+    }
+}
+
+void Visualizer::queue_playback_primitives()
+{
+    if (this->applied_playback_frame_ == SIZE_MAX)
+    {
+        return;
+    }
+    const SceneFrame *frame = this->player_.seek(this->applied_playback_frame_);
+    if (frame == nullptr)
+    {
+        return;
+    }
+
+    for (const RecordedLine &line : frame->lines)
+    {
+        this->lines_.push(Line{line.start_pos, line.end_pos, line.color});
+    }
+    for (const RecordedArrow &arrow : frame->arrows)
+    {
+        this->arrows_.push(Arrow{arrow.origin, arrow.vector, arrow.radius, arrow.color});
+    }
+    for (const RecordedSegment &segment : frame->segments)
+    {
+        this->segments_.push(Segment{segment.start_pos, segment.end_pos, segment.scale, segment.color});
+    }
+    for (const RecordedLabel &label : frame->labels)
+    {
+        this->draw_text(label.text, label.position, label.font_size, label.background, label.color, GetFontDefault(), label.background_color);
+    }
+}
+
+void Visualizer::draw_playback_timeline()
+{
+    ImGui::Begin("Playback");
+    size_t frame_count = this->player_.get_frame_count();
+    if (ImGui::Button(this->playback_paused_ ? "Play" : "Pause"))
+    {
+        this->playback_paused_ = !this->playback_paused_;
+    }
+    ImGui::SameLine();
+    if (ImGui::Button("<") && this->playback_frame_ > 0)
+    {
+        this->playback_frame_--;
+    }
+    ImGui::SameLine();
+    if (ImGui::Button(">") && this->playback_frame_ + 1 < frame_count)
+    {
+        this->playback_frame_++;
+    }
+    ImGui::SameLine();
+    const SceneFrame *frame = this->player_.seek(this->player_.get_current_frame());
+    ImGui::Text("t = %.2f s", frame != nullptr ? frame->time : 0.0);
+
+    int timeline_frame = (int)this->playback_frame_;
+    if (ImGui::SliderInt("Frame", &timeline_frame, 0, std::max((int)frame_count - 1, 0)))
+    {
+        this->playback_frame_ = timeline_frame;
+    }
+    ImGui::End();
+}
+
+bool Visualizer::start_recording(const std::string &path, int keyframe_interval)
+{
+    return this->recorder_.open(path, keyframe_interval);
+}
+
+void Visualizer::stop_recording()
+{
+    this->recorder_.close();
+}
+
+bool Visualizer::is_recording() const
+{
+    return this->recorder_.is_open();
+}
+
+bool Visualizer::has_recording_failed() const
+{
+    return this->recorder_.has_failed();
+}
+
+bool Visualizer::open_playback(const std::string &path)
+{
+    this->playback_frame_ = 0;
+    this->applied_playback_frame_ = SIZE_MAX;
+    this->playback_paused_ = true;
+    return this->player_.open(path);
+}
+
+void Visualizer::close_playback()
+{
+    this->player_.close();
+    this->applied_playback_frame_ = SIZE_MAX;
+    this->scene_dirty_ = true;
+}
+
+bool Visualizer::is_playing_back() const
+{
+    return this->player_.is_open();
+}
+
+void Visualizer::seek_playback(size_t frame)
+{
+    this->playback_frame_ = frame;
+    this->scene_dirty_ = true;
+}
+
+void Visualizer::set_playback_paused(bool paused)
+{
+    this->playback_paused_ = paused;
+}
+
+size_t Visualizer::get_playback_frame_count() const
+{
+    return this->player_.get_frame_count();
+}
@@ -7,7 +7,6 @@
 #include "rlImGui.h"
 #include "imgui.h"
 #include "raymath.h"
-#include "rlights.hpp"
 #include "rlgl.h"
 #include <iostream>
 #include <functional>
@@ -16,6 +15,22 @@
 #include <memory>
 
 #include "DrawingUtils.hpp"
+#include "InstancedRenderer.hpp"
+#include "ModelCache.hpp"
+#include "TripleBuffer.hpp"
+#include "SlotMap.hpp"
+#include "DynamicBvh.hpp"
+#include "TriangleBvh.hpp"
+#include "FrameProfiler.hpp"
+#include "FrameCapture.hpp"
+#include "SceneRecording.hpp"
+#include "LineSet.hpp"
+#include "TrailRenderer.hpp"
+#include "PointCloud.hpp"
+#include "Terrain.hpp"
+#include "LabelRenderer.hpp"
+#include "ShadowMap.hpp"
+#include "SceneLights.hpp"
 #define GLSL_VERSION 330
 
 /**
@@ -28,6 +43,45 @@ struct VisualObject
     Model model;            // Model associated with the visual object.
     Color color;            // Color of the visual object.
     int group_id = 0;       // Group ID to which the visual object belongs.
+    Vector3 scale = {1.0f, 1.0f, 1.0f}; // Scale applied on top of the model transform.
+    std::string model_key = "";          // Key of the model in the model cache (empty if the object owns its model).
+    BoundingBox local_bounds = {{0.0f, 0.0f, 0.0f}, {0.0f, 0.0f, 0.0f}}; // Bounds of the model meshes (set when the object is added).
+    bool transform_dirty = true;         // Flag indicating whether the pose or scale changed since the world transform and bounds were updated.
+    Matrix world_transform = MatrixIdentity(); // Cached transform from mesh space to world space (see get_transform).
+    int bvh_proxy = DynamicBvh::NULL_NODE; // Proxy of the object in the culling hierarchy.
+    std::shared_ptr<const std::vector<TriangleBvh>> mesh_bvhs; // Triangle hierarchies of the model meshes (built on the first raycast).
+    bool edge_overlay = true;            // Flag indicating whether the triangle edges are drawn on top of the object.
+    float bounding_radius = 0.0f;        // Radius of a sphere enclosing the world bounds (updated with the world transform).
+    std::vector<std::string> lod_keys;   // Model cache keys of the tessellation levels, coarsest first (empty if the model has a single level).
+    std::vector<Mesh *> lod_meshes;      // Meshes of the tessellation levels (owned by the model cache).
+    int lod_level = -1;                  // Tessellation level drawn (-1 if the model has a single level).
+    bool static_caster = false;          // Flag indicating whether the shadow of the object is cached (see set_visual_object_static).
+
+    /**
+     * @brief Sets the pose and scale, marking the world transform dirty only if one of them changed.
+     */
+    void set_pose(Vector3 new_position, Quaternion new_orientation, Vector3 new_scale)
+    {
+        if (new_position.x != position.x || new_position.y != position.y || new_position.z != position.z ||
+            new_orientation.x != orientation.x || new_orientation.y != orientation.y ||
+            new_orientation.z != orientation.z || new_orientation.w != orientation.w ||
+            new_scale.x != scale.x || new_scale.y != scale.y || new_scale.z != scale.z)
+        {
+            position = new_position;
+            orientation = new_orientation;
+            scale = new_scale;
+            transform_dirty = true;
+        }
+    }
+
+    /**
+     * @brief Computes the transform from mesh space to world space (model transform, scale and pose).
+     */
+    Matrix get_transform() const
+    {
+        return MatrixMultiply(MatrixMultiply(model.transform, MatrixScale(scale.x, scale.y, scale.z)),
+                              du::get_transform(position, orientation));
+    }
 };
 
 /**
@@ -128,6 +182,56 @@ struct TextLabel
     bool enabled = true;           // Flag indicating whether the label is enabled.
 };
 
+/**
+ * @brief Point of a visual object followed by a trail.
+ */
+struct TrailSource
+{
+    int object_handle; // Handle of the visual object.
+    Vector3 offset;    // Point followed, in the frame of the object (e.g. the tip of an end effector).
+};
+
+/**
+ * @brief Full set of poses published by a simulation thread for one frame.
+ */
+struct PoseFrame
+{
+    std::vector<int> handles;              // Handles of the visual objects to be updated.
+    std::vector<Vector3> positions;        // New positions of the visual objects.
+    std::vector<Quaternion> orientations;  // New orientations of the visual objects.
+
+    /**
+     * @brief Removes all the poses (keeps the allocated memory).
+     */
+    void clear()
+    {
+        handles.clear();
+        positions.clear();
+        orientations.clear();
+    }
+
+    /**
+     * @brief Adds the pose of a visual object to the frame.
+     */
+    void push(int handle, Vector3 position, Quaternion orientation)
+    {
+        handles.push_back(handle);
+        positions.push_back(position);
+        orientations.push_back(orientation);
+    }
+};
+
+/**
+ * @brief Number of visual objects drawn and culled in the last rendered frame.
+ */
+struct RenderStats
+{
+    size_t drawn_objects = 0;   // Visual objects submitted for drawing.
+    size_t culled_objects = 0;  // Visual objects skipped because they were outside the camera frustum.
+    bool scene_rendered = true; // Flag indicating whether the scene was rendered in the last frame (see set_render_on_demand).
+    size_t skipped_frames = 0;  // Frames that reused the previously rendered scene.
+};
+
 /**
  * @brief Manages the visualization of 3D objects, camera, lighting, and shaders.
  */
@@ -137,29 +241,63 @@ private:
     const int screen_width_;                // Screen width for visualization.
     const int screen_height_;               // Screen height for visualization.
     const char *title_;                     // Title of the visualization window.
+    const bool headless_;                   // Flag indicating whether the visualizer renders without a window.
     Camera camera_;                         // Camera for viewing the scene.
-    Camera shadow_map_camera;               // Camera for viewing the scene.
     std::map<std::string, Shader> shaders_; // Shaders for rendering
-    RenderTexture2D shadow_texture;         // Texture for shadows (NOT IMPLMENETED YET)
 
     bool shader_loaded_ = false;                                // Flag indicating whether the shader is loaded.
-    std::vector<std::shared_ptr<VisualObject>> visual_objects_; // List of visual objects in the scene.
+    SlotMap<std::shared_ptr<VisualObject>> visual_objects_;     // Visual objects in the scene, referenced by generational handles.
     std::vector<bool> disabled_groups = std::vector<bool>(10);  // List of group ids of objects that will not be rendered this frame.
+    std::vector<bool> edge_overlay_disabled_groups_ = std::vector<bool>(10); // List of group ids of objects drawn without the edge overlay.
     std::queue<VisSphere> spheres_;                             // Buffer of points in the scene.
     std::queue<Line> lines_;                                    // Buffer of lines to be drawn.
+    LineSet frame_lines_;                                       // Lines and polylines of the current frame, drawn with one call.
+    SlotMap<std::unique_ptr<LineSet>> line_sets_;               // Retained line sets, drawn every frame until removed.
     std::queue<Arrow> arrows_;                                  // Buffer of arrows to be drawn.
     std::queue<Segment> segments_;                              // Buffer for line segments to be drawn in the current frame
     std::queue<Disc> discs_;                                    // Buffer for discs to be drawn in the current frame
     std::queue<TextLabel> text_labels_buffer_;                  // Buffer for text labels to be drawn.
     std::queue<AxisAlignedBoundingBox> aabb_buffer_;            // Buffer for AABB  to be drawn.
     std::queue<RingSection> ring_sections_;                     // Buffer for Ring Sections to be drawn.
+    InstancedRenderer instanced_renderer_;                      // Batches arrows, segments, spheres and discs into instanced draw calls.
+    SlotMap<std::shared_ptr<PointCloud>> point_clouds_;        // Point clouds, shared with the threads writing them.
+    SlotMap<std::unique_ptr<Terrain>> terrains_;                // Tiled terrains (drawn with per tile culling and level of detail).
+    TrailRenderer trail_renderer_;                              // Ring buffers of the trajectory trails, drawn with one call.
+    std::map<int, TrailSource> trail_sources_;                  // Point followed by every trail, by trail handle.
+    ModelCache model_cache_;                                    // Primitive meshes and mesh files shared between visual objects.
+    TripleBuffer<PoseFrame> published_poses_;                   // Pose frames published by a simulation thread.
+    DynamicBvh object_bvh_;                                     // World bounds of the visual objects, used for frustum culling.
+    std::vector<int> visible_objects_;                          // Handles of the visual objects inside the frustum (reused every frame).
+    bool frustum_culling_ = true;                               // Flag indicating whether objects outside the camera frustum are skipped.
+    bool primitive_lod_ = true;                                 // Flag indicating whether the tessellation of the primitives follows their screen size.
+    bool render_on_demand_ = false;                             // Flag indicating whether the scene is only rendered when it changed.
+    bool scene_dirty_ = true;                                   // Flag indicating whether the scene changed since it was last rendered.
+    Camera rendered_camera_ = {};                               // Camera of the last rendered frame.
+    bool rendered_frame_primitives_ = false;                    // Flag indicating whether the last rendered frame had per-frame primitives or labels.
+    uint64_t rendered_retained_changes_ = 0;                    // Sum of the change counts of the line sets and point clouds in the last rendered frame.
+    bool gui_active_ = false;                                   // Flag indicating whether a GUI widget was active in the last frame.
+    ShadowMap shadow_map_;                                      // Shadow maps of the directional light (loaded when shadows are first enabled).
+    bool shadows_enabled_ = false;                              // Flag indicating whether the lit objects receive shadows.
+    int shadow_resolution_ = 2048;                              // Resolution of the shadow maps.
+    Vector3 light_direction_ = {0.0f, -1.0f, 0.0f};             // Direction of the rays of the directional light.
+    std::vector<int> shadow_casters_;                           // Handles of the visual objects inside the light frustum (reused every frame).
+    RenderStats render_stats_;                                  // Drawn and culled objects in the last frame.
+    FrameProfiler profiler_;                                    // CPU and GPU timings of the frame stages (disabled by default).
+    FrameCapture capture_;                                      // Records the rendered frames to disk (asynchronous readback and encoding).
+    SceneRecorder recorder_;                                    // Records the scene state of every frame (see start_recording).
+    SceneFrame *recorded_frame_ = nullptr;                      // Frame being recorded by the current update (null when not recording).
+    ScenePlayer player_;                                        // Plays back a scene recording instead of the published poses (see open_playback).
+    size_t playback_frame_ = 0;                                 // Frame of the recording shown by the next update.
+    size_t applied_playback_frame_ = SIZE_MAX;                  // Frame of the recording last applied to the visual objects (SIZE_MAX if none).
+    bool playback_paused_ = true;                               // Flag indicating whether the playback stays on the same frame.
     std::map<int, TextLabel> text_labels_;                      // Map of text labels with their indices.
+    LabelRenderer label_renderer_;                              // Culls, lays out (cached) and batches the text labels of the frame.
     bool wireframe_mode_;                                       // Flag indicating whether to render in wireframe mode.
-    int focused_object_index_;                                  // Index of the focused visual object.
-    int previously_focused_object_index_ = -2;                  // Index of the previously focused visual object.
+    int focused_object_index_;                                  // Handle of the focused visual object.
+    int previously_focused_object_index_ = -2;                  // Handle of the previously focused visual object.
     bool focus_mode_ = false;                                   // Flag indicating whether the focus mode is enabled.
     RenderTexture2D shader_target_;                             // Render target for shaders.
-    Light light_;                                               // Lighting setup for the scene.
+    SceneLights scene_lights_;                                  // Main directional light and additional lights of the lighting shaders.
     bool show_bodies_coordinate_frame_ = false;                 // Flag indicating whether to show coordinate frames for bodies.
 
     // Function to define ImGui interfaces; initialized as a no-op.
@@ -169,14 +307,83 @@ private:
     float camera_speed_ = 0.3;
     float axes_size = 1.0;
 
+    /**
+     * @brief Gets a visual object from its handle.
+     * @return Pointer to the visual object, or nullptr if the handle is not valid (anymore).
+     */
+    VisualObject *find_visual_object(int handle);
+
+    /**
+     * @brief Releases the model of a visual object (unloads it if owned, otherwise drops its model cache reference).
+     */
+    void release_visual_object_model(const VisualObject &vis_object);
+
+    /**
+     * @brief Updates the cached world transforms and the culling hierarchy bounds of the objects whose pose or scale changed.
+     */
+    void refit_visual_object_bounds();
+
+    /**
+     * @brief Acquires every tessellation level of a curved primitive and stores their keys and meshes in the visual object.
+     * @return Model of the default level (its materials are used by all the levels).
+     */
+    Model acquire_primitive_lods(PrimitiveShape shape, VisualObject &vis_object);
+
+    /**
+     * @brief Selects the tessellation level of a primitive from its projected radius in pixels.
+     * A level only changes once the radius moves past its threshold by the hysteresis band, so objects
+     * close to a threshold do not alternate between two levels.
+     * @param vis_object Visual object with tessellation levels.
+     * @param pixels_per_unit Pixels covered by one world unit at a distance of one unit (or at any distance for orthographic cameras).
+     * @param perspective Flag indicating whether the projected size shrinks with the distance.
+     */
+    void select_primitive_lod(VisualObject &vis_object, float pixels_per_unit, bool perspective);
+
+    /**
+     * @brief Checks whether the scene has to be rendered this frame (always true unless render on demand is enabled).
+     */
+    bool needs_scene_render();
+
+    /**
+     * @brief Renders the shadow maps, the scene and the text labels into the render target.
+     */
+    void render_scene();
+
+    /**
+     * @brief Adds the current position of the point followed by every trail to the trail.
+     */
+    void sample_trails();
+
+    /**
+     * @brief Starts recording the frame: stores the state of every visual object (the primitives are added while they are drawn).
+     */
+    void begin_recorded_frame();
+
+    /**
+     * @brief Applies the current frame of the playback to the visual objects (only when the frame changed).
+     */
+    void apply_playback_frame();
+
+    /**
+     * @brief Queues the primitives and labels of the last applied playback frame (only for the rendered frames,
+     * as a paused playback keeps the last rendered scene).
+     */
+    void queue_playback_primitives();
+
+    /**
+     * @brief Draws the playback timeline window with ImGui.
+     */
+    void draw_playback_timeline();
+
 public:
     /**
      * @brief Constructor for the Visualizer class.
      * @param screen_width The width of the visualization window.
      * @param screen_height The height of the visualization window.
      * @param title Title of the visualization window.
+     * @param headless Render without a visible window (e.g. on servers or CI), see is_headless.
      */
-    Visualizer(int screen_width, int screen_height, const char *title);
+    Visualizer(int screen_width, int screen_height, const char *title, bool headless = false);
 
     /**
      * @brief Destructor for the Visualizer class.
@@ -184,15 +391,49 @@ public:
     ~Visualizer();
 
     /**
-     * @brief Unloads the models
+     * @brief Unloads the models (shared models are unloaded when their last visual object is gone)
      */
     void unload_models(void);
 
     /**
      * @brief Updates the visualizer, including camera and shader updates.
+     * In headless mode it renders one frame into the render texture (no input, GUI or presentation).
      */
     void update();
 
+    /**
+     * @brief Returns true if the visualizer renders without a window.
+     * Headless visualizers use the GLFW null platform (software OSMesa context, no display needed) when
+     * GLFW 3.4 or newer is available, or a hidden window otherwise. They do not poll input, skip ImGui
+     * and do not limit the frame rate, so frames are produced as fast as update (or step_frames) is called.
+     */
+    bool is_headless() const;
+
+    /**
+     * @brief Renders a number of frames (calls update for each of them).
+     * @param frames Number of frames to render.
+     */
+    void step_frames(int frames = 1);
+
+    /**
+     * @brief Reads back the last rendered frame.
+     * @return Image with the contents of the scene render texture (must be unloaded with UnloadImage).
+     */
+    Image get_frame_image();
+
+    /**
+     * @brief Places the camera (disables the focus mode).
+     * @param position Position of the camera.
+     * @param target Point the camera looks at.
+     * @param fovy Vertical field of view in degrees.
+     */
+    void set_camera(Vector3 position, Vector3 target, float fovy = 45.0f);
+
+    /**
+     * @brief Gets the camera used to render the scene.
+     */
+    const Camera &get_camera() const;
+
     /**
      * @brief Draws the graphical user interface (GUI) for the visualizer.
      */
@@ -238,12 +479,12 @@ public:
     /**
      * @brief draws a visual object
      */
-    void render_visual_object(std::shared_ptr<VisualObject> vis_object);
+    void render_visual_object(const std::shared_ptr<VisualObject> &vis_object);
 
-    // /**
-    //  * @brief Rednders the visual objects shadows (NOT IMPLEMENTED)
-    //  */
-    // void render_visual_object_shadow(const VisualObject &vis_object);
+    /**
+     * @brief Draws the shadow casters into the shadow maps (the static map only when it was invalidated).
+     */
+    void render_shadow_maps();
 
     // Shader (Not in use)
     /**
@@ -257,42 +498,76 @@ public:
     /**
      * @brief Adds a visual object to the scene.
      * @param vis_object The visual object to be added.
-     * @return The index of the added visual object.
+     * @return The handle of the added visual object, or -1 (with the model released) if no slot is left. Handles stay
+     * valid until the object is removed, and functions called with the handle of a removed object have no effect
+     * (a slot's generation wraps after 2048 reuses, so a handle kept that long may resolve again).
      */
     int add_visual_object(std::shared_ptr<VisualObject> vis_object);
 
     /**
      * @brief Updates the position, orientation, and scale of a visual object.
-     * @param index Index of the visual object to be updated.
+     * @param handle Handle of the visual object to be updated.
      * @param position New position of the visual object.
      * @param orientation New orientation of the visual object.
-     * @param scale New scale of the visual object.
+     * @param scale New scale of the visual object (relative to the size it was created with).
      */
-    void update_visual_object_position_orientation_scale(int index, Vector3 position, Quaternion orientation, Vector3 scale);
+    void update_visual_object_position_orientation_scale(int handle, Vector3 position, Quaternion orientation, Vector3 scale);
 
     /**
      * @brief Updates the position and orientation of a visual object.
-     * @param index Index of the visual object to be updated.
+     * @param handle Handle of the visual object to be updated.
      * @param position New position of the visual object.
      * @param orientation New orientation of the visual object.
      */
-    void update_visual_object_position_orientation(int index, Vector3 position, Quaternion orientation);
+    void update_visual_object_position_orientation(int handle, Vector3 position, Quaternion orientation);
 
     /**
      * @brief Updates the scale of a visual object.
-     * @param index Index of the visual object to be updated.
-     * @param scale New scale of the visual object.
+     * @param handle Handle of the visual object to be updated.
+     * @param scale New scale of the visual object (relative to the size it was created with).
+     */
+    void update_visual_object_scale(int handle, Vector3 scale);
+
+    /**
+     * @brief Updates the poses (and optionally the scales) of many visual objects in one pass.
+     * The arrays are read contiguously, so they can come straight from numpy or Eigen buffers
+     * (Vector3 and Quaternion have the layout of 3 and 4 packed floats).
+     * @param handles Handles of the visual objects to be updated, or nullptr to update the handles 0 to count - 1
+     * (the first count objects added to the scene, as long as no object has been removed).
+     * @param positions New positions of the visual objects (count elements).
+     * @param orientations New orientations of the visual objects (count elements).
+     * @param count Number of visual objects to be updated.
+     * @param scales New scales of the visual objects (count elements), or nullptr to keep the current scales.
+     */
+    void update_visual_objects_poses(const int *handles, const Vector3 *positions, const Quaternion *orientations, size_t count, const Vector3 *scales = nullptr);
+
+    /**
+     * @brief Gets the pose frame to be filled by the simulation thread (the frame is cleared).
+     * The frame can be written from any single producer thread without blocking the render thread.
+     * Visual objects must not be added or removed while their poses are being published.
+     * @return Reference to the frame, valid until publish_pose_frame is called.
+     */
+    PoseFrame &begin_pose_frame();
+
+    /**
+     * @brief Publishes the frame returned by begin_pose_frame. The render thread applies the
+     * latest published frame at the start of the next update (older unread frames are skipped).
      */
-    void update_visual_object_scale(int index, Vector3 scale);
+    void publish_pose_frame();
 
     /**
-     * @brief Removes a visual object from the scene.
-     * @param index Index of the visual object to be removed.
+     * @brief Applies the latest published pose frame (if there is a new one). Called by update.
      */
-    void remove_visual_object(int index);
+    void apply_published_poses();
 
     /**
-     * @brief Clears all visual objects from the scene.
+     * @brief Removes a visual object from the scene and releases its model (O(1), other handles are not affected).
+     * @param handle Handle of the visual object to be removed.
+     */
+    void remove_visual_object(int handle);
+
+    /**
+     * @brief Clears all visual objects from the scene and releases their models.
      */
     void clear_visual_objects();
 
@@ -305,7 +580,7 @@ public:
      * @param height Height of the cube.
      * @param length Length of the cube.
      * @param group_id Id of the visual shape group of the object
-     * @return The index of the added cube.
+     * @return The handle of the added cube.
      */
     int add_box(Vector3 position, Quaternion orientation, Color color, float width, float height, float length, int group_id = 0);
 
@@ -316,7 +591,7 @@ public:
      * @param color Color of the sphere.
      * @param radius Radius of the sphere.
      * @param group_id Id of the visual shape group of the object
-     * @return The index of the added sphere.
+     * @return The handle of the added sphere.
      */
     int add_sphere(Vector3 position, Quaternion orientation, Color color, float radius, int group_id = 0);
 
@@ -328,7 +603,7 @@ public:
      * @param radius Radius of the cylinder.
      * @param height Height of the cylinder.
      * @param group_id Id of the visual shape group of the object
-     * @return The index of the added cylinder.
+     * @return The handle of the added cylinder.
      */
     int add_cylinder(Vector3 position, Quaternion orientation, Color color, float radius, float height, int group_id = 0);
 
@@ -340,7 +615,7 @@ public:
      * @param radius Radius of the capsule.
      * @param height Height of the capsule.
      * @param group_id Id of the visual shape group of the object
-     * @return The index of the added capsule.
+     * @return The handle of the added capsule.
      */
     int add_capsule(Vector3 position, Quaternion orientation, Color color, float radius, float height, int group_id = 0);
 
@@ -352,7 +627,7 @@ public:
      * @param radius Radius of the cone.
      * @param height Height of the cone.
      * @param group_id Id of the visual shape group of the object
-     * @return The index of the added cone.
+     * @return The handle of the added cone.
      */
     int add_cone(Vector3 position, Quaternion orientation, Color color, float radius, float height, int group_id = 0);
 
@@ -364,7 +639,7 @@ public:
      * @param width Width of the plane.
      * @param length Length of the plane.
      * @param group_id Id of the visual shape group of the object
-     * @return The index of the added plane.
+     * @return The handle of the added plane.
      */
     int add_plane(Vector3 position, Quaternion orientation, Color color, float width, float length, int group_id = 0);
 
@@ -372,19 +647,19 @@ public:
     // int add_heightmap(Vector3 position, Quaternion orientation, Color color, std::vector<std::vector<float>> heightmap);
 
     /**
-     * @brief Adds a mesh to the scene.
+     * @brief Adds a mesh to the scene. Meshes loaded from the same file are shared between visual objects.
      * @param filename Path to the mesh file.
      * @param position Position of the mesh.
      * @param orientation Orientation of the mesh.
      * @param color Color of the mesh.
      * @param scale Scale of the mesh.
      * @param group_id Id of the visual shape group of the object
-     * @return The index of the added mesh.
+     * @return The handle of the added mesh.
      */
     int add_mesh(const char *filename, Vector3 position, Quaternion orientation, Color color, float scale, int group_id = 0);
 
     /**
-     * @brief Adds a mesh to the scene.
+     * @brief Adds a mesh to the scene. Meshes loaded from the same file are shared between visual objects.
      * @param filename Path to the mesh file.
      * @param position Position of the mesh.
      * @param orientation Orientation of the mesh.
@@ -393,13 +668,13 @@ public:
      * @param scale_y Scale of the mesh in the y direction.
      * @param scale_z Scale of the mesh in the z direction.
      * @param group_id Id of the visual shape group of the object
-     * @return The index of the added mesh.
+     * @return The handle of the added mesh.
      */
     int add_mesh(const char *filename, Vector3 position, Quaternion orientation, Color color, float scale_x, float scale_y, float scale_z, int group_id = 0);
 
     /**
-     * @brief Adds a mesh to the scene.
-     * @return The index of the added heightmap.
+     * @brief Adds a heightmap built as a single mesh (see add_terrain for large or changing heightmaps).
+     * @return The handle of the added heightmap.
      */
     int add_heightmap(Vector3 position,
                       Quaternion orientation,
@@ -421,6 +696,116 @@ public:
      */
     void draw_line(Vector3 start_pos, Vector3 end_pos, Color color = WHITE);
 
+    /**
+     * @brief Draws a polyline for one frame (all the lines and polylines of a frame are drawn with a single call).
+     * @param points Points of the polyline.
+     * @param count Number of points.
+     * @param color Color of the polyline.
+     * @param closed Flag indicating whether the last point is connected to the first.
+     */
+    void draw_polyline(const Vector3 *points, size_t count, Color color = WHITE, bool closed = false);
+
+    /**
+     * @brief Adds a retained line set, drawn every frame with one draw call until it is removed.
+     * Fill it through get_line_set: its GPU buffers are only updated when it changes, which makes it
+     * suited for large static or semi-static line sets (graphs, skeletons, paths).
+     * @return Handle of the line set.
+     */
+    int add_line_set();
+
+    /**
+     * @brief Gets a line set from its handle.
+     * @return Pointer to the line set, or nullptr if the handle is not valid (anymore).
+     */
+    LineSet *get_line_set(int handle);
+
+    /**
+     * @brief Removes a line set and releases its GPU buffers.
+     */
+    void remove_line_set(int handle);
+
+    /**
+     * @brief Adds a terrain split into tiles. Unlike add_heightmap, changing part of the heights only
+     * rebuilds the tiles it touches, and the tiles use fewer vertices the further they are from the camera.
+     * @param position Position of the center of the terrain.
+     * @param orientation Orientation of the terrain.
+     * @param color Color of the terrain.
+     * @param width Number of vertices along x.
+     * @param depth Number of vertices along z.
+     * @param heights Heights of the vertices, row major (width * depth values, empty for a flat terrain).
+     * @param x_scale Distance between the vertices along x.
+     * @param y_scale Factor applied to the heights.
+     * @param z_scale Distance between the vertices along z.
+     * @param tile_cells Cells along each side of a tile.
+     * @return Handle of the terrain.
+     */
+    int add_terrain(Vector3 position, Quaternion orientation, Color color, size_t width, size_t depth, const std::vector<float> &heights,
+                    float x_scale = 1.0f, float y_scale = 1.0f, float z_scale = 1.0f, size_t tile_cells = 64);
+
+    /**
+     * @brief Replaces the heights of a rectangle of vertices of a terrain (see Terrain::set_heights).
+     * @param handle Handle of the terrain.
+     * @param x First column of the rectangle.
+     * @param z First row of the rectangle.
+     * @param width Number of columns of the rectangle.
+     * @param depth Number of rows of the rectangle.
+     * @param heights New heights, row major (width * depth values).
+     */
+    void update_terrain_heights(int handle, size_t x, size_t z, size_t width, size_t depth, const float *heights);
+
+    /**
+     * @brief Gets a terrain from its handle.
+     * Height changes made through the pointer do not redraw the cached shadows, use update_terrain_heights for them.
+     * @return Pointer to the terrain, or nullptr if the handle is not valid (anymore).
+     */
+    Terrain *get_terrain(int handle);
+
+    /**
+     * @brief Removes a terrain and releases its GPU resources.
+     */
+    void remove_terrain(int handle);
+
+    /**
+     * @brief Adds a point cloud backed by GPU buffers (drawn with one call whatever its size).
+     * @param count Initial number of points (see PointCloud::resize).
+     * @return Handle of the point cloud.
+     */
+    int add_point_cloud(size_t count = 0);
+
+    /**
+     * @brief Gets a point cloud from its handle. The points can be written from any thread (e.g. a sensor
+     * callback): only the modified ranges are uploaded when the cloud is drawn.
+     * @return Shared pointer to the point cloud, or nullptr if the handle is not valid (anymore).
+     */
+    std::shared_ptr<PointCloud> get_point_cloud(int handle);
+
+    /**
+     * @brief Removes a point cloud and releases its GPU buffers.
+     */
+    void remove_point_cloud(int handle);
+
+    /**
+     * @brief Adds a trail following a point of a visual object: one sample is taken on every update and
+     * stored in a fixed-capacity ring buffer, so the cost per frame does not grow with the trail length.
+     * @param object_handle Handle of the visual object.
+     * @param color Color of the trail.
+     * @param duration Age in seconds at which the samples are fully faded out (0 to disable the fade).
+     * @param capacity Number of samples kept (the oldest are overwritten).
+     * @param offset Point followed, in the frame of the object.
+     * @return Handle of the trail. The trail stops growing (but keeps fading) when the object is removed.
+     */
+    int add_trail(int object_handle, Color color = YELLOW, float duration = 5.0f, size_t capacity = 1024, Vector3 offset = {0.0f, 0.0f, 0.0f});
+
+    /**
+     * @brief Removes a trail.
+     */
+    void remove_trail(int trail_handle);
+
+    /**
+     * @brief Removes the samples of a trail (it starts again from the current position).
+     */
+    void clear_trail(int trail_handle);
+
     /**
      * @brief Draws an arrow from a specified origin with a given vector.
      *
@@ -445,11 +830,20 @@ public:
     void draw_text(std::string text, Vector3 position, float font_size = 500.0, bool background = true, Color color = WHITE, Font font = GetFontDefault(), Color background_color = BLACK);
 
     /**
-     * @brief Draws a text label using specified parameters.
+     * @brief Draws a text label immediately using specified parameters (update draws the labels in one batched pass).
      *
      * @param label The text label to be drawn.
      */
-    void draw_text_label(TextLabel label);
+    void draw_text_label(const TextLabel &label);
+
+    /**
+     * @brief Loads a signed distance field font used instead of the default font for the text labels,
+     * so they stay sharp at any size.
+     * @param path Path to a TTF/OTF font file.
+     * @param base_size Size at which the distance field is generated.
+     * @return True if the font was loaded.
+     */
+    bool load_label_sdf_font(const char *path, int base_size = 48);
 
     /**
      * @brief Draws an axis aligned bounding box.
@@ -550,10 +944,20 @@ public:
      */
     void clear_gui_interfaces(void);
 
+    /**
+     * @brief Casts a ray against the meshes of the visual objects.
+     * Objects are found through the culling hierarchy and their meshes are tested with per mesh triangle hierarchies
+     * (built once per unique mesh), so the cost grows with the log of the number of objects and triangles.
+     * @param ray Ray in world space (normalized direction).
+     * @param collision Output nearest collision (optional).
+     * @return The handle of the nearest hit visual object, or -1 if the ray hits nothing.
+     */
+    int raycast_visual_objects(const Ray &ray, RayCollision *collision = nullptr);
+
     /**
      * @brief Allows the user to select a visual object with the mouse by double clicking it.
      *
-     * @return The index of the selected visual object.
+     * @return The handle of the selected visual object.
      */
     int select_visual_object();
 
@@ -570,4 +974,224 @@ public:
      * @return The index of the selected visual object.
      */
     void disable_visual_object_group_rendering(int group_id);
+
+    /**
+     * @brief Enables or disables the triangle edges drawn on top of a visual object (outside wireframe mode).
+     * The edges are drawn in the same pass as the object for models created by the visualizer.
+     * @param handle Handle of the visual object.
+     * @param enabled True to draw the edges.
+     */
+    void set_visual_object_edge_overlay(int handle, bool enabled);
+
+    /**
+     * @brief Marks a visual object as static for the shadows. The shadows of static objects are drawn into a cached
+     * shadow map, redrawn only when one of them moves, so objects that rarely move should be marked static.
+     * Objects are dynamic by default.
+     * @param handle Handle of the visual object.
+     * @param is_static True if the object rarely moves.
+     */
+    void set_visual_object_static(int handle, bool is_static);
+
+    /**
+     * @brief Enables or disables the triangle edges drawn on top of the visual objects of a group
+     * (e.g. to draw large environment meshes without them).
+     * @param group_id Id of the visual shape group.
+     * @param enabled True to draw the edges (objects with their overlay disabled individually stay disabled).
+     */
+    void set_group_edge_overlay(int group_id, bool enabled);
+
+    /**
+     * @brief Enables or disables the culling of visual objects outside the camera frustum.
+     */
+    void set_frustum_culling(bool enabled);
+
+    /**
+     * @brief Enables or disables the screen size level of detail of spheres, cylinders and cones.
+     * When disabled they are drawn with 16 slices.
+     */
+    void set_primitive_lod(bool enabled);
+
+    /**
+     * @brief Enables or disables render on demand: the scene is only rendered again when it changed (poses, queued
+     * primitives, camera, window size, GUI, ...), otherwise the last rendered scene is shown under the GUI.
+     * Changes that can not be tracked (e.g. a model modified directly) need a call to request_redraw.
+     */
+    void set_render_on_demand(bool enabled);
+
+    /**
+     * @brief Forces the scene to be rendered on the next update (when render on demand is enabled).
+     */
+    void request_redraw();
+
+    /**
+     * @brief Enables the shadows of the directional light on the lit objects and terrains (requires load_shader).
+     * The shadow maps cover a fixed square region, so the cached map of the static objects stays valid while the camera moves.
+     * @param resolution Width and height of the shadow maps in texels.
+     * @param extent Half size of the shadowed region.
+     * @param center Center of the shadowed region.
+     */
+    void enable_shadows(int resolution = 2048, float extent = 25.0f, Vector3 center = {0.0f, 0.0f, 0.0f});
+
+    /**
+     * @brief Disables the shadows (the shadow maps stay loaded until the visualizer is closed).
+     */
+    void disable_shadows();
+
+    /**
+     * @brief Sets the direction of the rays of the main directional light (straight down by default).
+     */
+    void set_light_direction(Vector3 direction);
+
+    /**
+     * @brief Adds a directional light (without shadows) to the lit objects.
+     * @param direction Direction of the rays.
+     * @param color Color of the light.
+     * @param intensity Factor applied to the color.
+     * @return Handle of the light, or -1 if the scene already has SceneLights::MAX_LIGHTS additional lights.
+     */
+    int add_directional_light(Vector3 direction, Color color, float intensity = 1.0f);
+
+    /**
+     * @brief Adds a point light to the lit objects.
+     * @param position Position of the light.
+     * @param color Color of the light.
+     * @param intensity Factor applied to the color (the light decreases with the square of the distance).
+     * @param range Distance at which the light fades out completely. Smaller ranges make the light cheaper.
+     * @return Handle of the light, or -1 if the scene already has SceneLights::MAX_LIGHTS additional lights.
+     */
+    int add_point_light(Vector3 position, Color color, float intensity = 10.0f, float range = 10.0f);
+
+    /**
+     * @brief Adds a spot light to the lit objects.
+     * @param position Position of the light.
+     * @param direction Axis of the cone of light.
+     * @param color Color of the light.
+     * @param intensity Factor applied to the color (the light decreases with the square of the distance).
+     * @param range Distance at which the light fades out completely.
+     * @param inner_angle Half angle of the cone of full intensity, in degrees.
+     * @param outer_angle Half angle of the cone of light, in degrees.
+     * @return Handle of the light, or -1 if the scene already has SceneLights::MAX_LIGHTS additional lights.
+     */
+    int add_spot_light(Vector3 position, Vector3 direction, Color color, float intensity = 10.0f, float range = 10.0f,
+                       float inner_angle = 20.0f, float outer_angle = 30.0f);
+
+    /**
+     * @brief Moves an additional light.
+     * @param handle Handle of the light.
+     * @param position New position (ignored by directional lights).
+     * @param direction New direction (ignored by point lights).
+     */
+    void update_light_pose(int handle, Vector3 position, Vector3 direction);
+
+    /**
+     * @brief Changes the color and intensity of an additional light.
+     */
+    void update_light_color(int handle, Color color, float intensity);
+
+    /**
+     * @brief Removes an additional light.
+     */
+    void remove_light(int handle);
+
+    /**
+     * @brief Sets the number of segments used to tessellate discs and ring sections (32 by default, up to 256).
+     */
+    void set_circle_segments(int segments);
+
+    /**
+     * @brief Gets the number of visual objects drawn and culled in the last frame.
+     */
+    RenderStats get_render_stats() const;
+
+    /**
+     * @brief Gets the frame profiler. Enable it with set_enabled(true) to record the CPU time of every
+     * stage of update() and the GPU time of the 3D and GUI passes, then read the statistics with get_stats.
+     */
+    FrameProfiler &get_profiler();
+
+    /**
+     * @brief Starts recording every rendered frame (the scene render texture, without the GUI).
+     * Frames are read back asynchronously and written by a background thread, the render loop never waits
+     * for the disk: frames are dropped when the encoder falls behind (see get_capture_stats).
+     * @param path Output directory for PNG sequences or output file for Y4M streams.
+     * @param format File format.
+     * @param fps Frame rate written in the Y4M header.
+     * @return True if the capture started.
+     */
+    bool start_capture(const std::string &path, CaptureFormat format = CaptureFormat::PNG_SEQUENCE, int fps = 60);
+
+    /**
+     * @brief Stops recording, writing the frames still queued.
+     */
+    void stop_capture();
+
+    /**
+     * @brief Returns true if the frames are being recorded.
+     */
+    bool is_capturing() const;
+
+    /**
+     * @brief Gets the captured, written and dropped frame counts and the encoder queue depth.
+     */
+    CaptureStats get_capture_stats() const;
+
+    /**
+     * @brief Starts recording the scene state of every update (poses, scales and colors of the visual objects,
+     * lines, arrows, segments and text labels) to a binary file that can be scrubbed with open_playback.
+     * @param path Path of the recording (overwritten if it exists).
+     * @param keyframe_interval Frames between two full snapshots of the objects (the frames in between only store changes).
+     * @return True if the recording started.
+     */
+    bool start_recording(const std::string &path, int keyframe_interval = 120);
+
+    /**
+     * @brief Stops recording and writes the seek index.
+     */
+    void stop_recording();
+
+    /**
+     * @brief Returns true if the scene is being recorded (false once a write failed).
+     */
+    bool is_recording() const;
+
+    /**
+     * @brief Returns true if the last recording stopped because a write failed (e.g. on a full disk).
+     * The frames written before the failure can still be played back.
+     */
+    bool has_recording_failed() const;
+
+    /**
+     * @brief Opens a scene recording for playback. While it is open, update shows the recorded frames instead of
+     * the published poses, and a timeline window allows to play, pause and seek. The scene must contain the visual
+     * objects of the recording (created in the same order, so their handles match).
+     * @param path Path of the recording.
+     * @return True if the recording could be opened.
+     */
+    bool open_playback(const std::string &path);
+
+    /**
+     * @brief Closes the playback (the objects keep the last shown state).
+     */
+    void close_playback();
+
+    /**
+     * @brief Returns true if a recording is being played back.
+     */
+    bool is_playing_back() const;
+
+    /**
+     * @brief Shows a frame of the playback.
+     * @param frame Index of the frame (clamped to the last frame).
+     */
+    void seek_playback(size_t frame);
+
+    /**
+     * @brief Pauses or resumes the playback.
+     */
+    void set_playback_paused(bool paused);
+
+    /**
+     * @brief Gets the number of frames of the playback (0 if no recording is open).
+     */
+    size_t get_playback_frame_count() const;
 };
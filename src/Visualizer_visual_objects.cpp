@@ -16,37 +16,195 @@ int Visualizer::add_visual_object(std::shared_ptr<VisualObject> vis_object)
     {
         vis_object->model.materials[0].shader = this->shaders_["light"];
     }
-    this->visual_objects_.push_back(vis_object);
 
-    return this->visual_objects_.size() - 1;
+    // Shared models have their bounds computed once by the cache
+    vis_object->local_bounds = vis_object->model_key.empty() ? du::get_model_meshes_bounding_box(vis_object->model)
+                                                             : this->model_cache_.get_bounds(vis_object->model_key);
+    vis_object->transform_dirty = true;
+    vis_object->bvh_proxy = DynamicBvh::NULL_NODE;
+    int handle = this->visual_objects_.insert(vis_object);
+    if (handle == SlotMap<std::shared_ptr<VisualObject>>::INVALID_HANDLE)
+    {
+        // Every slot is in use, the model would never be released by remove_visual_object
+        this->release_visual_object_model(*vis_object);
+        return handle;
+    }
+    this->scene_dirty_ = true;
+    return handle;
+}
+
+VisualObject *Visualizer::find_visual_object(int handle)
+{
+    std::shared_ptr<VisualObject> *vis_object = this->visual_objects_.get(handle);
+    return vis_object != nullptr ? vis_object->get() : nullptr;
+}
+
+void Visualizer::update_visual_object_position_orientation(int handle, Vector3 position, Quaternion orientation)
+{
+    VisualObject *vis_object = this->find_visual_object(handle);
+    if (vis_object == nullptr)
+    {
+        return;
+    }
+    vis_object->set_pose(position, orientation, vis_object->scale);
 }
 
-void Visualizer::update_visual_object_position_orientation(int index, Vector3 position, Quaternion orientation)
+void Visualizer::update_visual_object_position_orientation_scale(int handle, Vector3 position, Quaternion orientation, Vector3 scale)
 {
-    this->visual_objects_[index]->position = position;
-    this->visual_objects_[index]->orientation = orientation;
+    VisualObject *vis_object = this->find_visual_object(handle);
+    if (vis_object == nullptr)
+    {
+        return;
+    }
+    vis_object->set_pose(position, orientation, scale);
 }
 
-void Visualizer::update_visual_object_position_orientation_scale(int index, Vector3 position, Quaternion orientation, Vector3 scale)
+void Visualizer::update_visual_object_scale(int handle, Vector3 scale)
 {
-    this->visual_objects_[index]->position = position;
-    this->visual_objects_[index]->orientation = orientation;
-    this->visual_objects_[index]->model.transform = MatrixScale(scale.x, scale.y, scale.z);
+    VisualObject *vis_object = this->find_visual_object(handle);
+    if (vis_object == nullptr)
+    {
+        return;
+    }
+    vis_object->set_pose(vis_object->position, vis_object->orientation, scale);
 }
 
-void Visualizer::update_visual_object_scale(int index, Vector3 scale)
+void Visualizer::update_visual_objects_poses(const int *handles, const Vector3 *positions, const Quaternion *orientations, size_t count, const Vector3 *scales)
 {
-    this->visual_objects_[index]->model.transform = MatrixScale(scale.x, scale.y, scale.z);
+    for (size_t i = 0; i < count; i++)
+    {
+        VisualObject *vis_object = this->find_visual_object(handles != nullptr ? handles[i] : (int)i);
+        if (vis_object == nullptr)
+        {
+            continue;
+        }
+        vis_object->set_pose(positions[i], orientations[i], scales != nullptr ? scales[i] : vis_object->scale);
+    }
 }
 
-void Visualizer::remove_visual_object(int index)
+PoseFrame &Visualizer::begin_pose_frame()
 {
-    this->visual_objects_.erase(this->visual_objects_.begin() + index);
+    PoseFrame &frame = this->published_poses_.back();
+    frame.clear();
+    return frame;
+}
+
+void Visualizer::publish_pose_frame()
+{
+    this->published_poses_.publish();
+}
+
+void Visualizer::apply_published_poses()
+{
+    if (!this->published_poses_.update())
+    {
+        return;
+    }
+    const PoseFrame &frame = this->published_poses_.front();
+    this->update_visual_objects_poses(frame.handles.data(), frame.positions.data(), frame.orientations.data(), frame.handles.size());
+}
+
+void Visualizer::remove_visual_object(int handle)
+{
+    VisualObject *vis_object = this->find_visual_object(handle);
+    if (vis_object == nullptr)
+    {
+        return;
+    }
+    this->release_visual_object_model(*vis_object);
+    if (vis_object->static_caster)
+    {
+        this->shadow_map_.invalidate_static();
+    }
+    if (vis_object->bvh_proxy != DynamicBvh::NULL_NODE)
+    {
+        this->object_bvh_.destroy_proxy(vis_object->bvh_proxy);
+    }
+    this->visual_objects_.erase(handle);
+    this->scene_dirty_ = true;
 }
 
 void Visualizer::clear_visual_objects()
 {
+    for (auto &vis_object : this->visual_objects_)
+    {
+        this->release_visual_object_model(*vis_object);
+    }
     this->visual_objects_.clear();
+    this->object_bvh_.clear();
+    this->shadow_map_.invalidate_static();
+    this->scene_dirty_ = true;
+}
+
+void Visualizer::release_visual_object_model(const VisualObject &vis_object)
+{
+    if (!vis_object.lod_keys.empty())
+    {
+        for (const std::string &key : vis_object.lod_keys)
+        {
+            this->model_cache_.release(key);
+        }
+    }
+    else if (vis_object.model_key.empty())
+    {
+        UnloadModel(vis_object.model);
+    }
+    else
+    {
+        this->model_cache_.release(vis_object.model_key);
+    }
+}
+
+void Visualizer::refit_visual_object_bounds()
+{
+    for (size_t i = 0; i < this->visual_objects_.size(); i++)
+    {
+        VisualObject &vis_object = *this->visual_objects_.value_at(i);
+        if (!vis_object.transform_dirty)
+        {
+            continue;
+        }
+        vis_object.world_transform = vis_object.get_transform();
+        BoundingBox world_bounds = du::transform_bounding_box(vis_object.local_bounds, vis_object.world_transform);
+        vis_object.bounding_radius = 0.5f * Vector3Distance(world_bounds.min, world_bounds.max);
+        if (vis_object.static_caster)
+        {
+            this->shadow_map_.invalidate_static();
+        }
+        if (vis_object.bvh_proxy == DynamicBvh::NULL_NODE)
+        {
+            vis_object.bvh_proxy = this->object_bvh_.create_proxy(world_bounds, this->visual_objects_.handle_at(i));
+        }
+        else
+        {
+            this->object_bvh_.move_proxy(vis_object.bvh_proxy, world_bounds);
+        }
+        vis_object.transform_dirty = false;
+        this->scene_dirty_ = true;
+    }
+}
+
+void Visualizer::set_visual_object_edge_overlay(int handle, bool enabled)
+{
+    VisualObject *vis_object = this->find_visual_object(handle);
+    if (vis_object == nullptr)
+    {
+        return;
+    }
+    vis_object->edge_overlay = enabled;
+    this->scene_dirty_ = true;
+}
+
+void Visualizer::set_visual_object_static(int handle, bool is_static)
+{
+    VisualObject *vis_object = this->find_visual_object(handle);
+    if (vis_object == nullptr || vis_object->static_caster == is_static)
+    {
+        return;
+    }
+    // The object moves between the cached and the per-frame shadow map
+    vis_object->static_caster = is_static;
+    this->shadow_map_.invalidate_static();
 }
 
 void Visualizer::clear_gui_interfaces()
@@ -56,109 +214,119 @@ void Visualizer::clear_gui_interfaces()
 
 
 // Functions to draw geometric primitives
+// Primitives share a unit mesh from the model cache, their size is set through the model transform.
+Model Visualizer::acquire_primitive_lods(PrimitiveShape shape, VisualObject &vis_object)
+{
+    Model model;
+    for (int level = 0; level < ModelCache::PRIMITIVE_LOD_LEVELS; level++)
+    {
+        int rings, slices;
+        std::string key;
+        ModelCache::get_primitive_lod(shape, level, rings, slices);
+        Model level_model = this->model_cache_.acquire_primitive(shape, rings, slices, key);
+        vis_object.lod_keys.push_back(key);
+        vis_object.lod_meshes.push_back(level_model.meshes);
+        if (level == ModelCache::PRIMITIVE_DEFAULT_LOD)
+        {
+            model = level_model;
+        }
+    }
+    // Only the meshes change between levels, the materials (and shader) of the default level are kept
+    vis_object.lod_level = ModelCache::PRIMITIVE_DEFAULT_LOD;
+    vis_object.model_key = vis_object.lod_keys[ModelCache::PRIMITIVE_DEFAULT_LOD];
+    return model;
+}
+
 int Visualizer::add_box(Vector3 position, Quaternion orientation, Color color, float width, float height, float length, int group_id)
 {
-    Mesh cube_mesh = GenMeshCube(width, height, length);
-    Model cube = LoadModelFromMesh(cube_mesh);
+    std::string key;
+    Model cube = this->model_cache_.acquire_primitive(PrimitiveShape::BOX, 0, 0, key);
+    cube.transform = MatrixScale(width, height, length);
     std::shared_ptr<VisualObject> cube_vis_object = std::make_shared<VisualObject>(VisualObject{
         .position = position,
         .orientation = orientation,
         .model = cube,
         .color = color,
-        .group_id = group_id});
+        .group_id = group_id,
+        .model_key = key});
 
     return this->add_visual_object(cube_vis_object);
 }
 
 int Visualizer::add_sphere(Vector3 position, Quaternion orientation, Color color, float radius, int group_id)
 {
-    Mesh sphere_mesh = GenMeshSphere(radius, 16, 16);
-    Model sphere = LoadModelFromMesh(sphere_mesh);
     std::shared_ptr<VisualObject> sphere_vis_object = std::make_shared<VisualObject>(VisualObject{
         .position = position,
         .orientation = orientation,
-        .model = sphere,
         .color = color,
         .group_id = group_id});
+    sphere_vis_object->model = this->acquire_primitive_lods(PrimitiveShape::SPHERE, *sphere_vis_object);
+    sphere_vis_object->model.transform = MatrixScale(radius, radius, radius);
 
     return this->add_visual_object(sphere_vis_object);
 }
 
 int Visualizer::add_cylinder(Vector3 position, Quaternion orientation, Color color, float radius, float height, int group_id)
 {
-    Mesh cylinder_mesh = GenMeshCylinder(radius, height, 16);
-
-    Model cylinder = LoadModelFromMesh(cylinder_mesh);
-    cylinder.transform = MatrixMultiply(MatrixTranslate(0, -height * 0.5, 0), MatrixRotateX(PI / 2));
     std::shared_ptr<VisualObject> cylinder_vis_object = std::make_shared<VisualObject>(VisualObject{
         .position = position,
         .orientation = orientation,
-        .model = cylinder,
         .color = color,
         .group_id = group_id});
+    cylinder_vis_object->model = this->acquire_primitive_lods(PrimitiveShape::CYLINDER, *cylinder_vis_object);
+    cylinder_vis_object->model.transform = MatrixMultiply(MatrixMultiply(MatrixScale(radius, height, radius), MatrixTranslate(0, -height * 0.5, 0)), MatrixRotateX(PI / 2));
 
     return this->add_visual_object(cylinder_vis_object);
 }
 
 int Visualizer::add_cone(Vector3 position, Quaternion orientation, Color color, float radius, float height, int group_id)
 {
-    Mesh cone_mesh = GenMeshCone(radius, height, 16);
-    Model cone = LoadModelFromMesh(cone_mesh);
     std::shared_ptr<VisualObject> cone_vis_object = std::make_shared<VisualObject>(VisualObject{
         .position = position,
         .orientation = orientation,
-        .model = cone,
         .color = color,
         .group_id = group_id});
+    cone_vis_object->model = this->acquire_primitive_lods(PrimitiveShape::CONE, *cone_vis_object);
+    cone_vis_object->model.transform = MatrixScale(radius, height, radius);
 
     return this->add_visual_object(cone_vis_object);
 }
 
 int Visualizer::add_plane(Vector3 position, Quaternion orientation, Color color, float width, float length, int group_id)
 {
-    Mesh plane_mesh = GenMeshPlane(width, length, 16, 16);
-    Model plane = LoadModelFromMesh(plane_mesh);
+    std::string key;
+    Model plane = this->model_cache_.acquire_primitive(PrimitiveShape::PLANE, 16, 16, key);
+    plane.transform = MatrixScale(width, 1.0f, length);
     std::shared_ptr<VisualObject> plane_vis_object = std::make_shared<VisualObject>(VisualObject{
         .position = position,
         .orientation = orientation,
         .model = plane,
         .color = color,
-        .group_id = group_id});
-
-    if (this->shader_loaded_)
-    {
-        this->shadow_texture = LoadRenderTexture(400, 400);
-        plane_vis_object->model.materials[0].maps[RL_SHADER_LOC_MAP_ALBEDO].texture = this->shadow_texture.texture;
-    }
+        .group_id = group_id,
+        .model_key = key});
 
     return this->add_visual_object(plane_vis_object);
 }
 
 int Visualizer::add_mesh(const char *filename, Vector3 position, Quaternion orientation, Color color, float scale, int group_id)
 {
-    Model model = LoadModel(filename);
-    model.transform = MatrixScale(scale, scale, scale);
-    std::shared_ptr<VisualObject> vis_object = std::make_shared<VisualObject>(VisualObject{
-        .position = position,
-        .orientation = orientation,
-        .model = model,
-        .color = color,
-        .group_id = group_id});
-
-    return this->add_visual_object(vis_object);
+    return this->add_mesh(filename, position, orientation, color, scale, scale, scale, group_id);
 }
 
 
 int Visualizer::add_mesh(const char *filename, Vector3 position, Quaternion orientation, Color color, float scale_x, float scale_y, float scale_z, int group_id)
 {
-    Model model = LoadModel(filename);
+    // Objects using the same file share the uploaded model
+    std::string key;
+    Model model = this->model_cache_.acquire_file(filename, key);
     model.transform = MatrixScale(scale_x, scale_y, scale_z);
     std::shared_ptr<VisualObject> vis_object = std::make_shared<VisualObject>(VisualObject{
         .position = position,
         .orientation = orientation,
         .model = model,
         .color = color,
-        .group_id = group_id});
+        .group_id = group_id,
+        .model_key = key});
 
     return this->add_visual_object(vis_object);
 }
@@ -189,7 +357,10 @@ int Visualizer::add_heightmap(Vector3 position,
     int x_shift = width / 2;
     int y_shift = height / 2;
 
-    Model model = LoadModelFromMesh(mesh);
+    // Heightmaps are not shared, the cache only manages their derived meshes and unloading
+    std::string key = this->model_cache_.make_unique_key("heightmap");
+    Model model = this->model_cache_.acquire(key, [mesh]() -> Model
+                                             { return LoadModelFromMesh(mesh); });
 
     model.transform = MatrixMultiply(MatrixTranslate(-x_shift, 0, -y_shift), MatrixRotateX(PI / 2));
 
@@ -198,7 +369,113 @@ int Visualizer::add_heightmap(Vector3 position,
         .orientation = orientation,
         .model = model,
         .color = color,
-        .group_id = group_id});
+        .group_id = group_id,
+        .model_key = key});
 
     return this->add_visual_object(vis_object);
 };
+
+int Visualizer::add_terrain(Vector3 position, Quaternion orientation, Color color, size_t width, size_t depth, const std::vector<float> &heights,
+                            float x_scale, float y_scale, float z_scale, size_t tile_cells)
+{
+    const float *data = heights.size() >= width * depth ? heights.data() : nullptr;
+    std::unique_ptr<Terrain> terrain = std::make_unique<Terrain>(width, depth, data, x_scale, z_scale, y_scale, tile_cells);
+    terrain->set_pose(position, orientation);
+    terrain->set_color(color);
+    // Terrains are static shadow casters
+    this->shadow_map_.invalidate_static();
+    this->scene_dirty_ = true;
+    return this->terrains_.insert(std::move(terrain));
+}
+
+void Visualizer::update_terrain_heights(int handle, size_t x, size_t z, size_t width, size_t depth, const float *heights)
+{
+    Terrain *terrain = this->get_terrain(handle);
+    if (terrain != nullptr)
+    {
+        terrain->set_heights(x, z, width, depth, heights);
+        this->shadow_map_.invalidate_static();
+        this->scene_dirty_ = true;
+    }
+}
+
+Terrain *Visualizer::get_terrain(int handle)
+{
+    // The terrain is most likely modified through the pointer
+    this->scene_dirty_ = true;
+    std::unique_ptr<Terrain> *terrain = this->terrains_.get(handle);
+    return terrain != nullptr ? terrain->get() : nullptr;
+}
+
+void Visualizer::remove_terrain(int handle)
+{
+    std::unique_ptr<Terrain> *terrain = this->terrains_.get(handle);
+    if (terrain == nullptr)
+    {
+        return;
+    }
+    (*terrain)->unload();
+    this->terrains_.erase(handle);
+    this->shadow_map_.invalidate_static();
+    this->scene_dirty_ = true;
+}
+
+int Visualizer::add_point_cloud(size_t count)
+{
+    std::shared_ptr<PointCloud> point_cloud = std::make_shared<PointCloud>();
+    point_cloud->resize(count);
+    return this->point_clouds_.insert(point_cloud);
+}
+
+std::shared_ptr<PointCloud> Visualizer::get_point_cloud(int handle)
+{
+    std::shared_ptr<PointCloud> *point_cloud = this->point_clouds_.get(handle);
+    return point_cloud != nullptr ? *point_cloud : nullptr;
+}
+
+void Visualizer::remove_point_cloud(int handle)
+{
+    std::shared_ptr<PointCloud> *point_cloud = this->point_clouds_.get(handle);
+    if (point_cloud == nullptr)
+    {
+        return;
+    }
+    (*point_cloud)->unload();
+    this->point_clouds_.erase(handle);
+    this->scene_dirty_ = true;
+}
+
+int Visualizer::add_trail(int object_handle, Color color, float duration, size_t capacity, Vector3 offset)
+{
+    int trail_handle = this->trail_renderer_.add_trail(capacity, duration, color);
+    this->trail_sources_[trail_handle] = TrailSource{object_handle, offset};
+    return trail_handle;
+}
+
+void Visualizer::remove_trail(int trail_handle)
+{
+    this->trail_renderer_.remove_trail(trail_handle);
+    this->trail_sources_.erase(trail_handle);
+    this->scene_dirty_ = true;
+}
+
+void Visualizer::clear_trail(int trail_handle)
+{
+    this->trail_renderer_.clear_trail(trail_handle);
+    this->scene_dirty_ = true;
+}
+
+void Visualizer::sample_trails()
+{
+    float time = GetTime();
+    for (const auto &[trail_handle, source] : this->trail_sources_)
+    {
+        const VisualObject *vis_object = this->find_visual_object(source.object_handle);
+        if (vis_object == nullptr)
+        {
+            continue;
+        }
+        Vector3 point = Vector3Add(vis_object->position, Vector3RotateByQuaternion(source.offset, vis_object->orientation));
+        this->trail_renderer_.add_sample(trail_handle, point, time);
+    }
+}